@@ -0,0 +1,360 @@
+// Benchmarks of the hot paths: OBJ loading stage by stage, procedural generation, BVH build and
+// traversal, and the physical optics solve. Timings go to stderr as a table and to JSON, which
+// serves as the baseline of later runs.
+//
+//   ScatterXBench --output baseline.json
+//   ScatterXBench --baseline baseline.json          exits with 2 when a case got slower
+//
+// Options:
+//   --database <dir>        Folder with C-18A.obj, Chinook.obj, F16.obj and T-90M.obj
+//   --filter <text>         Only cases whose name contains text
+//   --repeat <count>        Timed iterations per case after one warm up run, default 5
+//   --threads <count>       Pool threads, 0 for all but one hardware thread
+//   --output <path>         JSON file, - for standard output (the default)
+//   --baseline <path>       JSON from an earlier run to compare medians against
+//   --tolerance <fraction>  Slowdown reported as a regression, default 0.1
+//   --quick                 One iteration and smaller sweeps, for checking the suite itself
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BenchmarkReport.h"
+#include "MeshGenerators.h"
+#include "Scattering.h"
+#include "ThreadPool.h"
+
+#ifndef SCATTERX_DATABASE_DIR
+#define SCATTERX_DATABASE_DIR "Database/OBJ"
+#endif
+
+struct BenchmarkOptions {
+    std::string database = SCATTERX_DATABASE_DIR;
+    std::string filter;
+    int repeat = 5;
+    unsigned threads = 0;
+    std::string output = "-";
+    std::string baseline;
+    double tolerance = 0.1;
+    bool quick = false;
+};
+
+class BenchmarkSuite {
+public:
+    explicit BenchmarkSuite(const BenchmarkOptions& options) : m_options(options) {}
+
+    bool Wanted(const std::string& name) const
+    {
+        return m_options.filter.empty() || name.find(m_options.filter) != std::string::npos;
+    }
+
+    int Repeat() const { return m_options.quick ? 1 : std::max(1, m_options.repeat); }
+
+    // Adds a case from times measured by the caller
+    void Record(const std::string& name, std::vector<double> timesMs, double work, const std::string& workUnit)
+    {
+        if (!Wanted(name) || timesMs.empty()) return;
+
+        std::sort(timesMs.begin(), timesMs.end());
+        BenchmarkResult result;
+        result.name = name;
+        result.iterations = static_cast<int>(timesMs.size());
+        result.minMs = timesMs.front();
+        result.medianMs = timesMs.size() % 2 == 1 ? timesMs[timesMs.size() / 2]
+            : 0.5 * (timesMs[timesMs.size() / 2 - 1] + timesMs[timesMs.size() / 2]);
+        result.work = work;
+        result.workUnit = workUnit;
+        result.throughput = result.medianMs > 0.0 ? work / (result.medianMs / 1000.0) : 0.0;
+        m_results.push_back(result);
+
+        std::fprintf(stderr, "%-40s %10.3f ms", name.c_str(), result.medianMs);
+        if (work > 0.0) std::fprintf(stderr, "  %12.4g %s/s", result.throughput, workUnit.c_str());
+        std::fprintf(stderr, "\n");
+    }
+
+    // Runs body once to warm up, then times Repeat() runs of it. setup runs before every
+    // iteration and is not timed.
+    void Measure(const std::string& name, double work, const std::string& workUnit,
+        const std::function<void()>& setup, const std::function<void()>& body)
+    {
+        if (!Wanted(name)) return;
+
+        std::vector<double> timesMs;
+        for (int i = -1; i < Repeat(); ++i) {
+            setup();
+            auto start = std::chrono::high_resolution_clock::now();
+            body();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            if (i >= 0) timesMs.push_back(ms);
+        }
+        Record(name, timesMs, work, workUnit);
+    }
+
+    const BenchmarkOptions& Options() const { return m_options; }
+    const std::vector<BenchmarkResult>& Results() const { return m_results; }
+
+private:
+    BenchmarkOptions m_options;
+    std::vector<BenchmarkResult> m_results;
+};
+
+// Parse, weld and triangle data of every model. The loaded meshes are kept for the later cases.
+// Models no wanted case uses are not loaded, models only the BVH and scattering cases use are
+// loaded once without timing.
+static void BenchmarkObjLoading(BenchmarkSuite& suite, const std::vector<std::string>& models, std::vector<Mesh>& meshes)
+{
+    for (const std::string& model : models) {
+        std::string prefix = "obj/" + model + "/";
+        std::string path = suite.Options().database + "/" + model + ".obj";
+
+        bool timed = suite.Wanted(prefix + "parse") || suite.Wanted(prefix + "weld") || suite.Wanted(prefix + "triangle_data");
+        bool used = suite.Wanted("bvh/" + model + "/build") || suite.Wanted("bvh/" + model + "/raycast")
+            || suite.Wanted("scattering/" + model + "/facets") || suite.Wanted("scattering/" + model + "/shadowed_edges");
+        if (!timed && !used) continue;
+
+        std::vector<double> parse, weld, triangleData;
+        Mesh mesh;
+        for (int i = -1; i < (timed ? suite.Repeat() : 0); ++i) {
+            mesh = Mesh();
+            mesh.LoadObjectModelFromDisk(path);
+            if (mesh.triangles.empty()) break;
+            if (i < 0) continue;
+            parse.push_back(mesh.lastLoadTimings.parseMs);
+            weld.push_back(mesh.lastLoadTimings.weldMs);
+            triangleData.push_back(mesh.lastLoadTimings.triangleDataMs);
+        }
+        if (mesh.triangles.empty()) {
+            std::cerr << "skipping " << model << ": could not load " << path << std::endl;
+            continue;
+        }
+
+        double triangles = static_cast<double>(mesh.triangles.size());
+        suite.Record(prefix + "parse", parse, triangles, "triangles");
+        suite.Record(prefix + "weld", weld, triangles, "triangles");
+        suite.Record(prefix + "triangle_data", triangleData, triangles, "triangles");
+        meshes.push_back(std::move(mesh));
+    }
+}
+
+static void BenchmarkGenerators(BenchmarkSuite& suite)
+{
+    const int lods[] = { 16, 64, 256 };
+    for (int LOD : lods) {
+        MeshDetail detail;
+        detail.LOD = LOD;
+        std::string suffix = "/lod" + std::to_string(LOD);
+
+        // The work is the triangle count of the generated mesh, known after the warm up run
+        auto measure = [&](const std::string& name, const std::function<void(Mesh&)>& generate) {
+            Mesh mesh;
+            generate(mesh);
+            double triangles = static_cast<double>(mesh.triangles.size());
+            suite.Measure(name, triangles, "triangles", [&]() { mesh = Mesh(); }, [&]() { generate(mesh); });
+        };
+        measure("generate/plane" + suffix, [&](Mesh& mesh) { GeneratePlaneMesh(mesh, 1, -1.0f, 1.0f, -1.0f, 1.0f, detail); });
+        measure("generate/box" + suffix, [&](Mesh& mesh) { GenerateCubeMesh(mesh, glm::vec3(0.0f), glm::vec3(1.0f), detail); });
+        measure("generate/sphere" + suffix, [&](Mesh& mesh) { GenerateSphereMesh(mesh, glm::vec3(0.0f), 1.0f, detail); });
+        measure("generate/cylinder" + suffix, [&](Mesh& mesh) { GenerateCylinderMesh(mesh, glm::vec3(0.0f), 0.5f, 1.0f, detail); });
+    }
+
+    // Facets sized for 10 GHz, what the batch runner builds for a wavelength driven job
+    MeshDetail detail;
+    detail.tessellation.wavelengthDriven = true;
+    Mesh mesh;
+    GenerateSphereMesh(mesh, glm::vec3(0.0f), 0.5f, detail);
+    suite.Measure("generate/sphere/tessellated", static_cast<double>(mesh.triangles.size()), "triangles",
+        [&]() { mesh = Mesh(); }, [&]() { GenerateSphereMesh(mesh, glm::vec3(0.0f), 0.5f, detail); });
+}
+
+static void BenchmarkBVH(BenchmarkSuite& suite, std::vector<Mesh>& meshes)
+{
+    for (Mesh& mesh : meshes) {
+        std::string prefix = "bvh/" + mesh.fileName.substr(0, mesh.fileName.find_last_of('.')) + "/";
+        double triangles = static_cast<double>(mesh.triangles.size());
+
+        suite.Measure(prefix + "build", triangles, "triangles",
+            [&]() { mesh.InvalidateBVH(); }, [&]() { mesh.GetBVH(); });
+
+        if (!suite.Wanted(prefix + "raycast")) continue;
+
+        // Rays from a sphere around the model towards random points inside its bounds,
+        // the same set every run
+        const BVH& bvh = mesh.GetBVH();
+        glm::vec3 center = 0.5f * (mesh.localBounds.min + mesh.localBounds.max);
+        glm::vec3 extent = mesh.localBounds.max - mesh.localBounds.min;
+        float radius = glm::length(extent);
+
+        int rayCount = suite.Options().quick ? 2000 : 50000;
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<glm::vec3> origins(rayCount), directions(rayCount);
+        for (int i = 0; i < rayCount; ++i) {
+            float z = 2.0f * unit(random) - 1.0f;
+            float angle = glm::two_pi<float>() * unit(random);
+            float ring = std::sqrt(std::max(0.0f, 1.0f - z * z));
+            origins[i] = center + radius * glm::vec3(ring * std::cos(angle), z, ring * std::sin(angle));
+            glm::vec3 target = mesh.localBounds.min + extent * glm::vec3(unit(random), unit(random), unit(random));
+            directions[i] = target - origins[i];
+        }
+
+        int hits = 0;
+        suite.Measure(prefix + "raycast", rayCount, "rays", []() {}, [&]() {
+            hits = 0;
+            for (int i = 0; i < rayCount; ++i) {
+                RayHit hit;
+                if (bvh.Raycast(mesh, origins[i], directions[i], hit)) ++hits;
+            }
+        });
+    }
+}
+
+// Full solves over an azimuth sweep. Every angle changes the aspect, so each solve integrates
+// all facets and the throughput is facets * angles per second.
+static void BenchmarkScattering(BenchmarkSuite& suite, std::vector<Mesh>& meshes)
+{
+    int angles = suite.Options().quick ? 2 : 8;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        std::string prefix = "scattering/" + meshes[i].fileName.substr(0, meshes[i].fileName.find_last_of('.')) + "/";
+
+        // The solver sums every visible mesh, so each model is solved on its own
+        std::vector<Mesh> scene;
+        scene.push_back(std::move(meshes[i]));
+        double work = static_cast<double>(scene[0].triangles.size()) * angles;
+
+        MaterialLibrary materials;
+        PhysicalOpticsSolver solver;
+        solver.writeContributions = false;
+
+        auto sweep = [&]() {
+            ScatteringSettings settings;
+            for (int angle = 0; angle < angles; ++angle) {
+                settings.azimuth = 360.0f * angle / angles;
+                solver.Solve(scene, materials, settings);
+            }
+        };
+
+        solver.shadowing = false;
+        solver.edgeDiffraction = false;
+        suite.Measure(prefix + "facets", work, "facets*angles", [&]() { solver.ClearCache(); }, sweep);
+
+        solver.shadowing = true;
+        solver.edgeDiffraction = true;
+        suite.Measure(prefix + "shadowed_edges", work, "facets*angles", [&]() { solver.ClearCache(); }, sweep);
+
+        meshes[i] = std::move(scene[0]);
+    }
+}
+
+static std::string CompilerName()
+{
+#if defined(_MSC_VER)
+    return "MSVC " + std::to_string(_MSC_VER);
+#elif defined(__clang__)
+    return std::string("Clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    return std::string("GCC ") + __VERSION__;
+#else
+    return "unknown";
+#endif
+}
+
+static bool ParseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string name = argv[i];
+        if (name == "--quick") {
+            options.quick = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << name << " expects a value" << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+        if (name == "--database") options.database = value;
+        else if (name == "--filter") options.filter = value;
+        else if (name == "--repeat") options.repeat = std::atoi(value.c_str());
+        else if (name == "--threads") options.threads = static_cast<unsigned>(std::atoi(value.c_str()));
+        else if (name == "--output") options.output = value;
+        else if (name == "--baseline") options.baseline = value;
+        else if (name == "--tolerance") options.tolerance = std::atof(value.c_str());
+        else {
+            std::cerr << "unknown option " << name << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        std::cerr << "Usage: ScatterXBench [--database dir] [--filter text] [--repeat n] [--threads n]\n"
+                     "                     [--output file.json] [--baseline file.json] [--tolerance 0.1] [--quick]\n";
+        return 1;
+    }
+
+    std::vector<BenchmarkResult> baseline;
+    std::string error;
+    if (!options.baseline.empty() && !LoadBenchmarkJson(options.baseline, baseline, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    ThreadPool::ConfigureGlobal(options.threads);
+
+    // Core code logs to std::cout, standard output is kept for the JSON
+    std::ostream json(std::cout.rdbuf());
+    std::streambuf* consoleBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+    BenchmarkSuite suite(options);
+    {
+        std::vector<Mesh> meshes;
+        BenchmarkObjLoading(suite, { "C-18A", "Chinook", "F16", "T-90M" }, meshes);
+        BenchmarkGenerators(suite);
+        BenchmarkBVH(suite, meshes);
+        BenchmarkScattering(suite, meshes);
+    }
+
+    BenchmarkContext context;
+    context.compiler = CompilerName();
+#ifdef NDEBUG
+    context.buildType = "Release";
+#else
+    context.buildType = "Debug";
+#endif
+    context.threads = ThreadPool::Global().GetThreadCount();
+
+    int status = 0;
+    if (options.output == "-") {
+        WriteBenchmarkJson(json, context, suite.Results());
+    }
+    else {
+        std::ofstream file(options.output);
+        if (!file) {
+            std::cerr << "cannot write " << options.output << std::endl;
+            status = 1;
+        }
+        WriteBenchmarkJson(file, context, suite.Results());
+    }
+
+    if (!baseline.empty()) {
+        std::cerr << std::endl;
+        int regressions = CompareWithBaseline(suite.Results(), baseline, options.tolerance, std::cerr);
+        if (regressions > 0) {
+            std::cerr << regressions << " case(s) more than " << options.tolerance * 100.0 << "% slower than the baseline" << std::endl;
+            if (status == 0) status = 2;
+        }
+    }
+
+    json.flush();
+    std::cout.rdbuf(consoleBuffer);
+    return status;
+}
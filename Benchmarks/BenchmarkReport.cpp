@@ -0,0 +1,214 @@
+#include "BenchmarkReport.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+static std::string EscapeJson(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+void WriteBenchmarkJson(std::ostream& out, const BenchmarkContext& context, const std::vector<BenchmarkResult>& results)
+{
+    out << std::setprecision(6);
+    out << "{\n";
+    out << "  \"context\": {\n";
+    out << "    \"compiler\": \"" << EscapeJson(context.compiler) << "\",\n";
+    out << "    \"build_type\": \"" << EscapeJson(context.buildType) << "\",\n";
+    out << "    \"threads\": " << context.threads << "\n";
+    out << "  },\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    { \"name\": \"" << EscapeJson(result.name) << "\""
+            << ", \"iterations\": " << result.iterations
+            << ", \"min_ms\": " << result.minMs
+            << ", \"median_ms\": " << result.medianMs;
+        if (result.work > 0.0) {
+            out << ", \"work\": " << result.work
+                << ", \"work_unit\": \"" << EscapeJson(result.workUnit) << "\""
+                << ", \"throughput\": " << result.throughput;
+        }
+        out << " }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// Just enough JSON to read back what WriteBenchmarkJson writes: objects, arrays, strings and
+// numbers. pos is advanced past whatever was read.
+
+static void SkipSpace(const std::string& text, size_t& pos)
+{
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+}
+
+static bool Consume(const std::string& text, size_t& pos, char c)
+{
+    SkipSpace(text, pos);
+    if (pos >= text.size() || text[pos] != c) return false;
+    ++pos;
+    return true;
+}
+
+static bool ReadString(const std::string& text, size_t& pos, std::string& value)
+{
+    if (!Consume(text, pos, '"')) return false;
+    value.clear();
+    while (pos < text.size() && text[pos] != '"') {
+        if (text[pos] == '\\' && pos + 1 < text.size()) ++pos;
+        value += text[pos++];
+    }
+    return Consume(text, pos, '"');
+}
+
+static bool ReadNumber(const std::string& text, size_t& pos, double& value)
+{
+    SkipSpace(text, pos);
+    char* end = nullptr;
+    value = std::strtod(text.c_str() + pos, &end);
+    if (end == text.c_str() + pos) return false;
+    pos = end - text.c_str();
+    return true;
+}
+
+static bool SkipValue(const std::string& text, size_t& pos)
+{
+    SkipSpace(text, pos);
+    if (pos >= text.size()) return false;
+
+    std::string word;
+    double number;
+    char c = text[pos];
+    if (c == '"') return ReadString(text, pos, word);
+    if (c == '{' || c == '[') {
+        char close = c == '{' ? '}' : ']';
+        ++pos;
+        if (Consume(text, pos, close)) return true;
+        do {
+            if (c == '{' && (!ReadString(text, pos, word) || !Consume(text, pos, ':'))) return false;
+            if (!SkipValue(text, pos)) return false;
+        } while (Consume(text, pos, ','));
+        return Consume(text, pos, close);
+    }
+    if (text.compare(pos, 4, "true") == 0 || text.compare(pos, 4, "null") == 0) {
+        pos += 4;
+        return true;
+    }
+    if (text.compare(pos, 5, "false") == 0) {
+        pos += 5;
+        return true;
+    }
+    return ReadNumber(text, pos, number);
+}
+
+static bool ReadResult(const std::string& text, size_t& pos, BenchmarkResult& result)
+{
+    if (!Consume(text, pos, '{')) return false;
+    if (Consume(text, pos, '}')) return true;
+    do {
+        std::string key;
+        if (!ReadString(text, pos, key) || !Consume(text, pos, ':')) return false;
+
+        double number = 0.0;
+        bool ok = true;
+        if (key == "name") ok = ReadString(text, pos, result.name);
+        else if (key == "work_unit") ok = ReadString(text, pos, result.workUnit);
+        else if (key == "iterations") { ok = ReadNumber(text, pos, number); result.iterations = static_cast<int>(number); }
+        else if (key == "min_ms") ok = ReadNumber(text, pos, result.minMs);
+        else if (key == "median_ms") ok = ReadNumber(text, pos, result.medianMs);
+        else if (key == "work") ok = ReadNumber(text, pos, result.work);
+        else if (key == "throughput") ok = ReadNumber(text, pos, result.throughput);
+        else ok = SkipValue(text, pos);
+        if (!ok) return false;
+    } while (Consume(text, pos, ','));
+    return Consume(text, pos, '}');
+}
+
+bool LoadBenchmarkJson(const std::string& path, std::vector<BenchmarkResult>& results, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    results.clear();
+    size_t pos = 0;
+    if (!Consume(text, pos, '{')) {
+        error = path + ": not a JSON object";
+        return false;
+    }
+    bool foundResults = false;
+    do {
+        std::string key;
+        if (!ReadString(text, pos, key) || !Consume(text, pos, ':')) break;
+        if (key != "results") {
+            if (!SkipValue(text, pos)) break;
+            continue;
+        }
+
+        foundResults = true;
+        if (!Consume(text, pos, '[')) break;
+        if (Consume(text, pos, ']')) continue;
+        do {
+            BenchmarkResult result;
+            if (!ReadResult(text, pos, result)) {
+                error = path + ": malformed result near offset " + std::to_string(pos);
+                return false;
+            }
+            results.push_back(result);
+        } while (Consume(text, pos, ','));
+        if (!Consume(text, pos, ']')) break;
+    } while (Consume(text, pos, ','));
+
+    if (!foundResults || !Consume(text, pos, '}')) {
+        error = path + ": malformed benchmark file near offset " + std::to_string(pos);
+        return false;
+    }
+    return true;
+}
+
+int CompareWithBaseline(const std::vector<BenchmarkResult>& results, const std::vector<BenchmarkResult>& baseline,
+    double tolerance, std::ostream& out)
+{
+    int regressions = 0;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-40s %12s %12s %9s\n", "case", "baseline ms", "current ms", "change");
+    out << line;
+
+    for (const BenchmarkResult& result : results) {
+        const BenchmarkResult* reference = nullptr;
+        for (const BenchmarkResult& candidate : baseline) {
+            if (candidate.name == result.name) {
+                reference = &candidate;
+                break;
+            }
+        }
+        if (!reference || reference->medianMs <= 0.0) {
+            std::snprintf(line, sizeof(line), "%-40s %12s %12.3f %9s\n", result.name.c_str(), "-", result.medianMs, "new");
+            out << line;
+            continue;
+        }
+
+        double change = result.medianMs / reference->medianMs - 1.0;
+        bool regressed = change > tolerance;
+        if (regressed) ++regressions;
+        std::snprintf(line, sizeof(line), "%-40s %12.3f %12.3f %+8.1f%%%s\n", result.name.c_str(),
+            reference->medianMs, result.medianMs, change * 100.0, regressed ? "  REGRESSION" : "");
+        out << line;
+    }
+    return regressions;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Timing of one benchmark case over all its repetitions
+struct BenchmarkResult {
+    std::string name;              // Slash separated, e.g. "obj/F16/weld"
+    int iterations = 0;
+    double minMs = 0.0;
+    double medianMs = 0.0;         // What baselines are compared on, steadier than the mean
+    double work = 0.0;             // Units processed per iteration, 0 when the case has no throughput
+    std::string workUnit;          // e.g. "triangles", "rays", "facets*angles"
+    double throughput = 0.0;       // work per second at the median time
+};
+
+// Machine and build the results were taken on, written next to them so baselines from
+// another machine are easy to spot
+struct BenchmarkContext {
+    std::string compiler;
+    std::string buildType;
+    unsigned threads = 0;
+};
+
+// Writes {"context": {...}, "results": [{...}, ...]}
+void WriteBenchmarkJson(std::ostream& out, const BenchmarkContext& context, const std::vector<BenchmarkResult>& results);
+
+// Reads the results back from a file written by WriteBenchmarkJson
+bool LoadBenchmarkJson(const std::string& path, std::vector<BenchmarkResult>& results, std::string& error);
+
+// Prints every case found in both sets and returns how many got slower than the baseline
+// median by more than tolerance (0.1 = 10%)
+int CompareWithBaseline(const std::vector<BenchmarkResult>& results, const std::vector<BenchmarkResult>& baseline,
+    double tolerance, std::ostream& out);
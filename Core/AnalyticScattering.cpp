@@ -0,0 +1,266 @@
+#include "AnalyticScattering.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static constexpr double kPi = 3.14159265358979323846;
+static constexpr double kSpeedOfLight = 299792458.0;
+
+// Radar, wavelength and material shared by every term
+struct Illumination {
+    glm::dvec3 toRadar, horizontal, vertical, polarization;
+    double wavenumber;
+    double amplitude;                   // 2 sqrt(pi) / lambda, as in PhysicalOpticsSolver
+    std::complex<double> reflection;
+
+    // exp(j 2k r.i), round trip phase of a point relative to the origin
+    std::complex<double> Phase(const glm::dvec3& point) const
+    {
+        return std::polar(1.0, 2.0 * wavenumber * glm::dot(toRadar, point));
+    }
+};
+
+static double Sinc(double x)
+{
+    return std::abs(x) < 1e-8 ? 1.0 : std::sin(x) / x;
+}
+
+// Lighting factor of a flat face, 0 when a closed body shows its back to the radar
+static double FaceCosine(const Illumination& light, const glm::dvec3& normal, bool twoSided)
+{
+    double cosine = glm::dot(normal, light.toRadar);
+    return twoSided ? std::abs(cosine) : std::max(cosine, 0.0);
+}
+
+// Rectangle of sides a along u and b along v around centre
+static std::complex<double> Rectangle(const Illumination& light, const glm::dvec3& centre, const glm::dvec3& normal,
+    const glm::dvec3& u, double a, const glm::dvec3& v, double b, bool twoSided)
+{
+    double cosine = FaceCosine(light, normal, twoSided);
+    if (cosine <= 0.0) return 0.0;
+
+    double k = light.wavenumber;
+    double integral = a * b * Sinc(k * a * glm::dot(light.toRadar, u)) * Sinc(k * b * glm::dot(light.toRadar, v));
+    return -light.reflection * light.amplitude * cosine * integral * light.Phase(centre);
+}
+
+static std::complex<double> Triangle(const Illumination& light, const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c, bool twoSided)
+{
+    double cosine = FaceCosine(light, glm::normalize(glm::cross(b - a, c - a)), twoSided);
+    if (cosine <= 0.0) return 0.0;
+    return -light.reflection * light.amplitude * cosine * FacetIntegral(a, b, c, 2.0 * light.wavenumber * light.toRadar);
+}
+
+// Circular disk, the integral of exp(j w.r) over it is the Airy pattern pi a^2 2 J1(x) / x
+static std::complex<double> Disk(const Illumination& light, const glm::dvec3& centre, const glm::dvec3& normal, double radius, bool twoSided)
+{
+    double cosine = FaceCosine(light, normal, twoSided);
+    if (cosine <= 0.0) return 0.0;
+
+    double sine = std::sqrt(std::max(0.0, 1.0 - cosine * cosine));
+    double x = 2.0 * light.wavenumber * radius * sine;
+    double airy = x < 1e-6 ? 1.0 : 2.0 * std::cyl_bessel_j(1.0, x) / x;
+    return -light.reflection * light.amplitude * cosine * kPi * radius * radius * airy * light.Phase(centre);
+}
+
+// Physical optics over the lit hemisphere. With u = cos(incidence) the surface element is
+// 2 pi a^2 du and the integral of u exp(j beta u) over [0, 1] has a closed form.
+static std::complex<double> Sphere(const Illumination& light, const glm::dvec3& centre, double radius)
+{
+    double beta = 2.0 * light.wavenumber * radius;
+    std::complex<double> integral;
+    if (beta < 1e-3) {
+        integral = std::complex<double>(0.5, beta / 3.0);
+    }
+    else {
+        const std::complex<double> j(0.0, 1.0);
+        integral = std::polar(1.0, beta) * (1.0 / (j * beta) + 1.0 / (beta * beta)) - 1.0 / (beta * beta);
+    }
+    return -light.reflection * light.amplitude * 2.0 * kPi * radius * radius * integral * light.Phase(centre);
+}
+
+// Curved side by stationary phase around the specular line, RCS k a L^2 cos(psi) sinc^2(k L sin(psi))
+// with psi the angle off broadside. The cap facing the radar is added as a disk.
+static std::complex<double> Cylinder(const Illumination& light, const glm::dvec3& centre, const glm::dvec3& axis, double radius, double height)
+{
+    std::complex<double> field = 0.0;
+
+    double sinPsi = glm::dot(light.toRadar, axis);
+    double cosPsi = std::sqrt(std::max(0.0, 1.0 - sinPsi * sinPsi));
+    double k = light.wavenumber;
+    if (cosPsi > 1e-9) {
+        double magnitude = height * std::sqrt(k * radius * cosPsi) * Sinc(k * height * sinPsi);
+        double phase = 2.0 * k * radius * cosPsi - 0.25 * kPi;
+        field += -light.reflection * magnitude * std::polar(1.0, phase) * light.Phase(centre);
+    }
+
+    field += Disk(light, centre + 0.5 * height * axis, axis, radius, false);
+    field += Disk(light, centre - 0.5 * height * axis, -axis, radius, false);
+    return field;
+}
+
+static double PolygonArea(const std::vector<glm::dvec2>& polygon)
+{
+    double area = 0.0;
+    for (size_t i = 0; i < polygon.size(); ++i) {
+        const glm::dvec2& a = polygon[i];
+        const glm::dvec2& b = polygon[(i + 1) % polygon.size()];
+        area += a.x * b.y - a.y * b.x;
+    }
+    return 0.5 * std::abs(area);
+}
+
+// Sutherland-Hodgman clip of a convex polygon by a counter clockwise convex polygon
+static std::vector<glm::dvec2> ClipConvex(std::vector<glm::dvec2> subject, const std::vector<glm::dvec2>& clip)
+{
+    for (size_t i = 0; i < clip.size() && !subject.empty(); ++i) {
+        glm::dvec2 a = clip[i];
+        glm::dvec2 b = clip[(i + 1) % clip.size()];
+        auto inside = [&](const glm::dvec2& p) { return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x) >= 0.0; };
+
+        std::vector<glm::dvec2> output;
+        for (size_t j = 0; j < subject.size(); ++j) {
+            glm::dvec2 current = subject[j];
+            glm::dvec2 previous = subject[(j + subject.size() - 1) % subject.size()];
+            bool currentInside = inside(current);
+            bool previousInside = inside(previous);
+            if (currentInside != previousInside) {
+                glm::dvec2 edge = current - previous;
+                double denominator = (b.x - a.x) * edge.y - (b.y - a.y) * edge.x;
+                double t = ((b.y - a.y) * (previous.x - a.x) - (b.x - a.x) * (previous.y - a.y)) / denominator;
+                output.push_back(previous + t * edge);
+            }
+            if (currentInside) output.push_back(current);
+        }
+        subject = std::move(output);
+    }
+    return subject;
+}
+
+// Geometric optics triple bounce. A ray entering the aperture at x leaves through its point
+// reflection about the corner, so the effective area is the overlap of the projected aperture
+// with that reflection. Every triple bounce path has the length of the path through the corner.
+static std::complex<double> TrihedralCorner(const Illumination& light, const glm::dvec3& corner, const glm::dvec3 edges[3], double length)
+{
+    for (int i = 0; i < 3; ++i) {
+        if (glm::dot(light.toRadar, edges[i]) <= 0.0) return 0.0;  // Radar outside the octant
+    }
+
+    auto project = [&](const glm::dvec3& point) {
+        return glm::dvec2(glm::dot(point, light.horizontal), glm::dot(point, light.vertical));
+    };
+    glm::dvec2 centre = project(corner);
+    std::vector<glm::dvec2> aperture = { project(corner + length * edges[0]), project(corner + length * edges[1]), project(corner + length * edges[2]) };
+
+    // Counter clockwise for the clipper
+    glm::dvec2 e1 = aperture[1] - aperture[0], e2 = aperture[2] - aperture[0];
+    if (e1.x * e2.y - e1.y * e2.x < 0.0) std::swap(aperture[1], aperture[2]);
+
+    std::vector<glm::dvec2> image;
+    for (const glm::dvec2& point : aperture) {
+        image.push_back(2.0 * centre - point);
+    }
+    double area = PolygonArea(ClipConvex(aperture, image));
+
+    // Three reflections scale the incident field by -R^3, which the solver convention negates like the -R of a facet
+    return light.reflection * light.reflection * light.reflection * light.amplitude * area * light.Phase(corner);
+}
+
+// Double bounce between two perpendicular plates. In the plane across the fold the pair retro
+// reflects over a width of 2 b sin(phi), phi measured from the nearer plate. Along the fold it
+// behaves like a plate of length a.
+static std::complex<double> DihedralCorner(const Illumination& light, const glm::dvec3& corner, const glm::dvec3& fold,
+    const glm::dvec3& plate1, const glm::dvec3& plate2, double foldLength, double plateWidth)
+{
+    double x1 = glm::dot(light.toRadar, plate1);
+    double x2 = glm::dot(light.toRadar, plate2);
+    if (x1 <= 0.0 || x2 <= 0.0) return 0.0;  // Radar outside the wedge
+
+    double sinPsi = glm::dot(light.toRadar, fold);
+    double cosPsi = std::sqrt(std::max(0.0, 1.0 - sinPsi * sinPsi));
+    double phi = std::atan2(x2, x1);
+    phi = std::min(phi, 0.5 * kPi - phi);
+
+    double area = 2.0 * plateWidth * std::sin(phi) * foldLength * cosPsi * Sinc(light.wavenumber * foldLength * sinPsi);
+
+    // Two reflections scale E along the fold by R^2 and E across it by -R^2
+    double alongFold = glm::dot(light.polarization, fold);
+    double polarization = 2.0 * alongFold * alongFold - 1.0;
+
+    return -light.reflection * light.reflection * polarization * light.amplitude * area * light.Phase(corner + 0.5 * foldLength * fold);
+}
+
+
+bool EvaluatePrimitive(const PrimitiveShape& shape, const glm::mat4& modelMatrix, std::complex<double> reflection,
+    const ScatteringSettings& settings, AnalyticField& field)
+{
+    field = AnalyticField();
+    if (shape.type == PrimitiveType::None) return false;
+
+    // Rotation, translation and uniform scale keep the shape, anything else distorts it
+    glm::dmat4 model(modelMatrix);
+    glm::dmat3 linear(model);
+    double scale = glm::length(linear[0]);
+    for (int i = 0; i < 3; ++i) {
+        if (std::abs(glm::length(linear[i]) - scale) > 1e-4 * scale) return false;
+        if (std::abs(glm::dot(linear[i], linear[(i + 1) % 3])) > 1e-4 * scale * scale) return false;
+    }
+    if (scale <= 0.0) return false;
+
+    glm::dvec3 origin = glm::dvec3(model * glm::dvec4(glm::dvec3(shape.origin), 1.0));
+    glm::dvec3 axes[3];
+    for (int i = 0; i < 3; ++i) {
+        axes[i] = glm::normalize(linear * glm::dvec3(shape.axes[i]));
+    }
+    glm::dvec3 size = scale * glm::dvec3(shape.size);
+
+    Illumination light;
+    RadarFrame(settings, light.toRadar, light.horizontal, light.vertical);
+    light.polarization = (settings.polarization == Polarization::HH) ? light.horizontal : light.vertical;
+    double wavelength = kSpeedOfLight / settings.frequency;
+    light.wavenumber = 2.0 * kPi / wavelength;
+    light.amplitude = 2.0 * std::sqrt(kPi) / wavelength;
+    light.reflection = reflection;
+
+    switch (shape.type) {
+    case PrimitiveType::Plate:
+        field.singleBounce = Rectangle(light, origin, glm::normalize(glm::cross(axes[0], axes[1])), axes[0], size.x, axes[1], size.y, true);
+        break;
+    case PrimitiveType::Box:
+        for (int i = 0; i < 3; ++i) {
+            const glm::dvec3& u = axes[(i + 1) % 3];
+            const glm::dvec3& v = axes[(i + 2) % 3];
+            for (double side : { -1.0, 1.0 }) {
+                field.singleBounce += Rectangle(light, origin + side * 0.5 * size[i] * axes[i], side * axes[i],
+                    u, size[(i + 1) % 3], v, size[(i + 2) % 3], false);
+            }
+        }
+        break;
+    case PrimitiveType::Sphere:
+        field.singleBounce = Sphere(light, origin, size.x);
+        break;
+    case PrimitiveType::Cylinder:
+        field.singleBounce = Cylinder(light, origin, axes[1], size.x, size.y);
+        break;
+    case PrimitiveType::Disk:
+        field.singleBounce = Disk(light, origin, axes[2], size.x, true);
+        break;
+    case PrimitiveType::Trihedral:
+        for (int i = 0; i < 3; ++i) {
+            field.singleBounce += Triangle(light, origin, origin + size.x * axes[i], origin + size.x * axes[(i + 1) % 3], true);
+        }
+        field.multiBounce = TrihedralCorner(light, origin, axes, size.x);
+        break;
+    case PrimitiveType::Dihedral:
+        for (int i = 1; i <= 2; ++i) {
+            glm::dvec3 centre = origin + 0.5 * size.x * axes[0] + 0.5 * size.y * axes[i];
+            field.singleBounce += Rectangle(light, centre, glm::normalize(glm::cross(axes[0], axes[i])), axes[0], size.x, axes[i], size.y, true);
+        }
+        field.multiBounce = DihedralCorner(light, origin, axes[0], axes[1], axes[2], size.x, size.y);
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <complex>
+#include <glm/glm.hpp>
+
+#include "Primitive.h"
+#include "Scattering.h"
+
+// Scattered field of a primitive in the convention of PhysicalOpticsSolver: sqrt(RCS) in metres,
+// phase referenced to the world origin, summed coherently with facet results.
+struct AnalyticField {
+    std::complex<double> singleBounce = 0.0;  // Physical optics, what the facet solver integrates
+    std::complex<double> multiBounce = 0.0;   // Double and triple bounces of corner reflectors
+};
+
+// Evaluates a primitive in O(1) from its closed form or asymptotic expression:
+//   plates, boxes, dihedral and trihedral faces   exact physical optics of the flat faces
+//   spheres                                       exact physical optics of the lit hemisphere
+//   disks                                         Airy pattern, 2 J1(x) / x
+//   cylinders                                     stationary phase along the side plus the lit cap
+//   dihedral and trihedral corners                effective area of the multiple bounce aperture
+// Plates, disks and reflector faces are thin and lit from either side, boxes, spheres and
+// cylinders are closed. reflection is the normal incidence coefficient of the shared material,
+// -1 for a perfect conductor.
+//
+// Returns false for PrimitiveType::None and for transforms that shear or scale unevenly,
+// since those no longer describe the same shape.
+bool EvaluatePrimitive(const PrimitiveShape& shape, const glm::mat4& modelMatrix, std::complex<double> reflection,
+    const ScatteringSettings& settings, AnalyticField& field);
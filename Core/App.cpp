@@ -11,6 +11,29 @@ Application::~Application() {
     Shutdown();
 }
 
+// ImGui allocations with a size header in front, so frees know how much to give back.
+// The header is 16 bytes to keep the returned block as aligned as malloc's.
+static constexpr size_t kImGuiAllocationHeader = 16;
+
+static void* TrackedImGuiAlloc(size_t size, void*)
+{
+    char* block = static_cast<char*>(malloc(size + kImGuiAllocationHeader));
+    if (!block) return nullptr;
+    std::memcpy(block, &size, sizeof(size));
+    MemoryTracker::Add(MemoryCategory::UI, size);
+    return block + kImGuiAllocationHeader;
+}
+
+static void TrackedImGuiFree(void* pointer, void*)
+{
+    if (!pointer) return;
+    char* block = static_cast<char*>(pointer) - kImGuiAllocationHeader;
+    size_t size;
+    std::memcpy(&size, block, sizeof(size));
+    MemoryTracker::Remove(MemoryCategory::UI, size);
+    free(block);
+}
+
 GLuint Application::LoadTextureFromFile(const char* filename, int* out_width, int* out_height) {
     int width, height, channels;
     unsigned char* data = stbi_load(filename, &width, &height, &channels, 4);
@@ -34,6 +57,7 @@ GLuint Application::LoadTextureFromFile(const char* filename, int* out_width, in
     // - type: GL_UNSIGNED_BYTE (data is 8-bit per channel)
     // - data: pointer to image pixel data
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    m_iconMemory.Set(m_iconMemory.GetBytes() + static_cast<uint64_t>(width) * height * 4);
     
     // Set texture filtering options
     // GL_LINEAR: smooth interpolation for scaling
@@ -103,7 +127,8 @@ void Application::drawDisplayModePanel()
     ImVec2 windowPos(10, 200); // Between the other two panels
     ImGui::SetNextWindowPos(windowPos, ImGuiCond_FirstUseEver);
 
-    ImVec2 windowSize(300, 120);
+    // Grow the panel while the heat map settings are shown
+    ImVec2 windowSize(300, renderer->isHeatMapMode ? 200.0f : 120.0f);
     ImGui::SetNextWindowSize(windowSize, ImGuiCond_Always);
 
     ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoResize;
@@ -121,8 +146,9 @@ void Application::drawDisplayModePanel()
 
     ImGui::Begin("Display Mode", nullptr, windowFlags);
 
-    bool isWireframe = renderer->isWireframeMode;
-    bool isTextured = !isWireframe;
+    bool isHeatMap = renderer->isHeatMapMode;
+    bool isWireframe = renderer->isWireframeMode && !isHeatMap;
+    bool isTextured = !isWireframe && !isHeatMap;
 
     ImGui::Text("Rendering Options:");
 
@@ -131,6 +157,7 @@ void Application::drawDisplayModePanel()
     if (ImGui::Checkbox("Wireframe", &isWireframe))
     {
         renderer->isWireframeMode = true;
+        renderer->isHeatMapMode = false;
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
     ImGui::PopID();
@@ -141,16 +168,264 @@ void Application::drawDisplayModePanel()
     if (ImGui::Checkbox("Textured", &isTextured))
     {
         renderer->isWireframeMode = false;
+        renderer->isHeatMapMode = false;
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+    ImGui::PopID();
+
+    ImGui::SameLine();
+
+    ImGui::PushID("HeatMap");
+    if (ImGui::Checkbox("Heat Map", &isHeatMap))
+    {
+        renderer->isWireframeMode = false;
+        renderer->isHeatMapMode = true;
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     }
     ImGui::PopID();
 
+    if (renderer->isHeatMapMode)
+    {
+        ImGui::Separator();
+
+        // Quantity shown per triangle
+        const char* sources[] = { "Material Reflectivity", "RCS Contribution" };
+        int sourceIndex = static_cast<int>(renderer->heatMapSource);
+        if (ImGui::Combo("Source", &sourceIndex, sources, IM_ARRAYSIZE(sources)))
+        {
+            renderer->heatMapSource = static_cast<HeatMapSource>(sourceIndex);
+
+            // Sensible default range for each quantity
+            if (renderer->heatMapSource == HeatMapSource::Reflectivity) {
+                renderer->heatMapLogScale = false;
+                renderer->heatMapRange = glm::vec2(0.0f, 1.0f);
+            }
+            else {
+                renderer->heatMapLogScale = true;
+                renderer->heatMapRange = glm::vec2(-60.0f, 0.0f);
+            }
+        }
+
+        ImGui::Checkbox("Log Scale (dB)", &renderer->heatMapLogScale);
+        ImGui::DragFloatRange2("Range", &renderer->heatMapRange.x, &renderer->heatMapRange.y, 0.01f);
+    }
+
     ImGui::End();
 
     // Pop all 7 styles
     ImGui::PopStyleColor(7);
 }
 
+void Application::handleSelectionInput()
+{
+    LeftMousePicker& leftMouse = renderer->m_InputManager.m_leftMouseButton;
+
+    // Shift adds to the selection, Alt removes from it
+    SelectionMode mode = static_cast<SelectionMode>(m_selectionMode);
+    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) mode = SelectionMode::Add;
+    if (glfwGetKey(window, GLFW_KEY_LEFT_ALT) == GLFW_PRESS) mode = SelectionMode::Subtract;
+
+    // Clicks on ImGui windows never reach the scene
+    if (leftMouse.ClickPending) {
+        leftMouse.ClickPending = false;
+        if (!ImGui::GetIO().WantCaptureMouse) {
+            if (m_selectionTool == SelectionTool::Pick) {
+                renderer->pick(leftMouse.x, leftMouse.y, mode);
+            }
+            else if (m_selectionTool == SelectionTool::Paint) {
+                m_painting = true;
+                m_hasLastDab = false;
+            }
+            else {
+                m_selectionDragging = true;
+                m_selectionPoints.assign(1, glm::vec2(leftMouse.x, leftMouse.y));
+            }
+        }
+    }
+
+    if (m_selectionTool == SelectionTool::Paint) {
+        handlePaintInput();
+        return;
+    }
+
+    if (!m_selectionDragging) return;
+
+    double cursorX, cursorY;
+    glfwGetCursorPos(window, &cursorX, &cursorY);
+    glm::vec2 cursor(static_cast<float>(cursorX), static_cast<float>(cursorY));
+
+    if (m_selectionTool == SelectionTool::Box) {
+        // First point is the anchor, second follows the cursor
+        m_selectionPoints.resize(2);
+        m_selectionPoints[1] = cursor;
+    }
+    else if (glm::length(cursor - m_selectionPoints.back()) >= 3.0f) {
+        // Lasso outline, skip tiny steps to keep the polygon short
+        m_selectionPoints.push_back(cursor);
+    }
+
+    // Select on release
+    if (!leftMouse.IsPressed) {
+        if (m_selectionTool == SelectionTool::Box) {
+            m_lastSelectionCount = renderer->selectInRectangle(m_selectionPoints[0], m_selectionPoints[1], mode);
+        }
+        else {
+            m_lastSelectionCount = renderer->selectInLasso(m_selectionPoints, mode);
+        }
+        m_selectionDragging = false;
+        m_selectionPoints.clear();
+    }
+}
+
+void Application::handlePaintInput()
+{
+    LeftMousePicker& leftMouse = renderer->m_InputManager.m_leftMouseButton;
+    if (!leftMouse.IsPressed) m_painting = false;
+
+    // The brush outline follows the surface, so trace every frame even when not painting
+    m_brushHit = RayHit();
+    if (ImGui::GetIO().WantCaptureMouse) return;
+
+    double cursorX, cursorY;
+    glfwGetCursorPos(window, &cursorX, &cursorY);
+    if (!renderer->raycast(static_cast<int>(cursorX), static_cast<int>(cursorY), m_brushHit)) {
+        m_brushHit = RayHit();
+        return;
+    }
+
+    if (!m_painting) return;
+
+    // Space the dabs a quarter radius apart, repainting the same spot every frame changes nothing
+    if (m_hasLastDab && glm::length(m_brushHit.point - m_lastDab) < m_brushRadius * 0.25f) return;
+
+    renderer->paintMaterial(m_brushHit.point, m_brushRadius, static_cast<MaterialID>(m_brushMaterial));
+    m_lastDab = m_brushHit.point;
+    m_hasLastDab = true;
+}
+
+void Application::drawSelectionOverlay()
+{
+    if (m_selectionTool == SelectionTool::Paint && m_brushHit.meshIndex >= 0) {
+        // Brush radius projected at the depth of the surface under the cursor
+        const Camera& camera = renderer->camera;
+        float depth = glm::dot(m_brushHit.point - camera.Position, glm::normalize(camera.Orientation));
+        if (depth <= 0.0f) return;
+
+        int width, height;
+        glfwGetWindowSize(window, &width, &height);
+        float pixelRadius = m_brushRadius * 0.5f * height / (depth * std::tan(glm::radians(camera.fov) * 0.5f));
+
+        double cursorX, cursorY;
+        glfwGetCursorPos(window, &cursorX, &cursorY);
+        ImDrawList* drawList = ImGui::GetForegroundDrawList();
+        ImVec2 cursor(static_cast<float>(cursorX), static_cast<float>(cursorY));
+        drawList->AddCircle(cursor, pixelRadius, IM_COL32(255, 255, 0, 255), 48, 1.5f);
+        drawList->AddCircleFilled(cursor, 2.0f, IM_COL32(255, 255, 0, 255));
+        return;
+    }
+
+    if (!m_selectionDragging || m_selectionPoints.empty()) return;
+
+    ImDrawList* drawList = ImGui::GetForegroundDrawList();
+    ImU32 outlineColor = IM_COL32(0, 255, 0, 255);
+    ImU32 fillColor = IM_COL32(0, 255, 0, 40);
+
+    if (m_selectionTool == SelectionTool::Box && m_selectionPoints.size() == 2) {
+        ImVec2 corner0(m_selectionPoints[0].x, m_selectionPoints[0].y);
+        ImVec2 corner1(m_selectionPoints[1].x, m_selectionPoints[1].y);
+        drawList->AddRectFilled(corner0, corner1, fillColor);
+        drawList->AddRect(corner0, corner1, outlineColor);
+    }
+    else if (m_selectionTool == SelectionTool::Lasso) {
+        std::vector<ImVec2> outline;
+        outline.reserve(m_selectionPoints.size());
+        for (const auto& point : m_selectionPoints) {
+            outline.emplace_back(point.x, point.y);
+        }
+        drawList->AddPolyline(outline.data(), static_cast<int>(outline.size()), outlineColor, ImDrawFlags_Closed, 1.5f);
+    }
+}
+
+void Application::drawSelectionToolsPanel()
+{
+    ImVec2 windowPos(10, 560);
+    ImGui::SetNextWindowPos(windowPos, ImGuiCond_FirstUseEver);
+
+    ImVec2 windowSize(300, 300);
+    ImGui::SetNextWindowSize(windowSize, ImGuiCond_Always);
+
+    ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoResize;
+
+    // Apply window color styling
+    ImGui::PushStyleColor(ImGuiCol_TitleBgActive, ImVec4(0.1f, 0.1f, 0.1f, 1.0f));
+    ImGui::PushStyleColor(ImGuiCol_TitleBg, ImVec4(0.1f, 0.1f, 0.1f, 1.0f));
+    ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.2f, 0.2f, 0.2f, 1.0f));
+    ImGui::PushStyleColor(ImGuiCol_CheckMark, ImVec4(1.0f, 1.0f, 1.0f, 1.0f));
+    ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.15f, 0.15f, 0.15f, 1.0f));
+
+    ImGui::Begin("Selection Tools", nullptr, windowFlags);
+
+    // Tool used by the left mouse button
+    int tool = static_cast<int>(m_selectionTool);
+    ImGui::RadioButton("Pick", &tool, static_cast<int>(SelectionTool::Pick));
+    ImGui::SameLine();
+    ImGui::RadioButton("Box", &tool, static_cast<int>(SelectionTool::Box));
+    ImGui::SameLine();
+    ImGui::RadioButton("Lasso", &tool, static_cast<int>(SelectionTool::Lasso));
+    ImGui::SameLine();
+    ImGui::RadioButton("Paint", &tool, static_cast<int>(SelectionTool::Paint));
+    m_selectionTool = static_cast<SelectionTool>(tool);
+
+    const char* modes[] = { "Replace", "Add", "Subtract" };
+    ImGui::SetNextItemWidth(150.0f);
+    ImGui::Combo("Mode", &m_selectionMode, modes, IM_ARRAYSIZE(modes));
+    ImGui::TextDisabled("Shift: add, Alt: subtract");
+
+    ImGui::Separator();
+
+    // Region growing from the picked triangle
+    SelectionMode mode = static_cast<SelectionMode>(m_selectionMode);
+    if (ImGui::Button("Select Connected")) {
+        m_lastSelectionCount = renderer->selectConnected(false, 180.0f, mode);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Select Coplanar")) {
+        m_lastSelectionCount = renderer->selectConnected(true, m_coplanarAngle, mode);
+    }
+    ImGui::SetNextItemWidth(150.0f);
+    ImGui::SliderFloat("Max Angle", &m_coplanarAngle, 0.0f, 90.0f, "%.1f deg");
+
+    if (ImGui::Button("Clear Selection")) {
+        renderer->clearSelection();
+        m_lastSelectionCount = 0;
+    }
+
+    ImGui::Separator();
+
+    // Material brush, used by the Paint tool
+    ImGui::SetNextItemWidth(150.0f);
+    ImGui::SliderFloat("Brush Radius", &m_brushRadius, 0.01f, 10.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+    ImGui::SetNextItemWidth(150.0f);
+    drawMaterialCombo("Brush Material", &m_brushMaterial);
+
+    ImGui::Separator();
+    ImGui::Text("Selected: %zu triangles", renderer->getSelectedTriangleCount());
+    ImGui::Text("Last query: %zu in %.2f ms", m_lastSelectionCount, renderer->lastSelectionTimeMs);
+    ImGui::Text("Last dab: %zu in %.0f us", renderer->lastPaintCount, renderer->lastPaintTimeUs);
+
+    ImGui::End();
+
+    ImGui::PopStyleColor(5);
+}
+
+bool Application::drawMaterialCombo(const char* label, int* materialID)
+{
+    auto materialName = [](void* library, int index) {
+        return static_cast<MaterialLibrary*>(library)->Get(static_cast<MaterialID>(index)).name.c_str();
+    };
+    return ImGui::Combo(label, materialID, materialName, &renderer->materials, static_cast<int>(renderer->materials.Size()));
+}
+
 void Application::loadMesh(MeshType type) {
     switch (type) {
     case MeshType::Plane:
@@ -291,9 +566,7 @@ void Application::renderMeshCreator() {
 
             ImGui::PushStyleColor(ImGuiCol_SliderGrab, ImVec4(0.5f, 0.5f, 0.5f, 1.0f));
             ImGui::PushStyleColor(ImGuiCol_SliderGrabActive, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
-            ImGui::Text("Level of Detail:");
-            ImGui::SliderInt("LOD", &m_LOD, 1, 100);
-            ImGui::Text("(Higher values create more detailed meshes)");
+            drawTessellationControls(1);
             ImGui::PopStyleColor(2);
 
             ImGui::Spacing(); ImGui::Spacing();
@@ -382,9 +655,7 @@ void Application::renderMeshCreator() {
 
             ImGui::PushStyleColor(ImGuiCol_SliderGrab, ImVec4(0.5f, 0.5f, 0.5f, 1.0f));
             ImGui::PushStyleColor(ImGuiCol_SliderGrabActive, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
-            ImGui::Text("Level of Detail:");
-            ImGui::SliderInt("LOD", &m_LOD, 1, 100);
-            ImGui::Text("(Higher values create more detailed meshes)");
+            drawTessellationControls(1);
             ImGui::PopStyleColor(2);
 
             ImGui::Spacing(); ImGui::Spacing();
@@ -475,10 +746,7 @@ void Application::renderMeshCreator() {
 
             ImGui::PushStyleColor(ImGuiCol_SliderGrab, ImVec4(0.5f, 0.5f, 0.5f, 1.0f));
             ImGui::PushStyleColor(ImGuiCol_SliderGrabActive, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
-            // Level of Detail (LOD) input
-            ImGui::Text("Level of Detail:");
-            ImGui::SliderInt("LOD", &m_LOD, 1, 100);
-            ImGui::Text("(Higher values create more detailed meshes)");
+            drawTessellationControls(1);
             ImGui::PopStyleColor(2);
 
             ImGui::Spacing();
@@ -575,9 +843,7 @@ void Application::renderMeshCreator() {
 
             ImGui::PushStyleColor(ImGuiCol_SliderGrab, ImVec4(0.5f, 0.5f, 0.5f, 1.0f));
             ImGui::PushStyleColor(ImGuiCol_SliderGrabActive, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
-            ImGui::Text("Level of Detail:");
-            ImGui::SliderInt("LOD", &m_LOD, 3, 100); // LOD for cylinder
-            ImGui::Text("(Higher values create more detailed meshes)");
+            drawTessellationControls(3);
             ImGui::PopStyleColor(2);
 
             ImGui::Spacing(); ImGui::Spacing();
@@ -674,9 +940,7 @@ void Application::renderMeshCreator() {
 
             ImGui::PushStyleColor(ImGuiCol_SliderGrab, ImVec4(0.5f, 0.5f, 0.5f, 1.0f));
             ImGui::PushStyleColor(ImGuiCol_SliderGrabActive, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
-            ImGui::Text("Level of Detail:");
-            ImGui::SliderInt("LOD", &m_LOD, 1, 100);
-            ImGui::Text("(Higher values create more detailed meshes)");
+            drawTessellationControls(1);
             ImGui::PopStyleColor(2);
 
             ImGui::Spacing(); ImGui::Spacing();
@@ -881,327 +1145,68 @@ void Application::renderMeshCreator() {
 
 }
 
-void Application::createPlaneMesh(std::string& meshName) {
-    Mesh newMesh;
-    newMesh.fileName = meshName;
-
-    // Calculate vertices based on the selected axis
-    int segments = m_LOD;
-    float dx1 = (m_planeEnd - m_planeStart) / segments;
-    float dx2 = (m_planeEnd2 - m_planeStart2) / segments;
-
-    // Generate vertices
-    for (int i = 0; i <= segments; i++) {
-        for (int j = 0; j <= segments; j++) {
-            float pos1 = m_planeStart + i * dx1;
-            float pos2 = m_planeStart2 + j * dx2;
+// Level of detail slider, or the wavelength the facets are sized for
+void Application::drawTessellationControls(int minimumLOD) {
+    ImGui::Checkbox("Size Facets for Frequency", &m_tessellation.wavelengthDriven);
 
-            Vertex vertex;
-
-            // Set position based on the selected axis
-            switch (m_planeAxis) {
-            case 0: // X-axis (YZ plane)
-                vertex.position = glm::vec3(0.0f, pos1, pos2);
-                break;
-            case 1: // Y-axis (XZ plane)
-                vertex.position = glm::vec3(pos1, 0.0f, pos2);
-                break;
-            case 2: // Z-axis (XY plane)
-                vertex.position = glm::vec3(pos1, pos2, 0.0f);
-                break;
-            }
-
-            vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
-            newMesh.vertices.push_back(vertex);
+    if (m_tessellation.wavelengthDriven) {
+        // Same frequency the Results panel solves at
+        float frequencyGHz = m_scatteringSettings.frequency * 1.0e-9f;
+        if (ImGui::DragFloat("Frequency (GHz)", &frequencyGHz, 0.05f, 0.1f, 100.0f, "%.2f")) {
+            m_scatteringSettings.frequency = std::max(frequencyGHz, 0.1f) * 1.0e9f;
         }
-    }
+        ImGui::SliderFloat("Facets per Wavelength", &m_tessellation.facetsPerWavelength, 2.0f, 30.0f, "%.0f");
 
-    // Generate indices for triangles
-    for (int i = 0; i < segments; i++) {
-        for (int j = 0; j < segments; j++) {
-            int rowLength = segments + 1;
-            int topLeft = i * rowLength + j;
-            int topRight = topLeft + 1;
-            int bottomLeft = (i + 1) * rowLength + j;
-            int bottomRight = bottomLeft + 1;
-
-            // First triangle (top-left, bottom-left, bottom-right)
-            newMesh.indices.push_back(topLeft);
-            newMesh.indices.push_back(bottomLeft);
-            newMesh.indices.push_back(bottomRight);
-
-            // Second triangle (top-left, bottom-right, top-right)
-            newMesh.indices.push_back(topLeft);
-            newMesh.indices.push_back(bottomRight);
-            newMesh.indices.push_back(topRight);
-        }
+        float wavelength = Wavelength(m_scatteringSettings.frequency);
+        ImGui::Text("Facets up to %.2f mm, chord error under %.2f mm",
+            1000.0f * wavelength / m_tessellation.facetsPerWavelength, 1000.0f * wavelength * m_tessellation.maxDeviation);
     }
+    else {
+        ImGui::Text("Level of Detail:");
+        ImGui::SliderInt("LOD", &m_LOD, minimumLOD, 100);
+        ImGui::Text("(Higher values create more detailed meshes)");
+    }
+}
 
-    // Calculate number of triangles
-    newMesh.numTriangles = newMesh.indices.size() / 3;
-
-    // Calculate dimensions
-    newMesh.CalculateDimensions();
-
-    // Calculate memory usage
-    newMesh.modelMemoryMB = (newMesh.vertices.size() * sizeof(Vertex) + newMesh.indices.size() * sizeof(GLuint)) / (1024.0f * 1024.0f);
-
-    // Add the mesh to your scene collection
-    renderer->sceneCollectionMeshes.push_back(std::move(newMesh));
+MeshDetail Application::meshDetail(int LOD) const {
+    MeshDetail detail;
+    detail.LOD = LOD;
+    detail.tessellation = m_tessellation;
+    detail.frequency = m_scatteringSettings.frequency;
+    return detail;
+}
 
-    // Update scene collection
-    renderer->setupSceneCollection();
+void Application::createPlaneMesh(std::string& meshName) {
+    Mesh newMesh;
+    newMesh.fileName = meshName;
+    GeneratePlaneMesh(newMesh, m_planeAxis, m_planeStart, m_planeEnd, m_planeStart2, m_planeEnd2, meshDetail(m_LOD));
+    addCreatedMesh(newMesh);
 }
 
 void Application::createCubeMesh(std::string& meshName, const glm::vec3& center, const glm::vec3& dimensions, int LOD) {
     Mesh newMesh;
     newMesh.fileName = meshName;
-
-    // Define the 8 vertices of the cube (centered at (0, 0, 0) before scaling)
-    glm::vec3 halfDimensions = dimensions * 0.5f;
-
-    std::vector<glm::vec3> vertices = {
-        glm::vec3(-halfDimensions.x, -halfDimensions.y, -halfDimensions.z), // 0
-        glm::vec3(halfDimensions.x, -halfDimensions.y, -halfDimensions.z), // 1
-        glm::vec3(halfDimensions.x,  halfDimensions.y, -halfDimensions.z), // 2
-        glm::vec3(-halfDimensions.x,  halfDimensions.y, -halfDimensions.z), // 3
-        glm::vec3(-halfDimensions.x, -halfDimensions.y,  halfDimensions.z), // 4
-        glm::vec3(halfDimensions.x, -halfDimensions.y,  halfDimensions.z), // 5
-        glm::vec3(halfDimensions.x,  halfDimensions.y,  halfDimensions.z), // 6
-        glm::vec3(-halfDimensions.x,  halfDimensions.y,  halfDimensions.z)  // 7
-    };
-
-    // Apply the center translation
-    for (auto& vertex : vertices) {
-        vertex += center;
-    }
-
-    // Function to generate subdivided vertices for each face of the cube
-    auto generateFaceVertices = [&](int faceIndex, glm::vec3 direction) {
-        std::vector<glm::vec3> faceVertices;
-        float step = 1.0f / LOD;
-        for (int i = 0; i <= LOD; i++) {
-            for (int j = 0; j <= LOD; j++) {
-                glm::vec3 position;
-                switch (faceIndex) {
-                case 0: // front face (z = max)
-                    position = glm::vec3(-halfDimensions.x + step * i * dimensions.x, -halfDimensions.y + step * j * dimensions.y, halfDimensions.z);
-                    break;
-                case 1: // back face (z = min)
-                    position = glm::vec3(-halfDimensions.x + step * i * dimensions.x, -halfDimensions.y + step * j * dimensions.y, -halfDimensions.z);
-                    break;
-                case 2: // left face (x = min)
-                    position = glm::vec3(-halfDimensions.x, -halfDimensions.y + step * i * dimensions.y, -halfDimensions.z + step * j * dimensions.z);
-                    break;
-                case 3: // right face (x = max)
-                    position = glm::vec3(halfDimensions.x, -halfDimensions.y + step * i * dimensions.y, -halfDimensions.z + step * j * dimensions.z);
-                    break;
-                case 4: // bottom face (y = min)
-                    position = glm::vec3(-halfDimensions.x + step * i * dimensions.x, -halfDimensions.y, -halfDimensions.z + step * j * dimensions.z);
-                    break;
-                case 5: // top face (y = max)
-                    position = glm::vec3(-halfDimensions.x + step * i * dimensions.x, halfDimensions.y, -halfDimensions.z + step * j * dimensions.z);
-                    break;
-                }
-                faceVertices.push_back(position + center);
-            }
-        }
-        return faceVertices;
-        };
-
-    // Generate vertices for each face
-    std::vector<std::vector<glm::vec3>> facesVertices;
-    for (int i = 0; i < 6; i++) {
-        facesVertices.push_back(generateFaceVertices(i, glm::vec3(0, 0, 0)));
-    }
-
-    // Add vertices to the mesh
-    for (const auto& faceVertices : facesVertices) {
-        for (const auto& vertexPos : faceVertices) {
-            Vertex vertex;
-            vertex.position = vertexPos;
-            vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);  // Color can be adjusted
-            newMesh.vertices.push_back(vertex);
-        }
-    }
-
-    // Generate indices for the cube faces
-    for (int i = 0; i < 6; i++) {
-        int rowLength = LOD + 1;
-        for (int j = 0; j < LOD; j++) {
-            for (int k = 0; k < LOD; k++) {
-                // Define quad by indices
-                int topLeft = j * rowLength + k + i * (rowLength * (LOD + 1));
-                int topRight = topLeft + 1;
-                int bottomLeft = (j + 1) * rowLength + k + i * (rowLength * (LOD + 1));
-                int bottomRight = bottomLeft + 1;
-
-                // First triangle (top-left, bottom-left, bottom-right)
-                newMesh.indices.push_back(topLeft);
-                newMesh.indices.push_back(bottomLeft);
-                newMesh.indices.push_back(bottomRight);
-
-                // Second triangle (top-left, bottom-right, top-right)
-                newMesh.indices.push_back(topLeft);
-                newMesh.indices.push_back(bottomRight);
-                newMesh.indices.push_back(topRight);
-            }
-        }
-    }
-
-    // Calculate the number of triangles
-    newMesh.numTriangles = newMesh.indices.size() / 3;
-
-    // Calculate dimensions
-    newMesh.CalculateDimensions();
-
-    // Calculate memory usage
-    newMesh.modelMemoryMB = (newMesh.vertices.size() * sizeof(Vertex) + newMesh.indices.size() * sizeof(GLuint)) / (1024.0f * 1024.0f);
-
-    // Add the mesh to your scene collection
-    renderer->sceneCollectionMeshes.push_back(std::move(newMesh));
-
-    // Update scene collection
-    renderer->setupSceneCollection();
+    GenerateCubeMesh(newMesh, center, dimensions, meshDetail(LOD));
+    addCreatedMesh(newMesh);
 }
 
 void Application::createSphereMesh(std::string& meshName, glm::vec3& center, float radius, int LOD) {
     Mesh newMesh;
     newMesh.fileName = meshName;
-
-    // Number of segments (more segments means higher detail)
-    int segments = LOD;  // The level of detail determines the number of segments
-    float phiStep = glm::pi<float>() / segments;  // Latitude angle step
-    float thetaStep = glm::pi<float>() * 2.0f / segments;  // Longitude angle step
-
-    // Generate vertices
-    for (int i = 0; i <= segments; ++i) {
-        float phi = i * phiStep;
-        for (int j = 0; j <= segments; ++j) {
-            float theta = j * thetaStep;
-
-            // Spherical to Cartesian conversion
-            float x = center.x + radius * sin(phi) * cos(theta);
-            float y = center.y + radius * cos(phi);
-            float z = center.z + radius * sin(phi) * sin(theta);
-
-            Vertex vertex;
-            vertex.position = glm::vec3(x, y, z);
-            vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);  // White color for the vertices
-            newMesh.vertices.push_back(vertex);
-        }
-    }
-
-    // Generate indices for the sphere (connecting the vertices into triangles)
-    for (int i = 0; i < segments; ++i) {
-        for (int j = 0; j < segments; ++j) {
-            int first = i * (segments + 1) + j;
-            int second = first + segments + 1;
-
-            // First triangle (top-left, bottom-left, bottom-right)
-            newMesh.indices.push_back(first);
-            newMesh.indices.push_back(second);
-            newMesh.indices.push_back(first + 1);
-
-            // Second triangle (top-left, bottom-right, top-right)
-            newMesh.indices.push_back(second);
-            newMesh.indices.push_back(second + 1);
-            newMesh.indices.push_back(first + 1);
-        }
-    }
-
-    // Calculate number of triangles
-    newMesh.numTriangles = newMesh.indices.size() / 3;
-
-    // Calculate dimensions
-    newMesh.CalculateDimensions();
-
-    // Calculate memory usage
-    newMesh.modelMemoryMB = (newMesh.vertices.size() * sizeof(Vertex) + newMesh.indices.size() * sizeof(GLuint)) / (1024.0f * 1024.0f);
-
-    // Add the mesh to your scene collection
-    renderer->sceneCollectionMeshes.push_back(std::move(newMesh));
-
-    // Update scene collection
-    renderer->setupSceneCollection();
+    GenerateSphereMesh(newMesh, center, radius, meshDetail(LOD));
+    addCreatedMesh(newMesh);
 }
 
 void Application::createCylinderMesh(std::string& meshName, glm::vec3& center, float radius, float height, int LOD) {
     Mesh newMesh;
     newMesh.fileName = meshName;
+    GenerateCylinderMesh(newMesh, center, radius, height, meshDetail(LOD));
+    addCreatedMesh(newMesh);
+}
 
-    int segments = LOD;
-    float angleStep = glm::two_pi<float>() / segments;
-    float halfHeight = height / 2.0f;
-
-    // Generate vertices
-    for (int i = 0; i < segments; i++) {
-        float angle = i * angleStep;
-        float x = radius * cos(angle);
-        float z = radius * sin(angle);
-
-        Vertex topVertex;
-        topVertex.position = glm::vec3(x, halfHeight, z) + center;  // Top circle
-        topVertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
-        newMesh.vertices.push_back(topVertex);
-
-        Vertex bottomVertex;
-        bottomVertex.position = glm::vec3(x, -halfHeight, z) + center;  // Bottom circle
-        bottomVertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
-        newMesh.vertices.push_back(bottomVertex);
-    }
-
-    // Add top and bottom center vertices
-    Vertex topCenterVertex;
-    topCenterVertex.position = glm::vec3(0.0f, halfHeight, 0.0f) + center;
-    topCenterVertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
-    newMesh.vertices.push_back(topCenterVertex);
-
-    Vertex bottomCenterVertex;
-    bottomCenterVertex.position = glm::vec3(0.0f, -halfHeight, 0.0f) + center;
-    bottomCenterVertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
-    newMesh.vertices.push_back(bottomCenterVertex);
-
-    // Generate indices for the cylinder side
-    for (int i = 0; i < segments; i++) {
-        int next = (i + 1) % segments;
-
-        // Side triangles
-        newMesh.indices.push_back(i * 2);
-        newMesh.indices.push_back(next * 2);
-        newMesh.indices.push_back(i * 2 + 1);
-
-        newMesh.indices.push_back(next * 2);
-        newMesh.indices.push_back(next * 2 + 1);
-        newMesh.indices.push_back(i * 2 + 1);
-    }
-
-    // Generate indices for the top and bottom caps
-    int topCenterIndex = 2 * segments;
-    int bottomCenterIndex = 2 * segments + 1;
-
-    for (int i = 0; i < segments; i++) {
-        int next = (i + 1) % segments;
-
-        // Top cap
-        newMesh.indices.push_back(topCenterIndex);
-        newMesh.indices.push_back(i * 2);
-        newMesh.indices.push_back(next * 2);
-
-        // Bottom cap
-        newMesh.indices.push_back(bottomCenterIndex);
-        newMesh.indices.push_back(next * 2 + 1);
-        newMesh.indices.push_back(i * 2 + 1);
-    }
-
-    // Calculate number of triangles
-    newMesh.numTriangles = newMesh.indices.size() / 3;
-
-    // Calculate dimensions
-    newMesh.CalculateDimensions();
-
-    // Calculate memory usage
-    newMesh.modelMemoryMB = (newMesh.vertices.size() * sizeof(Vertex) + newMesh.indices.size() * sizeof(GLuint)) / (1024.0f * 1024.0f);
+// Shared tail of the mesh creators, the generators already built the triangle data
+void Application::addCreatedMesh(Mesh& newMesh) {
+    std::cout << "Created " << newMesh.fileName << " with " << newMesh.numTriangles << " triangles" << std::endl;
 
     // Add the mesh to your scene collection
     renderer->sceneCollectionMeshes.push_back(std::move(newMesh));
@@ -1213,245 +1218,27 @@ void Application::createCylinderMesh(std::string& meshName, glm::vec3& center, f
 void Application::createDiskMesh(std::string& meshName, glm::vec3& center, float radius, int LOD, int axis) {
     Mesh newMesh;
     newMesh.fileName = meshName;
-
-    int segments = LOD;
-    float angleStep = glm::two_pi<float>() / segments;
-
-    // Add center vertex
-    Vertex centerVertex;
-    centerVertex.position = center;
-    centerVertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
-    newMesh.vertices.push_back(centerVertex);
-
-    // Generate perimeter vertices based on axis
-    for (int i = 0; i < segments; ++i) {
-        float angle = i * angleStep;
-        float x = radius * cos(angle);
-        float y = radius * sin(angle);
-
-        Vertex vertex;
-
-        switch (axis) {
-            case 0: // X-axis (disk lies in YZ plane)
-                vertex.position = glm::vec3(center.x, center.y + x, center.z + y);
-                break;
-            case 1: // Y-axis (disk lies in XZ plane)
-                vertex.position = glm::vec3(center.x + x, center.y, center.z + y);
-                break;
-            case 2: // Z-axis (disk lies in XY plane)
-            default:
-                vertex.position = glm::vec3(center.x + x, center.y + y, center.z);
-                break;
-        }
-
-        vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
-        newMesh.vertices.push_back(vertex);
-    }
-
-    // Generate triangle indices (triangle fan)
-    int centerIndex = 0;
-    for (int i = 1; i < segments; ++i) {
-        newMesh.indices.push_back(centerIndex);
-        newMesh.indices.push_back(i);
-        newMesh.indices.push_back(i + 1);
-    }
-    // Close the disk
-    newMesh.indices.push_back(centerIndex);
-    newMesh.indices.push_back(segments);
-    newMesh.indices.push_back(1);
-
-    newMesh.numTriangles = newMesh.indices.size() / 3;
-    newMesh.CalculateDimensions();
-    newMesh.modelMemoryMB = (newMesh.vertices.size() * sizeof(Vertex) + newMesh.indices.size() * sizeof(GLuint)) / (1024.0f * 1024.0f);
-
-    renderer->sceneCollectionMeshes.push_back(std::move(newMesh));
-    renderer->setupSceneCollection();
+    GenerateDiskMesh(newMesh, center, radius, axis, meshDetail(LOD));
+    addCreatedMesh(newMesh);
 }
 
 void Application::createTrihedralReflectorMesh(std::string& meshName, glm::vec3& center, float size) {
     Mesh newMesh;
     newMesh.fileName = meshName;
-
-    float h = size; // Half-length of each square face edge
-
-    // Define the 3 perpendicular planes meeting at the center
-    glm::vec3 p0 = center;                         // Corner point (common vertex)
-    glm::vec3 p1 = center + glm::vec3(h, 0, 0);    // X direction
-    glm::vec3 p2 = center + glm::vec3(0, h, 0);    // Y direction
-    glm::vec3 p3 = center + glm::vec3(0, 0, h);    // Z direction
-
-    glm::vec3 p4 = center + glm::vec3(h, h, 0);    // XY plane
-    glm::vec3 p5 = center + glm::vec3(h, 0, h);    // XZ plane
-    glm::vec3 p6 = center + glm::vec3(0, h, h);    // YZ plane
-
-    // Set color white
-    glm::vec3 color(1.0f, 1.0f, 1.0f);
-
-    // Vertices
-    std::vector<glm::vec3> positions = { p0, p1, p2, p3, p4, p5, p6 };
-    for (const auto& pos : positions) {
-        Vertex v;
-        v.position = pos;
-        v.color = color;
-        newMesh.vertices.push_back(v);
-    }
-
-    // Indices for the three triangle faces
-    // Each triangle is defined as (corner, edge1, edge2)
-    newMesh.indices.insert(newMesh.indices.end(), {
-        0, 1, 2,  // XY plane
-        0, 1, 3,  // XZ plane
-        0, 2, 3   // YZ plane
-        });
-
-    newMesh.numTriangles = newMesh.indices.size() / 3;
-    newMesh.CalculateDimensions();
-
-    newMesh.modelMemoryMB = (newMesh.vertices.size() * sizeof(Vertex) + newMesh.indices.size() * sizeof(GLuint)) / (1024.0f * 1024.0f);
-
-    renderer->sceneCollectionMeshes.push_back(std::move(newMesh));
-    renderer->setupSceneCollection();
+    GenerateTrihedralMesh(newMesh, center, size);
+    addCreatedMesh(newMesh);
 }
 
 void Application::createDihedralReflectorMesh(std::string& meshName, glm::vec3& center, float size) {
     Mesh newMesh;
     newMesh.fileName = meshName;
-
-    float h = size; // Half-length of square face edge
-
-    // Define base point (corner where plates meet)
-    glm::vec3 p0 = center;
-
-    // First plane in XY
-    glm::vec3 p1 = p0 + glm::vec3(h, 0, 0);
-    glm::vec3 p2 = p0 + glm::vec3(0, h, 0);
-    glm::vec3 p3 = p0 + glm::vec3(h, h, 0);
-
-    // Second plane in XZ
-    glm::vec3 p4 = p0 + glm::vec3(0, 0, h);
-    glm::vec3 p5 = p0 + glm::vec3(h, 0, h);
-
-    glm::vec3 color(1.0f, 1.0f, 1.0f); // white color
-
-    // Push vertices
-    std::vector<glm::vec3> positions = { p0, p1, p2, p3, p4, p5 };
-    for (const auto& pos : positions) {
-        Vertex v;
-        v.position = pos;
-        v.color = color;
-        newMesh.vertices.push_back(v);
-    }
-
-    // Indices for two square planes, each as two triangles
-    // XY face: p0, p1, p2, p3
-    newMesh.indices.insert(newMesh.indices.end(), {
-        0, 1, 2,
-        2, 1, 3
-        });
-
-    // XZ face: p0, p1, p4, p5
-    newMesh.indices.insert(newMesh.indices.end(), {
-        0, 1, 4,
-        4, 1, 5
-        });
-
-    newMesh.numTriangles = newMesh.indices.size() / 3;
-    newMesh.CalculateDimensions();
-
-    newMesh.modelMemoryMB = (newMesh.vertices.size() * sizeof(Vertex) + newMesh.indices.size() * sizeof(GLuint)) / (1024.0f * 1024.0f);
-
-    renderer->sceneCollectionMeshes.push_back(std::move(newMesh));
-    renderer->setupSceneCollection();
-}
-
-float Application::GetCPUutilization()
-{
-    static ULARGE_INTEGER lastIdleTime = {};
-    static ULARGE_INTEGER lastKernelTime = {};
-    static ULARGE_INTEGER lastUserTime = {};
-
-    FILETIME idleTime, kernelTime, userTime;
-    if (!GetSystemTimes(&idleTime, &kernelTime, &userTime)) {
-        return -1.0f;
-    }
-
-    ULARGE_INTEGER idle, kernel, user;
-    idle.LowPart = idleTime.dwLowDateTime;
-    idle.HighPart = idleTime.dwHighDateTime;
-
-    kernel.LowPart = kernelTime.dwLowDateTime;
-    kernel.HighPart = kernelTime.dwHighDateTime;
-
-    user.LowPart = userTime.dwLowDateTime;
-    user.HighPart = userTime.dwHighDateTime;
-
-    ULONGLONG sysIdle = idle.QuadPart - lastIdleTime.QuadPart;
-    ULONGLONG sysKernel = kernel.QuadPart - lastKernelTime.QuadPart;
-    ULONGLONG sysUser = user.QuadPart - lastUserTime.QuadPart;
-    ULONGLONG sysTotal = sysKernel + sysUser;
-
-    lastIdleTime = idle;
-    lastKernelTime = kernel;
-    lastUserTime = user;
-
-    if (sysTotal == 0) return 0.0f;
-
-    return (1.0f - ((float)sysIdle / sysTotal)) * 100.0f;
-}
-
-std::string Application::GetGPUutilization() {
-    nvmlInit();  // Initialize NVML
-
-    nvmlDevice_t device;
-    nvmlMemory_t memoryInfo;
-
-    // Stringstream to build the result string
-    std::ostringstream gpuInfo;
-
-    // Get the handle for the first GPU (since you have only one GPU)
-    nvmlDeviceGetHandleByIndex(0, &device);
-
-    // Get the memory info for the device (VRAM)
-    nvmlDeviceGetMemoryInfo(device, &memoryInfo);
-
-    // Calculate the percentage of used memory
-    float usedGB = static_cast<float>(memoryInfo.used) / (1024.0f * 1024.0f * 1024.0f);
-    float totalGB = static_cast<float>(memoryInfo.total) / (1024.0f * 1024.0f * 1024.0f);
-    float percent = (usedGB / totalGB) * 100.0f;
-
-    // Add the formatted string to the stringstream
-    gpuInfo << std::fixed << std::setprecision(1)
-        << usedGB << " GB / "  // Used memory in GB
-        << totalGB << " GB ("  // Total memory in GB
-        << static_cast<int>(percent) << "%)";  // Percentage used
-
-    nvmlShutdown();  // Shutdown NVML
-
-    return gpuInfo.str();  // Return the formatted string
-}
-
-std::string Application::GetRAMutilization()
-{
-    MEMORYSTATUSEX memInfo;
-    memInfo.dwLength = sizeof(MEMORYSTATUSEX);
-    GlobalMemoryStatusEx(&memInfo);
-
-    DWORDLONG totalPhysMem = memInfo.ullTotalPhys;
-    DWORDLONG availPhysMem = memInfo.ullAvailPhys;
-    DWORDLONG usedPhysMem = totalPhysMem - availPhysMem;
-
-    float usedGB = static_cast<float>(usedPhysMem) / (1024.0f * 1024.0f * 1024.0f);
-    float totalGB = static_cast<float>(totalPhysMem) / (1024.0f * 1024.0f * 1024.0f);
-    float percent = (usedGB / totalGB) * 100.0f;
-
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(1)
-        << usedGB << " GB / " << totalGB << " GB (" << static_cast<int>(percent) << "%)";
-
-    return oss.str();
+    GenerateDihedralMesh(newMesh, center, size);
+    addCreatedMesh(newMesh);
 }
 
 void Application::Init() {
+    Profiler::SetThreadName("Main");
+
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW\n";
@@ -1474,6 +1261,7 @@ void Application::Init() {
         std::exit(-1);
     }
     glfwSetMouseButtonCallback(window, renderer->m_InputManager.MouseButtonCallback);
+    InputManager::InstallEventCallbacks(window);
 
     // Make the OpenGL context current
     glfwMakeContextCurrent(window);
@@ -1495,8 +1283,9 @@ void Application::Init() {
     coordinateSystemTextureID = LoadTextureFromFile("assets/coordinate_system.png", &iconWidth, &iconHeight);
     resetIconTextureID = LoadTextureFromFile("assets/reset_icon.png", &iconWidth, &iconHeight);
 
-    // Setup Dear ImGui context
+    // Setup Dear ImGui context, every ImGui allocation is counted as UI memory
     IMGUI_CHECKVERSION();
+    ImGui::SetAllocatorFunctions(TrackedImGuiAlloc, TrackedImGuiFree);
     ImGui::CreateContext();
 
     // Set the global font scale
@@ -1506,20 +1295,41 @@ void Application::Init() {
     // Setup ImGui backend bindings
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 450");
+
+    // Results posted back by pool tasks wake the render on demand loop
+    ThreadPool::Global().SetMainThreadWakeup(InputManager::RequestRedraw);
+
+    // CPU, memory and VRAM readings for the metrics panel, sampled on their own thread
+    m_systemMetrics.Start(1000);
+}
+
+// "used GB / total GB (percent)"
+static std::string FormatMemoryUsage(uint64_t usedBytes, uint64_t totalBytes)
+{
+    if (totalBytes == 0) return "N/A";
+    float usedGB = static_cast<float>(usedBytes) / (1024.0f * 1024.0f * 1024.0f);
+    float totalGB = static_cast<float>(totalBytes) / (1024.0f * 1024.0f * 1024.0f);
+    float percent = (usedGB / totalGB) * 100.0f;
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1)
+        << usedGB << " GB / " << totalGB << " GB (" << static_cast<int>(percent) << "%)";
+    return oss.str();
 }
 
-void Application::drawPerformanceMetrics(float fps, float cpuUsage, std::string ramUsage, std::string gpuUsage)
+void Application::drawPerformanceMetrics(float fps)
 {
+    // Newest sample of the background sampler, never waits for it
+    const SystemMetricsSnapshot& metrics = m_systemMetrics.Latest();
+    m_shownMetricsSequence = metrics.sequence;
+
     // Set the window position to a little below the top-left corner of the screen
     ImVec2 windowPos(10, 50);
     ImGui::SetNextWindowPos(windowPos, ImGuiCond_FirstUseEver);
 
-    // Set window size explicitly and ensure it won't change
-    ImVec2 windowSize(300, 120);  // Width: 220, Height: 120
-    ImGui::SetNextWindowSize(windowSize, ImGuiCond_Always);
-
-    // Set window flags to make it non-movable and non-resizable
-    ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoResize;
+    // Fixed width, the height follows the thread list
+    ImGui::SetNextWindowSizeConstraints(ImVec2(300, 0), ImVec2(300, FLT_MAX));
+    ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize;
 
     // Push the custom color for the title background (active and inactive)
     ImGui::PushStyleColor(ImGuiCol_TitleBgActive, ImVec4(0.1f, 0.1f, 0.1f, 1.0f));
@@ -1529,11 +1339,34 @@ void Application::drawPerformanceMetrics(float fps, float cpuUsage, std::string
     // Create the window
     ImGui::Begin("Performance Metrics", nullptr, windowFlags);
 
-    // Optional: Make the font smaller for the panel text
     ImGui::Text("FPS: %.2f", fps);
-    ImGui::Text("CPU: %.2f%%", cpuUsage);
-    ImGui::Text("RAM: %s", ramUsage.c_str());
-    ImGui::Text("VRAM: %s", gpuUsage.c_str());
+    if (metrics.systemCpuPercent < 0.0f) ImGui::Text("CPU: N/A");
+    else ImGui::Text("CPU: %.2f%%", metrics.systemCpuPercent);
+    ImGui::Text("RAM: %s", FormatMemoryUsage(metrics.systemMemoryUsedBytes, metrics.systemMemoryTotalBytes).c_str());
+    ImGui::Text("VRAM: %s", metrics.hasVram ? FormatMemoryUsage(metrics.vramUsedBytes, metrics.vramTotalBytes).c_str() : "N/A");
+
+    // This process, CPU where 100% is one core
+    ImGui::Separator();
+    if (metrics.processCpuPercent < 0.0f) ImGui::Text("ScatterX CPU: N/A");
+    else ImGui::Text("ScatterX CPU: %.1f%%", metrics.processCpuPercent);
+    ImGui::Text("ScatterX RSS: %.1f MB (peak %.1f MB)", metrics.processRssBytes / (1024.0 * 1024.0),
+        metrics.processPeakRssBytes / (1024.0 * 1024.0));
+    if (ImGui::TreeNode("Threads", "Threads (%zu)", metrics.threads.size())) {
+        for (const ThreadCpuSample& thread : metrics.threads) {
+            const char* name = thread.name.empty() ? "(unnamed)" : thread.name.c_str();
+            if (thread.cpuPercent < 0.0f) ImGui::Text("%-16s -", name);
+            else ImGui::Text("%-16s %5.1f%%", name, thread.cpuPercent);
+        }
+        ImGui::TreePop();
+    }
+
+    // GPU time of each render pass, from timer queries a couple of frames old
+    ImGui::Separator();
+    for (int pass = 0; pass < static_cast<int>(GpuPass::Count); ++pass) {
+        float ms = renderer->gpuTimer.GetMs(static_cast<GpuPass>(pass));
+        if (ms < 0.0f) ImGui::Text("%s: -", GpuPassName(static_cast<GpuPass>(pass)));
+        else ImGui::Text("%s: %.3f ms", GpuPassName(static_cast<GpuPass>(pass)), ms);
+    }
 
     // End the window
     ImGui::End();
@@ -1542,6 +1375,184 @@ void Application::drawPerformanceMetrics(float fps, float cpuUsage, std::string
     ImGui::PopStyleColor(3); 
 }
 
+// Stable colour per scope name so the same scope looks the same on every lane
+static ImU32 ProfileScopeColor(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    for (const char* c = name; *c; ++c) hash = (hash ^ static_cast<unsigned char>(*c)) * 16777619u;
+    float r, g, b;
+    ImGui::ColorConvertHSVtoRGB((hash % 360) / 360.0f, 0.55f, 0.8f, r, g, b);
+    return ImGui::ColorConvertFloat4ToU32(ImVec4(r, g, b, 1.0f));
+}
+
+void Application::drawProfilerPanel()
+{
+    ImGui::SetNextWindowPos(ImVec2(320, 50), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(900, 420), ImGuiCond_FirstUseEver);
+
+    ImGui::PushStyleColor(ImGuiCol_TitleBgActive, ImVec4(0.1f, 0.1f, 0.1f, 1.0f));
+    ImGui::PushStyleColor(ImGuiCol_TitleBg, ImVec4(0.1f, 0.1f, 0.1f, 1.0f));
+    ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.2f, 0.2f, 0.2f, 1.0f));
+
+    if (!ImGui::Begin("Profiler", &m_showProfiler)) {
+        ImGui::End();
+        ImGui::PopStyleColor(3);
+        return;
+    }
+
+    bool recording = Profiler::IsEnabled();
+    if (ImGui::Checkbox("Recording", &recording)) Profiler::SetEnabled(recording);
+    ImGui::SameLine();
+    ImGui::Checkbox("Pause", &m_profilerPaused);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(200.0f);
+    ImGui::SliderFloat("Window (ms)", &m_profilerWindowMs, 10.0f, 2000.0f, "%.0f", ImGuiSliderFlags_Logarithmic);
+
+    // Chrome trace export: a snapshot of the ring buffers or a capture streamed until stopped
+    ImGui::SetNextItemWidth(300.0f);
+    ImGui::InputText("##TracePath", m_tracePath, IM_ARRAYSIZE(m_tracePath));
+    ImGui::SameLine();
+    if (ImGui::Button("Save Snapshot")) {
+        m_traceStatus = TraceWriter::WriteSnapshot(m_tracePath) ? std::string("Saved ") + m_tracePath : "Could not write the trace";
+    }
+    ImGui::SameLine();
+    bool capturing = m_traceCapture.IsRunning();
+    if (ImGui::Checkbox("Capture", &capturing)) {
+        if (capturing) {
+            m_traceStatus = m_traceCapture.Start(m_tracePath) ? std::string("Capturing to ") + m_tracePath : "Could not write the trace";
+        }
+        else {
+            m_traceCapture.Stop();
+            m_traceStatus = "Saved " + m_traceCapture.GetPath() + ", " + std::to_string(m_traceCapture.GetWrittenEvents()) + " events";
+        }
+    }
+    if (m_traceCapture.IsRunning()) {
+        ImGui::SameLine();
+        ImGui::Text("%llu events, %llu lost", static_cast<unsigned long long>(m_traceCapture.GetWrittenEvents()),
+            static_cast<unsigned long long>(m_traceCapture.GetDroppedEvents()));
+    }
+    else if (!m_traceStatus.empty()) {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(m_traceStatus.c_str());
+    }
+
+    // Copy the events out a few times per second, the timeline is drawn from the copy
+    double now = glfwGetTime();
+    if (!m_profilerPaused && (m_profilerThreads.empty() || now - m_lastProfilerTime >= 0.25)) {
+        m_profilerEndNs = Profiler::Now();
+        uint64_t windowNs = static_cast<uint64_t>(m_profilerWindowMs * 1.0e6);
+        Profiler::Collect(m_profilerEndNs > windowNs ? m_profilerEndNs - windowNs : 0, m_profilerThreads);
+        std::sort(m_profilerThreads.begin(), m_profilerThreads.end(),
+            [](const ProfileThreadSnapshot& a, const ProfileThreadSnapshot& b) { return a.threadIndex < b.threadIndex; });
+        m_lastProfilerTime = now;
+    }
+
+    //----------------------------------------
+    // Timeline, one lane per thread with nested scopes stacked below their parent
+    //----------------------------------------
+    const float labelWidth = 90.0f;
+    const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+    double windowNs = m_profilerWindowMs * 1.0e6;
+    double startNs = static_cast<double>(m_profilerEndNs) - windowNs;
+
+    ImGui::BeginChild("ProfilerTimeline", ImVec2(0.0f, ImGui::GetContentRegionAvail().y * 0.6f), ImGuiChildFlags_Borders);
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    float width = ImGui::GetContentRegionAvail().x - labelWidth;
+    if (width > 1.0f) {
+        ImVec2 mouse = ImGui::GetIO().MousePos;
+        for (const ProfileThreadSnapshot& thread : m_profilerThreads) {
+            uint32_t maxDepth = 0;
+            for (const ProfileEvent& event : thread.events) {
+                if (event.kind == ProfileEventKind::Scope) maxDepth = std::max(maxDepth, event.depth);
+            }
+
+            ImVec2 origin = ImGui::GetCursorScreenPos();
+            float laneHeight = (maxDepth + 1) * rowHeight;
+            drawList->AddText(origin, IM_COL32(220, 220, 220, 255), thread.name.c_str());
+            drawList->AddRectFilled(ImVec2(origin.x + labelWidth, origin.y),
+                ImVec2(origin.x + labelWidth + width, origin.y + laneHeight), IM_COL32(40, 40, 40, 255));
+
+            for (const ProfileEvent& event : thread.events) {
+                if (event.kind != ProfileEventKind::Scope) continue;
+                float x0 = static_cast<float>((event.startNs - startNs) / windowNs) * width;
+                float x1 = static_cast<float>((event.endNs - startNs) / windowNs) * width;
+                x0 = std::max(x0, 0.0f);
+                x1 = std::min(std::max(x1, x0 + 1.0f), width);
+                ImVec2 min(origin.x + labelWidth + x0, origin.y + event.depth * rowHeight);
+                ImVec2 max(origin.x + labelWidth + x1, min.y + rowHeight - 1.0f);
+                drawList->AddRectFilled(min, max, ProfileScopeColor(event.name));
+                if (max.x - min.x > ImGui::CalcTextSize(event.name).x + 4.0f) {
+                    drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32(0, 0, 0, 255), event.name);
+                }
+                if (ImGui::IsWindowHovered() && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y) {
+                    ImGui::SetTooltip("%s\n%.3f ms", event.name, (event.endNs - event.startNs) * 1.0e-6);
+                }
+            }
+            ImGui::Dummy(ImVec2(labelWidth + width, laneHeight + 4.0f));
+        }
+    }
+    ImGui::EndChild();
+
+    //----------------------------------------
+    // Totals per scope name over the window
+    //----------------------------------------
+    struct ScopeTotals {
+        const char* name;
+        int count = 0;
+        double totalMs = 0.0;
+        double maxMs = 0.0;
+    };
+    std::vector<ScopeTotals> totals;
+    std::vector<std::pair<const char*, uint64_t>> counters;
+    for (const ProfileThreadSnapshot& thread : m_profilerThreads) {
+        for (const ProfileEvent& event : thread.events) {
+            if (event.kind == ProfileEventKind::Counter) {
+                auto counter = std::find_if(counters.begin(), counters.end(),
+                    [&](const auto& entry) { return std::strcmp(entry.first, event.name) == 0; });
+                if (counter == counters.end()) counters.emplace_back(event.name, event.count);
+                else counter->second += event.count;
+                continue;
+            }
+            auto it = std::find_if(totals.begin(), totals.end(),
+                [&](const ScopeTotals& entry) { return std::strcmp(entry.name, event.name) == 0; });
+            if (it == totals.end()) it = totals.insert(totals.end(), ScopeTotals{ event.name });
+            double ms = (event.endNs - event.startNs) * 1.0e-6;
+            it->count++;
+            it->totalMs += ms;
+            it->maxMs = std::max(it->maxMs, ms);
+        }
+    }
+    std::sort(totals.begin(), totals.end(), [](const ScopeTotals& a, const ScopeTotals& b) { return a.totalMs > b.totalMs; });
+
+    for (size_t i = 0; i < counters.size(); ++i) {
+        if (i > 0) ImGui::SameLine(0.0f, 20.0f);
+        ImGui::Text("%s: %llu", counters[i].first, static_cast<unsigned long long>(counters[i].second));
+    }
+
+    ImGuiTableFlags tableFlags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("ProfilerTotals", 5, tableFlags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("Count");
+        ImGui::TableSetupColumn("Total (ms)");
+        ImGui::TableSetupColumn("Mean (ms)");
+        ImGui::TableSetupColumn("Max (ms)");
+        ImGui::TableHeadersRow();
+        for (const ScopeTotals& entry : totals) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(entry.name);
+            ImGui::TableNextColumn(); ImGui::Text("%d", entry.count);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", entry.totalMs);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", entry.totalMs / entry.count);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", entry.maxMs);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+    ImGui::PopStyleColor(3);
+}
+
 void Application::drawContentBrowser()
 {
     ImGui::PushStyleColor(ImGuiCol_TitleBgActive, ImVec4(0.1f, 0.1f, 0.1f, 1.0f));
@@ -1766,6 +1777,78 @@ void Application::drawResultsPanel()
 
     ImGui::Begin("Results", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse);
 
+    // Radar, the frequency range is the band the material tables cover
+    ScatteringSettings& settings = m_scatteringSettings;
+    float frequencyGHz = settings.frequency * 1.0e-9f;
+    ImGui::SetNextItemWidth(200.0f);
+    if (ImGui::SliderFloat("Frequency (GHz)", &frequencyGHz, renderer->materials.GetMinFrequency() * 1.0e-9f,
+        renderer->materials.GetMaxFrequency() * 1.0e-9f, "%.2f")) {
+        settings.frequency = frequencyGHz * 1.0e9f;
+    }
+    ImGui::SetNextItemWidth(200.0f);
+    ImGui::SliderFloat("Azimuth", &settings.azimuth, -180.0f, 180.0f, "%.1f deg");
+    ImGui::SetNextItemWidth(200.0f);
+    ImGui::SliderFloat("Elevation", &settings.elevation, -90.0f, 90.0f, "%.1f deg");
+
+    const char* polarizations[] = { "HH", "VV" };
+    int polarization = static_cast<int>(settings.polarization);
+    ImGui::SetNextItemWidth(200.0f);
+    if (ImGui::Combo("Polarization", &polarization, polarizations, IM_ARRAYSIZE(polarizations))) {
+        settings.polarization = static_cast<Polarization>(polarization);
+    }
+
+    ImGui::Checkbox("Shadowing", &m_solver.shadowing);
+    if (m_solver.shadowing) {
+        ImGui::SetNextItemWidth(200.0f);
+        ImGui::SliderInt("Shadow Resolution", &m_solver.shadowRasterizer.resolution, 256, 4096);
+    }
+
+    ImGui::Checkbox("Analytic Primitives", &m_solver.analyticPrimitives);
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Evaluate spheres, plates, boxes, cylinders, disks and corner reflectors from their closed form");
+    }
+
+    ImGui::Checkbox("Edge Diffraction", &m_solver.edgeDiffraction);
+    if (m_solver.edgeDiffraction) {
+        ImGui::SetNextItemWidth(200.0f);
+        ImGui::SliderFloat("Feature Angle", &m_solver.featureEdgeAngle, 1.0f, 90.0f, "%.0f deg");
+    }
+
+    bool solve = ImGui::Button("Solve");
+    ImGui::SameLine();
+    ImGui::Checkbox("Live Update", &m_liveScattering);
+
+    if (solve || m_liveScattering) {
+        m_lastScattering = m_solver.Solve(renderer->sceneCollectionMeshes, renderer->materials, settings);
+        m_hasScatteringResult = true;
+    }
+
+    ImGui::Separator();
+    if (m_hasScatteringResult) {
+        ImGui::Text("RCS: %.4g m^2 (%.2f dBsm)", m_lastScattering.rcs, m_lastScattering.rcsDBsm);
+        ImGui::Text("Lit triangles: %zu", m_lastScattering.litTriangles);
+        if (m_solver.edgeDiffraction) {
+            ImGui::Text("Feature edges: %zu (%.2f dBsm alone)", m_lastScattering.featureEdges,
+                10.0 * std::log10(std::max(std::norm(m_lastScattering.edgeField), 1e-30)));
+        }
+        ImGui::Text("Integrated: %zu in %.2f ms", m_lastScattering.evaluatedTriangles, m_lastScattering.timeMs);
+        if (m_lastScattering.analyticMeshes > 0) {
+            ImGui::Text("Analytic: %zu meshes", m_lastScattering.analyticMeshes);
+        }
+        // Single bounce reference, the facet sum should converge to it as the mesh gets finer
+        if (m_lastScattering.hasReference && m_lastScattering.analyticMeshes == 0) {
+            double referenceDBsm = m_lastScattering.referenceRcs > 0.0 ? 10.0 * std::log10(m_lastScattering.referenceRcs) : -300.0;
+            ImGui::Text("Analytic reference: %.2f dBsm (%+.2f dB)", referenceDBsm, m_lastScattering.rcsDBsm - referenceDBsm);
+        }
+        if (m_solver.shadowing) {
+            ImGui::Text("Shadow raster: %dx%d in %.2f ms", m_solver.shadowRasterizer.GetWidth(),
+                m_solver.shadowRasterizer.GetHeight(), m_solver.shadowRasterizer.lastRenderTimeMs);
+        }
+    }
+    else {
+        ImGui::TextDisabled("Physical optics, single bounce");
+    }
+
     ImGui::End();
     ImGui::PopStyleColor(4); // Pop styles
 }
@@ -1790,8 +1873,7 @@ void Application::drawSceneCollection()
             selectedObjectNameSceneCollection = "Camera & Scene";
             m_showMeshOptions = false;
             m_showSceneOptions = false;
-            renderer->pickedObjectID = -1;
-            renderer->pickedTriangleID = -1;
+            renderer->clearSelection();
         }
     }
     else {
@@ -1812,8 +1894,7 @@ void Application::drawSceneCollection()
                     else {
                         m_showMeshOptions = false;
                         m_showSceneOptions = false;
-                        renderer->pickedObjectID = -1;
-                        renderer->pickedTriangleID = -1;
+                        renderer->clearSelection();
                         // Otherwise, select this object
                         selectedObjectNameSceneCollection = meshName;
                     }
@@ -1836,10 +1917,9 @@ void Application::drawSceneInspector()
     ImVec2 windowPos(10, 350);
     ImGui::SetNextWindowPos(windowPos, ImGuiCond_FirstUseEver);
 
-    ImVec2 windowSize(300, 120);
-    ImGui::SetNextWindowSize(windowSize, ImGuiCond_Always);
-
-    ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoResize;
+    // Fixed width, the height follows the memory table
+    ImGui::SetNextWindowSizeConstraints(ImVec2(300, 0), ImVec2(300, FLT_MAX));
+    ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize;
 
     ImGui::PushStyleColor(ImGuiCol_TitleBgActive, ImVec4(0.1f, 0.1f, 0.1f, 1.0f));
     ImGui::PushStyleColor(ImGuiCol_TitleBg, ImVec4(0.1f, 0.1f, 0.1f, 1.0f));
@@ -1860,6 +1940,30 @@ void Application::drawSceneInspector()
     ImGui::Text("Total Triangles: %zu", totalTriangles);
     ImGui::Text("Total Memory: %.2f MB", totalMemoryMB);
     ImGui::Text("Grid Step Size: %.3f m", renderer->step);
+    ImGui::Text("Visible Objects: %zu", renderer->visibleMeshIndices.size());
+    ImGui::Text("Culled: %zu frustum, %zu occlusion", renderer->frustumCulledCount, renderer->occlusionCulledCount);
+    ImGui::Text("Last Pick: %.1f us (%s)", renderer->lastPickTimeUs, renderer->useGPUPicking ? "GPU" : "BVH");
+
+    // What each subsystem holds right now and the most it held since the last reset
+    ImGui::Separator();
+    ImGuiTableFlags tableFlags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders;
+    if (ImGui::BeginTable("MemoryCategories", 3, tableFlags)) {
+        ImGui::TableSetupColumn("Memory");
+        ImGui::TableSetupColumn("Now (MB)");
+        ImGui::TableSetupColumn("Peak (MB)");
+        ImGui::TableHeadersRow();
+        for (int index = 0; index < static_cast<int>(MemoryCategory::Count); ++index) {
+            MemoryCategory category = static_cast<MemoryCategory>(index);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(MemoryCategoryName(category));
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", MemoryTracker::GetCurrent(category) / (1024.0 * 1024.0));
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", MemoryTracker::GetPeak(category) / (1024.0 * 1024.0));
+        }
+        ImGui::EndTable();
+    }
+    if (ImGui::Button("Reset Peaks")) {
+        MemoryTracker::ResetPeaks();
+    }
 
     ImGui::End();
 
@@ -1938,27 +2042,37 @@ void Application::drawObjectEditor()
 
         ImGui::Dummy(ImVec2(0.0f, 8.0f));
 
-        // Reflectivity slider
+        // Material selection
         ImGui::PushItemWidth(175.0f);
         ImGui::PushStyleColor(ImGuiCol_SliderGrab, ImVec4(0.5f, 0.5f, 0.5f, 1.0f));
         ImGui::PushStyleColor(ImGuiCol_SliderGrabActive, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
         ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.15f, 0.15f, 0.15f, 1.0f));
 
-        // Center the slider and label
+        // Center the combo and label
         float sliderWidth = 155.0f;
-        float labelWidth = ImGui::CalcTextSize("Reflectivity").x;
+        float labelWidth = ImGui::CalcTextSize("Material").x;
         float totalWidth = sliderWidth + labelWidth + 5.0f; // 5.0f for some spacing
         ImGui::SetCursorPosX((windowWidth - totalWidth) * 0.5f);
 
-        // Create a non-const copy of the reflectivity value
-        float reflectivity = selectedTriangle.reflectivity;
-        if (ImGui::SliderFloat("Reflectivity", &reflectivity, 0.0f, 1.0f, "%.2f")) {
-            // Update the reflectivity if changed
-            if (renderer->pickedObjectID >= 0 && renderer->pickedTriangleID >= 0) {
+        // Create a non-const copy of the material ID
+        int material = selectedTriangle.material;
+        size_t selectedCount = renderer->getSelectedTriangleCount();
+        if (drawMaterialCombo("Material", &material)) {
+            // Update the material if changed, a multi selection is edited as a whole
+            if (selectedCount > 1) {
+                renderer->setSelectionMaterial(static_cast<MaterialID>(material));
+            }
+            else if (renderer->pickedObjectID >= 0 && renderer->pickedTriangleID >= 0) {
                 Mesh& mesh = renderer->sceneCollectionMeshes[renderer->pickedObjectID];
-                mesh.triangles[renderer->pickedTriangleID].reflectivity = reflectivity;
+                mesh.SetTriangleMaterial(renderer->pickedTriangleID, static_cast<MaterialID>(material));
             }
         }
+        if (selectedCount > 1) {
+            std::string selectionText = std::format("Applies to {} selected triangles", selectedCount);
+            float textWidth = ImGui::CalcTextSize(selectionText.c_str()).x;
+            ImGui::SetCursorPosX((windowWidth - textWidth) * 0.5f);
+            ImGui::TextDisabled("%s", selectionText.c_str());
+        }
 
         ImGui::PopStyleColor(3);
         ImGui::PopItemWidth();
@@ -2202,12 +2316,16 @@ void Application::drawObjectEditor()
         ImGui::PushStyleColor(ImGuiCol_SliderGrabActive, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
         ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.15f, 0.15f, 0.15f, 1.0f));
 
-        if (ImGui::SliderFloat("Grid Size", &renderer->size, 10.0f, 500.0f, "%.0f")) {
-            renderer->gridNeedsUpdate = true;
-        }
-        if (ImGui::SliderFloat("Division", &renderer->divisions, 10.0f, 500.0f, "%.0f")) {
-            renderer->gridNeedsUpdate = true;
-        }
+        // The grid is procedural, changing these only updates shader uniforms
+        ImGui::SliderFloat("Grid Size", &renderer->size, 10.0f, 500.0f, "%.0f");
+        ImGui::SliderFloat("Division", &renderer->divisions, 10.0f, 500.0f, "%.0f");
+
+        // Culling options
+        ImGui::PushStyleColor(ImGuiCol_CheckMark, ImVec4(1.0f, 1.0f, 1.0f, 1.0f));
+        ImGui::Checkbox("Frustum Culling", &renderer->frustumCullingEnabled);
+        ImGui::Checkbox("Occlusion Culling", &renderer->occlusionCullingEnabled);
+        ImGui::Checkbox("GPU Picking", &renderer->useGPUPicking);
+        ImGui::PopStyleColor();
 
         ImGui::PopStyleColor(3);
         ImGui::PopItemWidth();
@@ -2233,7 +2351,6 @@ void Application::drawObjectEditor()
             // Reset grid values to defaults
             renderer->size = 150.0f;
             renderer->divisions = 150.0f;
-            renderer->gridNeedsUpdate = true;
         }
 
         // Pop the button styling
@@ -2585,17 +2702,30 @@ void Application::renderObjectSelectionWindow()
         static int triangleCount = 0;
         static float meshSizeMB = 0.0f;
         static std::string lastSelectedPath = "";
+        static Task<Mesh> loadTask;
 
-        // Load mesh data if path has changed
+        // Parse the model on the thread pool if the path has changed, the UI keeps running meanwhile.
+        // A newer selection cancels the older load so its mesh never reaches the popup.
         if (lastSelectedPath != selectedItemPathContentBrowser) {
             lastSelectedPath = selectedItemPathContentBrowser;
             meshLoaded = false;
 
-            tempMesh = Mesh(selectedItemPathContentBrowser);
+            if (loadTask.IsValid()) loadTask.Cancel();
+            loadTask = ThreadPool::Global().Submit([path = selectedItemPathContentBrowser]() {
+                Mesh mesh(path);
+                mesh.GetBVH(); // Built here instead of on the first pick
+                return mesh;
+            }, TaskPriority::Background);
+            loadTask.ThenOnMain([](Mesh& mesh) {
+                tempMesh = std::move(mesh);
+                triangleCount = tempMesh.numTriangles;
+                meshSizeMB = tempMesh.modelMemoryMB;
+                meshLoaded = true;
+            });
+        }
 
-            triangleCount = tempMesh.numTriangles;
-            meshSizeMB = tempMesh.modelMemoryMB;
-            meshLoaded = true;
+        if (!meshLoaded) {
+            ImGui::TextWrapped("Loading %s...", fileName.c_str());
         }
 
         if (meshLoaded) {
@@ -2640,6 +2770,7 @@ void Application::renderObjectSelectionWindow()
                 renderer->sceneCollectionMeshes.push_back(std::move(tempMesh));
                 renderer->setupSceneCollection();
                 selectedItemPathContentBrowser = ""; // Close popup
+                lastSelectedPath = "";               // The mesh moved out, selecting the file again reloads it
             }
             ImGui::PopStyleColor(3);
 
@@ -2654,6 +2785,7 @@ void Application::renderObjectSelectionWindow()
                 m_showMeshOptions = false;
                 m_showSceneOptions = false;
                 selectedItemPathContentBrowser = ""; // Close popup
+                lastSelectedPath = "";
                 tempMesh.Clean();
                 renderer->setupSceneCollection();
             }
@@ -2764,9 +2896,24 @@ void Application::drawTitleBar()
             // Performance Metrics checkbox
             ImGui::Checkbox("Performance Metrics", &m_showPerformanceMetrics);
 
+            // Profiler timeline checkbox
+            ImGui::Checkbox("Profiler", &m_showProfiler);
+
             // Display mode checkbox
             ImGui::Checkbox("Display Mode", &m_showDisplayMode);
 
+            // Selection tools checkbox
+            ImGui::Checkbox("Selection Tools", &m_showSelectionTools);
+
+            ImGui::Separator();
+
+            // Only redraw when something changed
+            ImGui::Checkbox("Render On Demand", &m_renderOnDemand);
+
+            // Frame cap (0 = limited by V-Sync only)
+            ImGui::SetNextItemWidth(150.0f);
+            ImGui::SliderInt("Frame Cap", &m_frameCap, 0, 240, m_frameCap == 0 ? "Off" : "%d FPS");
+
             ImGui::End(); // End the child window
         }
 
@@ -2880,14 +3027,52 @@ void Application::MainLoop() {
     static int frameCount = 0;
     float fps = 0.0f;
 
-    // CPU and RAM usage variables
-    static float cachedCpuUsage = 0.0f;
-    static float lastCpuQueryTime = 0.0f;
-    static std::string cachedRamUsageStr = "";
-    static std::string cachedGpuUsage = "";
+    // Render on demand state
+    int framesToRender = 0;        // Frames still owed after the last change
+    bool cameraMoving = false;     // Keep polling while the camera is in motion
+    double lastRenderTime = 0.0;
 
     while (!glfwWindowShouldClose(window)) {
 
+        // Sleep until input arrives, a job asks for a redraw or the metrics need a refresh
+        if (!m_renderOnDemand || cameraMoving || framesToRender > 0) {
+            glfwPollEvents();
+        }
+        else {
+            glfwWaitEventsTimeout(m_idleTimeout);
+        }
+
+        // ImGui reacts to input one frame late, so each change is drawn a few times
+        if (!m_renderOnDemand || InputManager::ConsumeRedrawRequest()) {
+            framesToRender = std::max(framesToRender, kSettleFrames);
+        }
+        if (m_showPerformanceMetrics && m_systemMetrics.Latest().sequence != m_shownMetricsSequence) {
+            framesToRender = std::max(framesToRender, 1);
+        }
+        if (m_showProfiler && !m_profilerPaused && glfwGetTime() - m_lastProfilerTime >= 0.25) {
+            framesToRender = std::max(framesToRender, 1);
+        }
+
+        // Handles camera inputs
+        cameraMoving = false;
+        if (!ImGui::GetIO().WantCaptureMouse) {
+            cameraMoving = renderer->camera.Inputs(window);
+        }
+        if (cameraMoving) {
+            framesToRender = std::max(framesToRender, 1);
+        }
+
+        if (framesToRender == 0) continue;
+        framesToRender--;
+
+        // Frame cap, events arriving while we wait are handled in this frame
+        if (m_frameCap > 0) {
+            double wait = lastRenderTime + 1.0 / m_frameCap - glfwGetTime();
+            if (wait > 0.0) glfwWaitEventsTimeout(wait);
+        }
+        lastRenderTime = glfwGetTime();
+        PROFILE_SCOPE("Frame");
+
         // Time tracking
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
@@ -2896,26 +3081,39 @@ void Application::MainLoop() {
         // FPS calculation (every second)
         frameCount++;
         if (currentFrame - lastTime >= 1.0f) { // Update FPS every 1 second
-            fps = frameCount;  // Set FPS to the frame count over the last second
+            fps = frameCount / (currentFrame - lastTime);  // Rendered frames per second
             frameCount = 0;    // Reset frame count
             lastTime = currentFrame; // Reset the time tracker
         }
 
-        glfwPollEvents();
-
-        if (renderer->m_InputManager.m_leftMouseButton.IsPressed) {
-            renderer->drawPickingTexture();
+        // Results of pool tasks (loaded models, metrics samples) are handed over here
+        {
+            PROFILE_SCOPE("Main thread callbacks");
+            ThreadPool::Global().RunMainThreadCallbacks();
         }
 
+        // Read back the GPU pass times that have finished, never waits for the others
+        renderer->gpuTimer.BeginFrame();
+
+        // Keep the viewport, camera aspect and picking target at the window size
+        int windowWidth, windowHeight, framebufferWidth, framebufferHeight;
+        glfwGetWindowSize(window, &windowWidth, &windowHeight);
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        renderer->resize(windowWidth, windowHeight, framebufferWidth, framebufferHeight);
+
+        // Finish GPU picks queued on earlier frames
+        renderer->resolvePendingPicks();
+
+        // Build the visibility list shared by the picking and the main pass
+        renderer->updateVisibility();
+
+        // Picking, box and lasso selection
+        this->handleSelectionInput();
+
         // Set background color to dark gray for the screen
         glClearColor(0.25f, 0.25f, 0.25f, 1.0f); // Darker gray background for the screen
         glClear(GL_COLOR_BUFFER_BIT); // Clear the color buffer
 
-        // Handles camera inputs
-        if (!ImGui::GetIO().WantCaptureMouse) {
-            renderer->camera.Inputs(window);
-        }
-
         //----------------------------------------
         // -- Draw OpenGL 3D World --
         //----------------------------------------
@@ -2929,26 +3127,18 @@ void Application::MainLoop() {
         // Draw scene collections
         renderer->drawSceneCollection();
 
-        // Start ImGui frame
+        // Start ImGui frame, the panels below are timed as one "Build UI" event
+        uint64_t uiStart = Profiler::Now();
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
-        // Performance metrics
-        // Throttle CPU usage update (once per second)
-        if (currentFrame - lastCpuQueryTime >= 1.0f) {
-            cachedRamUsageStr = GetRAMutilization();
-            cachedCpuUsage = GetCPUutilization();
-            cachedGpuUsage = GetGPUutilization();
-            lastCpuQueryTime = currentFrame;
-        }
-
         //----------------------------------------
         // -- Draw ImGui (UI World) --
         //---------------------------------------
 
         // Performance metrics
-        if(m_showPerformanceMetrics) this->drawPerformanceMetrics(fps, cachedCpuUsage, cachedRamUsageStr, cachedGpuUsage);
+        if(m_showPerformanceMetrics) this->drawPerformanceMetrics(fps);
 
         // Title bar
         InputManager::UpdateMousePosition(window);
@@ -2981,15 +3171,34 @@ void Application::MainLoop() {
         // Display mode panel
         if(m_showDisplayMode) this->drawDisplayModePanel();
 
+        // Selection tools panel and the box/lasso outline
+        if(m_showSelectionTools) this->drawSelectionToolsPanel();
+        this->drawSelectionOverlay();
+
+        // Profiler timeline
+        if(m_showProfiler) this->drawProfilerPanel();
+
         // Render ImGui UI
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        if (Profiler::IsEnabled()) Profiler::Record("Build UI", uiStart, Profiler::Now(), Profiler::CurrentDepth());
+        {
+            PROFILE_SCOPE("ImGui render");
+            GpuPassScope gpuPass(renderer->gpuTimer, GpuPass::ImGui);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
-        glfwSwapBuffers(window);
+        {
+            PROFILE_SCOPE("Swap buffers");
+            glfwSwapBuffers(window);
+        }
     }
 }
 
 void Application::Shutdown() {
+    m_traceCapture.Stop();
+
+    m_systemMetrics.Stop();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
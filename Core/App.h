@@ -3,13 +3,12 @@
 #include <iostream>
 #include <vector>
 #include <memory>
-#include <windows.h>
 #include <string>
 #include <sstream>
 #include <iomanip>
 #include <filesystem>
-
-#include <nvml.h>
+#include <cstring>
+#include <format>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -20,11 +19,23 @@
 #include "Camera.h"
 #include "Renderer.h"
 #include "InputManager.h"
+#include "Scattering.h"
+#include "MeshGenerators.h"
+#include "Tessellation.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include "TraceWriter.h"
+#include "SystemMetrics.h"
+#include "MemoryTracker.h"
 
 enum class MeshType {
     Plane, Cube, Sphere, Cylinder, Disk, Trihedral, Dihedral, Picker, AI
 };
 
+enum class SelectionTool {
+    Pick, Box, Lasso, Paint
+};
+
 class Application {
 public:
     Application();
@@ -40,6 +51,13 @@ private:
     GLuint LoadTextureFromFile(const char* filename, int* out_width, int* out_height);
     void SetGeometryToOrigin(int meshIndex);
     void drawDisplayModePanel();
+
+    // Triangle selection
+    void handleSelectionInput();
+    void handlePaintInput();
+    void drawSelectionToolsPanel();
+    void drawSelectionOverlay();
+    bool drawMaterialCombo(const char* label, int* materialID);
     
     // Create mesh objects
     void loadMesh(MeshType type);
@@ -51,11 +69,9 @@ private:
     void createDiskMesh(std::string& meshName, glm::vec3& center, float radius, int LOD, int axis);
     void createTrihedralReflectorMesh(std::string& meshName, glm::vec3& center, float size);
     void createDihedralReflectorMesh(std::string& meshName, glm::vec3& center, float size);
-
-    // Performance metrics
-    float GetCPUutilization();
-    std::string GetGPUutilization();
-    std::string GetRAMutilization();
+    void addCreatedMesh(Mesh& newMesh);
+    MeshDetail meshDetail(int LOD) const;   // Fixed LOD or the wavelength driven settings, for the generators
+    void drawTessellationControls(int minimumLOD);
 
     // Panels
     void drawContentBrowser();
@@ -66,7 +82,8 @@ private:
     void renderObjectSelectionWindow();
     void drawTitleBar();
     void drawCoordinateSystemImage();
-    void drawPerformanceMetrics(float fps, float cpuUsage, std::string ramUsage, std::string gpuUsage);
+    void drawPerformanceMetrics(float fps);
+    void drawProfilerPanel();
 
     std::unique_ptr<Renderer> renderer;
 
@@ -80,6 +97,7 @@ private:
     GLuint resetIconTextureID;
     GLuint objIconTextureID;
     GLuint coordinateSystemTextureID;
+    MemoryAccount m_iconMemory{ MemoryCategory::GpuBuffers };
 
     // Title bar buttons boolean variables
     bool m_showMeshOptions = false;
@@ -92,9 +110,55 @@ private:
     bool m_showSceneInspector = true;
     bool m_showPerformanceMetrics = true;
     bool m_showDisplayMode = true;
+    bool m_showSelectionTools = true;
+    bool m_showProfiler = false;
+
+    // Selection tools
+    SelectionTool m_selectionTool = SelectionTool::Pick;
+    int m_selectionMode = 0;                      // SelectionMode used without modifier keys
+    float m_coplanarAngle = 10.0f;                // Degrees
+    bool m_selectionDragging = false;
+    std::vector<glm::vec2> m_selectionPoints;     // Box corners or lasso outline, window coordinates
+    size_t m_lastSelectionCount = 0;
+
+    // Material brush
+    float m_brushRadius = 0.5f;                   // World units
+    int m_brushMaterial = 1;
+    bool m_painting = false;
+    RayHit m_brushHit;                            // Surface under the cursor, invalid when meshIndex < 0
+    glm::vec3 m_lastDab = glm::vec3(0.0f);        // Where the current stroke last painted
+    bool m_hasLastDab = false;
+
+    // Scattering
+    PhysicalOpticsSolver m_solver;
+    ScatteringSettings m_scatteringSettings;
+    ScatteringResult m_lastScattering;
+    bool m_hasScatteringResult = false;
+    bool m_liveScattering = false;          // Re-solve every frame, the solver cache keeps edits cheap
+
+    // Performance metrics, sampled on the sampler's own thread
+    SystemMetricsSampler m_systemMetrics;
+    uint64_t m_shownMetricsSequence = 0;    // Sample the panel last drew, a newer one triggers a redraw
+
+    // Profiler timeline, a copy of the last m_profilerWindowMs of events refreshed a few times per second
+    std::vector<ProfileThreadSnapshot> m_profilerThreads;
+    uint64_t m_profilerEndNs = 0;           // Right edge of the timeline
+    double m_lastProfilerTime = -1.0;
+    float m_profilerWindowMs = 100.0f;
+    bool m_profilerPaused = false;
+    TraceWriter m_traceCapture;             // Streams to m_tracePath while "Capture" is on
+    char m_tracePath[256] = "scatterx_trace.json";
+    std::string m_traceStatus;
+
+    // Render loop
+    static constexpr int kSettleFrames = 3; // Frames drawn after each event so ImGui can settle
+    bool m_renderOnDemand = true;
+    int m_frameCap = 60;                    // 0 = uncapped
+    double m_idleTimeout = 1.0;             // Seconds to sleep when nothing happens
 
     // Inside mesh options
     int m_LOD = 10;         // Level of detail (grid size)
+    TessellationSettings m_tessellation;   // Facets sized for m_scatteringSettings.frequency instead of m_LOD
     // Plane properties
     bool m_showPlaneCreator = false;
     int m_planeAxis = 0; // 0 = X, 1 = Y, 2 = Z
@@ -0,0 +1,392 @@
+#include "BVH.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Build parameters
+static constexpr uint32_t kMaxLeafTriangles = 4;
+static constexpr int kBinCount = 12;
+static constexpr int kMaxDepth = 60;      // Traversal stack below is sized for this
+static constexpr int kTraversalStackSize = 64;
+static constexpr uint32_t kParallelBuildTriangles = 65536; // Nodes at least this large build their halves in parallel
+static constexpr int kParallelBuildDepth = 6;              // Up to 64 subtrees in flight
+
+static float SurfaceArea(const AABB& box)
+{
+    if (!box.IsValid()) return 0.0f;
+    glm::vec3 size = box.max - box.min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+void BVH::Clear()
+{
+    nodes.clear();
+    triangleOrder.clear();
+    UpdateMemoryUsage();
+}
+
+void BVH::UpdateMemoryUsage()
+{
+    m_memory.Set(nodes.capacity() * sizeof(Node) + triangleOrder.capacity() * sizeof(uint32_t) +
+        m_triangleBounds.capacity() * sizeof(AABB) + m_centroids.capacity() * sizeof(glm::vec3));
+}
+
+void BVH::Build(const Mesh& mesh)
+{
+    PROFILE_SCOPE("BVH build");
+    Clear();
+
+    uint32_t triangleCount = static_cast<uint32_t>(mesh.indices.size() / 3);
+    if (triangleCount == 0) return;
+
+    // Bounds and centroids of every triangle, the split search only looks at these. Large meshes
+    // fill them in parallel chunks, the tree below also builds its top levels on the pool.
+    m_triangleBounds.resize(triangleCount);
+    m_centroids.resize(triangleCount);
+    triangleOrder.resize(triangleCount);
+    ThreadPool& pool = ThreadPool::Global();
+    pool.ParallelFor(triangleCount, std::max<size_t>(1, triangleCount / kParallelBuildTriangles), [&](size_t first, size_t last, size_t) {
+        for (size_t i = first; i < last; ++i) {
+            AABB box;
+            box.Expand(mesh.vertices[mesh.indices[i * 3]].position);
+            box.Expand(mesh.vertices[mesh.indices[i * 3 + 1]].position);
+            box.Expand(mesh.vertices[mesh.indices[i * 3 + 2]].position);
+            m_triangleBounds[i] = box;
+            m_centroids[i] = box.Center();
+            triangleOrder[i] = static_cast<uint32_t>(i);
+        }
+    });
+
+    // A binary tree with leaves of at least one triangle never has more than 2n - 1 nodes
+    nodes.reserve(2 * triangleCount);
+    UpdateMemoryUsage();  // The build peak: scratch and the reserved tree at once
+    BuildRecursive(nodes, 0, triangleCount, 0);
+
+    m_triangleBounds.clear();
+    m_triangleBounds.shrink_to_fit();
+    m_centroids.clear();
+    m_centroids.shrink_to_fit();
+    UpdateMemoryUsage();
+}
+
+uint32_t BVH::BuildRecursive(std::vector<Node>& out, uint32_t first, uint32_t count, int depth)
+{
+    uint32_t nodeIndex = static_cast<uint32_t>(out.size());
+    out.emplace_back();
+
+    AABB bounds, centroidBounds;
+    for (uint32_t i = first; i < first + count; ++i) {
+        bounds.Expand(m_triangleBounds[triangleOrder[i]]);
+        centroidBounds.Expand(m_centroids[triangleOrder[i]]);
+    }
+    out[nodeIndex].bounds = bounds;
+
+    auto makeLeaf = [&]() {
+        out[nodeIndex].first = first;
+        out[nodeIndex].count = count;
+        return nodeIndex;
+    };
+
+    if (count <= kMaxLeafTriangles || depth >= kMaxDepth) return makeLeaf();
+
+    // Split along the longest axis of the centroid bounds
+    glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+    if (extent[axis] <= 0.0f) return makeLeaf(); // All centroids coincide
+
+    // Bin the triangles and evaluate the surface area heuristic at every bin border
+    struct Bin { AABB bounds; uint32_t count = 0; };
+    Bin bins[kBinCount];
+    float binScale = kBinCount / extent[axis];
+    auto binOf = [&](uint32_t triangle) {
+        int bin = static_cast<int>((m_centroids[triangle][axis] - centroidBounds.min[axis]) * binScale);
+        return std::min(bin, kBinCount - 1);
+    };
+    for (uint32_t i = first; i < first + count; ++i) {
+        Bin& bin = bins[binOf(triangleOrder[i])];
+        bin.bounds.Expand(m_triangleBounds[triangleOrder[i]]);
+        bin.count++;
+    }
+
+    float leftArea[kBinCount - 1];
+    uint32_t leftCount[kBinCount - 1];
+    AABB sweep;
+    uint32_t sweepCount = 0;
+    for (int i = 0; i < kBinCount - 1; ++i) {
+        sweep.Expand(bins[i].bounds);
+        sweepCount += bins[i].count;
+        leftArea[i] = SurfaceArea(sweep);
+        leftCount[i] = sweepCount;
+    }
+
+    float bestCost = FLT_MAX;
+    int bestSplit = -1;
+    sweep = AABB();
+    sweepCount = 0;
+    for (int i = kBinCount - 1; i > 0; --i) {
+        sweep.Expand(bins[i].bounds);
+        sweepCount += bins[i].count;
+        if (leftCount[i - 1] == 0 || sweepCount == 0) continue;
+
+        float cost = leftArea[i - 1] * leftCount[i - 1] + SurfaceArea(sweep) * sweepCount;
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestSplit = i;
+        }
+    }
+
+    // Splitting must be cheaper than testing every triangle of this node
+    if (bestSplit < 0 || bestCost >= SurfaceArea(bounds) * count) {
+        if (count <= kMaxLeafTriangles * 4) return makeLeaf();
+
+        // Large node without a useful split, fall back to a median split
+        uint32_t* begin = triangleOrder.data() + first;
+        std::nth_element(begin, begin + count / 2, begin + count, [&](uint32_t a, uint32_t b) {
+            return m_centroids[a][axis] < m_centroids[b][axis];
+        });
+        bestSplit = -1;
+    }
+
+    uint32_t middle;
+    if (bestSplit >= 0) {
+        uint32_t* splitPoint = std::partition(triangleOrder.data() + first, triangleOrder.data() + first + count,
+            [&](uint32_t triangle) { return binOf(triangle) < bestSplit; });
+        middle = static_cast<uint32_t>(splitPoint - triangleOrder.data());
+    }
+    else {
+        middle = first + count / 2;
+    }
+
+    uint32_t right;
+    if (count >= kParallelBuildTriangles && depth < kParallelBuildDepth) {
+        // The halves touch disjoint ranges of triangleOrder. The right one builds into its own array,
+        // possibly on another thread, and is appended after the left so the layout matches a serial build.
+        std::vector<Node> rightNodes;
+        ThreadPool::Global().ParallelFor(2, 2, [&](size_t half, size_t, size_t) {
+            if (half == 0) BuildRecursive(out, first, middle - first, depth + 1);
+            else BuildRecursive(rightNodes, middle, first + count - middle, depth + 1);
+        });
+
+        right = static_cast<uint32_t>(out.size());
+        for (Node node : rightNodes) {
+            if (node.count == 0) node.first += right; // Inner nodes point at their right child
+            out.push_back(node);
+        }
+    }
+    else {
+        BuildRecursive(out, first, middle - first, depth + 1);
+        right = BuildRecursive(out, middle, first + count - middle, depth + 1);
+    }
+
+    // out may have been reallocated by the recursion
+    out[nodeIndex].first = right;
+    out[nodeIndex].count = 0;
+    return nodeIndex;
+}
+
+bool BVH::Raycast(const Mesh& mesh, const glm::vec3& origin, const glm::vec3& direction, RayHit& hit) const
+{
+    if (nodes.empty()) return false;
+
+    glm::vec3 inverseDirection = 1.0f / direction;
+    bool found = false;
+
+    uint32_t stack[kTraversalStackSize];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const Node& node = nodes[stack[--stackSize]];
+        if (RayIntersectsAABB(node.bounds, origin, inverseDirection, hit.distance) == FLT_MAX) continue;
+
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                uint32_t triangle = triangleOrder[i];
+                float t;
+                if (RayIntersectsTriangle(origin, direction,
+                    mesh.vertices[mesh.indices[triangle * 3]].position,
+                    mesh.vertices[mesh.indices[triangle * 3 + 1]].position,
+                    mesh.vertices[mesh.indices[triangle * 3 + 2]].position, t) && t < hit.distance) {
+                    hit.distance = t;
+                    hit.triangleIndex = static_cast<int>(triangle);
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so the far one is usually rejected by the shortened ray
+        uint32_t left = static_cast<uint32_t>(&node - nodes.data()) + 1;
+        uint32_t right = node.first;
+        float leftDistance = RayIntersectsAABB(nodes[left].bounds, origin, inverseDirection, hit.distance);
+        float rightDistance = RayIntersectsAABB(nodes[right].bounds, origin, inverseDirection, hit.distance);
+        if (leftDistance > rightDistance) {
+            std::swap(left, right);
+            std::swap(leftDistance, rightDistance);
+        }
+        if (rightDistance != FLT_MAX) stack[stackSize++] = right;
+        if (leftDistance != FLT_MAX) stack[stackSize++] = left;
+    }
+
+    if (found) hit.point = origin + direction * hit.distance;
+    return found;
+}
+
+void BVH::QueryFrustum(const Mesh& mesh, const Frustum& frustum, std::vector<uint32_t>& triangles) const
+{
+    if (nodes.empty()) return;
+
+    // Each entry carries whether an ancestor was already completely inside
+    struct Entry { uint32_t node; bool inside; };
+    Entry stack[kTraversalStackSize];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, false };
+
+    while (stackSize > 0) {
+        Entry entry = stack[--stackSize];
+        const Node& node = nodes[entry.node];
+
+        bool inside = entry.inside;
+        if (!inside) {
+            FrustumTest test = frustum.Classify(node.bounds);
+            if (test == FrustumTest::Outside) continue;
+            inside = (test == FrustumTest::Inside);
+        }
+
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                uint32_t triangle = triangleOrder[i];
+                if (!inside) {
+                    glm::vec3 centroid = (mesh.vertices[mesh.indices[triangle * 3]].position +
+                                          mesh.vertices[mesh.indices[triangle * 3 + 1]].position +
+                                          mesh.vertices[mesh.indices[triangle * 3 + 2]].position) / 3.0f;
+                    if (!frustum.Contains(centroid)) continue;
+                }
+                triangles.push_back(triangle);
+            }
+            continue;
+        }
+
+        stack[stackSize++] = { node.first, inside };
+        stack[stackSize++] = { entry.node + 1, inside };
+    }
+}
+
+void BVH::QuerySphere(const Mesh& mesh, const glm::vec3& center, float radius, std::vector<uint32_t>& triangles) const
+{
+    if (nodes.empty()) return;
+
+    float radiusSquared = radius * radius;
+    auto touchesBox = [&](const AABB& box) {
+        glm::vec3 offset = center - glm::clamp(center, box.min, box.max);
+        return glm::dot(offset, offset) <= radiusSquared;
+    };
+
+    uint32_t stack[kTraversalStackSize];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        uint32_t nodeIndex = stack[--stackSize];
+        const Node& node = nodes[nodeIndex];
+        if (!touchesBox(node.bounds)) continue;
+
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                uint32_t triangle = triangleOrder[i];
+                glm::vec3 closest = ClosestPointOnTriangle(center,
+                    mesh.vertices[mesh.indices[triangle * 3]].position,
+                    mesh.vertices[mesh.indices[triangle * 3 + 1]].position,
+                    mesh.vertices[mesh.indices[triangle * 3 + 2]].position);
+                glm::vec3 offset = center - closest;
+                if (glm::dot(offset, offset) <= radiusSquared) {
+                    triangles.push_back(triangle);
+                }
+            }
+            continue;
+        }
+
+        stack[stackSize++] = node.first;
+        stack[stackSize++] = nodeIndex + 1;
+    }
+}
+
+float RayIntersectsAABB(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+{
+    glm::vec3 t0 = (box.min - origin) * inverseDirection;
+    glm::vec3 t1 = (box.max - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+
+    float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+    return entry <= exit ? entry : FLT_MAX;
+}
+
+glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    // Walk the Voronoi regions of the vertices and edges before falling back to the face
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+    glm::vec3 ap = p - a;
+    float d1 = glm::dot(ab, ap);
+    float d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp);
+    float d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp);
+    float d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+
+    // Inside the face, degenerate triangles end up here with a zero denominator
+    float sum = va + vb + vc;
+    if (sum == 0.0f) return a;
+    float v = vb / sum;
+    float w = vc / sum;
+    return a + ab * v + ac * w;
+}
+
+bool RayIntersectsTriangle(const glm::vec3& origin, const glm::vec3& direction,
+    const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& t)
+{
+    const float epsilon = 1e-9f;
+
+    glm::vec3 edge1 = v1 - v0;
+    glm::vec3 edge2 = v2 - v0;
+    glm::vec3 p = glm::cross(direction, edge2);
+    float determinant = glm::dot(edge1, p);
+    if (std::abs(determinant) < epsilon) return false; // Ray parallel to the triangle
+
+    float inverseDeterminant = 1.0f / determinant;
+    glm::vec3 s = origin - v0;
+    float u = glm::dot(s, p) * inverseDeterminant;
+    if (u < 0.0f || u > 1.0f) return false;
+
+    glm::vec3 q = glm::cross(s, edge1);
+    float v = glm::dot(direction, q) * inverseDeterminant;
+    if (v < 0.0f || u + v > 1.0f) return false;
+
+    t = glm::dot(edge2, q) * inverseDeterminant;
+    return t > 0.0f;
+}
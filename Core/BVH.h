@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Culling.h"
+#include "MemoryTracker.h"
+
+class Mesh;
+
+// Closest intersection returned by a ray query
+struct RayHit {
+    int meshIndex = -1;
+    int triangleIndex = -1;
+    glm::vec3 point = glm::vec3(0.0f);  // World space hit position
+    float distance = FLT_MAX;           // Distance along the ray in world units
+};
+
+// Bounding volume hierarchy over the triangles of one mesh, built in model space.
+// Nodes are stored depth first in a flat array, the left child always follows its parent.
+class BVH {
+public:
+    struct Node {
+        AABB bounds;
+        uint32_t first = 0;  // Leaf: first entry in triangleOrder, inner node: index of the right child
+        uint32_t count = 0;  // Number of triangles in a leaf, 0 for inner nodes
+    };
+
+    // Builds the hierarchy with a binned surface area heuristic
+    void Build(const Mesh& mesh);
+    void Clear();
+    bool IsBuilt() const { return !nodes.empty(); }
+
+    // Closest hit along origin + t * direction for t in (0, hit.distance), both in model space.
+    // The direction does not need to be normalized, t is reported in its units.
+    bool Raycast(const Mesh& mesh, const glm::vec3& origin, const glm::vec3& direction, RayHit& hit) const;
+
+    // Appends every triangle whose centroid lies inside the frustum, which must be in model space.
+    // Nodes completely inside the frustum are taken without testing their triangles.
+    void QueryFrustum(const Mesh& mesh, const Frustum& frustum, std::vector<uint32_t>& triangles) const;
+
+    // Appends every triangle that touches the sphere, center and radius in model space
+    void QuerySphere(const Mesh& mesh, const glm::vec3& center, float radius, std::vector<uint32_t>& triangles) const;
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> triangleOrder;  // Triangle indices grouped by leaf
+
+private:
+    // Appends the subtree over triangleOrder[first, first + count) to out, returns its root index
+    uint32_t BuildRecursive(std::vector<Node>& out, uint32_t first, uint32_t count, int depth);
+    // Reports the capacity of the tree and the scratch arrays to the BVH category
+    void UpdateMemoryUsage();
+
+    // Scratch data only needed while building
+    std::vector<AABB> m_triangleBounds;
+    std::vector<glm::vec3> m_centroids;
+
+    MemoryAccount m_memory{ MemoryCategory::BVH };
+};
+
+// Slab test, returns the entry distance or FLT_MAX if the ray misses the box
+float RayIntersectsAABB(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance);
+
+// Point of the triangle nearest to p (Ericson, Real-Time Collision Detection 5.1.5)
+glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+
+// Moller-Trumbore ray/triangle test, both sides of the triangle are hit
+bool RayIntersectsTriangle(const glm::vec3& origin, const glm::vec3& direction,
+    const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& t);
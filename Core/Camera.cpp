@@ -16,6 +16,33 @@ Camera::Camera(int width, int height)
 	Up = glm::vec3(0.0f, 1.0f, 0.0f);
 }
 
+glm::mat4 Camera::GetViewMatrix() const
+{
+	return glm::lookAt(Position, Position + Orientation, Up);
+}
+
+glm::mat4 Camera::GetProjectionMatrix() const
+{
+	return glm::perspective(glm::radians(fov), (float)width / height, nearPlane, farPlane);
+}
+
+void Camera::ScreenPointToRay(double x, double y, int viewportWidth, int viewportHeight, glm::vec3& origin, glm::vec3& direction) const
+{
+	// Window coordinates start top left, normalized device coordinates bottom left
+	float ndcX = static_cast<float>(2.0 * x / viewportWidth - 1.0);
+	float ndcY = static_cast<float>(1.0 - 2.0 * y / viewportHeight);
+
+	// Unproject the pixel on the near and far plane
+	glm::mat4 inverseViewProjection = glm::inverse(GetProjectionMatrix() * GetViewMatrix());
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+	nearPoint /= nearPoint.w;
+	farPoint /= farPoint.w;
+
+	origin = glm::vec3(nearPoint);
+	direction = glm::normalize(glm::vec3(farPoint - nearPoint));
+}
+
 void Camera::Matrix(float FOVdeg, float nearPlane, float farPlane, Shader& shader, const char* uniform)
 {
 	// Initializes matrices since otherwise they will be the null matrix
@@ -31,8 +58,11 @@ void Camera::Matrix(float FOVdeg, float nearPlane, float farPlane, Shader& shade
 	glUniformMatrix4fv(glGetUniformLocation(shader.ID, uniform), 1, GL_FALSE, glm::value_ptr(projection * view));
 }
 
-void Camera::Inputs(GLFWwindow* window)
+bool Camera::Inputs(GLFWwindow* window)
 {
+	glm::vec3 oldPosition = Position;
+	glm::vec3 oldOrientation = Orientation;
+
 	// Handles key inputs
 	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
 	{
@@ -113,4 +143,6 @@ void Camera::Inputs(GLFWwindow* window)
 		// Makes sure the next time the camera looks around it doesn't jump
 		firstClick = true;
 	}
+
+	return Position != oldPosition || Orientation != oldOrientation;
 }
\ No newline at end of file
@@ -9,7 +9,7 @@
 #include<glm/gtx/rotate_vector.hpp>
 #include<glm/gtx/vector_angle.hpp>
 
-#include "shaderClass.h"
+#include "ShaderClass.h"
 
 class Camera
 {
@@ -41,9 +41,16 @@ public:
 	// Camera constructor to set up initial values
 	Camera(int width, int height);
 
+	// View and projection matrices for the current camera state
+	glm::mat4 GetViewMatrix() const;
+	glm::mat4 GetProjectionMatrix() const;
+
+	// World space ray through a window pixel, starts on the near plane with a normalized direction
+	void ScreenPointToRay(double x, double y, int viewportWidth, int viewportHeight, glm::vec3& origin, glm::vec3& direction) const;
+
 	// Updates and exports the camera matrix to the Vertex Shader
 	void Matrix(float FOVdeg, float nearPlane, float farPlane, Shader& shader, const char* uniform);
-	// Handles camera inputs
-	void Inputs(GLFWwindow* window);
+	// Handles camera inputs, returns true if the camera moved
+	bool Inputs(GLFWwindow* window);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+
+// Neumaier's compensated summation. The rounding error of every addition is carried in a second
+// term, so long sums keep close to full double precision instead of drifting with the number of
+// terms. The last bit still depends on the order of the additions: reproducible callers add in a
+// fixed order and merge partial sums with PairwiseSum.
+class CompensatedSum {
+public:
+    void Add(double value)
+    {
+        double sum = m_sum + value;
+        if (std::abs(m_sum) >= std::abs(value)) m_compensation += (m_sum - sum) + value;
+        else m_compensation += (value - sum) + m_sum;
+        m_sum = sum;
+    }
+    void Add(const CompensatedSum& other)
+    {
+        Add(other.m_sum);
+        m_compensation += other.m_compensation;
+    }
+    double Get() const { return m_sum + m_compensation; }
+
+private:
+    double m_sum = 0.0;
+    double m_compensation = 0.0;
+};
+
+// Real and imaginary parts summed separately, for fields
+class CompensatedComplexSum {
+public:
+    void Add(const std::complex<double>& value)
+    {
+        m_real.Add(value.real());
+        m_imag.Add(value.imag());
+    }
+    void Add(const CompensatedComplexSum& other)
+    {
+        m_real.Add(other.m_real);
+        m_imag.Add(other.m_imag);
+    }
+    std::complex<double> Get() const { return { m_real.Get(), m_imag.Get() }; }
+
+private:
+    CompensatedSum m_real;
+    CompensatedSum m_imag;
+};
+
+// Merges partial sums as a balanced binary tree split at count / 2. The tree only depends on
+// count, so partials from fixed chunks give the same bits whichever threads computed them.
+template<typename Sum>
+Sum PairwiseSum(const Sum* partials, size_t count)
+{
+    if (count == 0) return Sum();
+    if (count == 1) return partials[0];
+    size_t half = count / 2;
+    Sum sum = PairwiseSum(partials, half);
+    sum.Add(PairwiseSum(partials + half, count - half));
+    return sum;
+}
@@ -0,0 +1,235 @@
+#include "Culling.h"
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Clip space w below this value is treated as touching the camera plane
+static constexpr float kMinClipW = 1e-5f;
+
+void AABB::Expand(const glm::vec3& point)
+{
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+}
+
+void AABB::Expand(const AABB& other)
+{
+    if (!other.IsValid()) return;
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+}
+
+AABB AABB::Transformed(const glm::mat4& matrix) const
+{
+    if (!IsValid()) return AABB();
+
+    // Transform the center and project the extent onto the new axes (Arvo's method)
+    glm::vec3 center = glm::vec3(matrix * glm::vec4(Center(), 1.0f));
+    glm::vec3 extent = Extent();
+
+    glm::vec3 newExtent(0.0f);
+    for (int row = 0; row < 3; ++row) {
+        newExtent[row] = std::abs(matrix[0][row]) * extent.x +
+                         std::abs(matrix[1][row]) * extent.y +
+                         std::abs(matrix[2][row]) * extent.z;
+    }
+
+    AABB result;
+    result.min = center - newExtent;
+    result.max = center + newExtent;
+    return result;
+}
+
+void Frustum::Update(const glm::mat4& viewProjection)
+{
+    // Gribb-Hartmann plane extraction, GLM matrices are column major so m[col][row]
+    auto row = [&](int r) {
+        return glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+    };
+
+    planes[0] = row(3) + row(0); // Left
+    planes[1] = row(3) - row(0); // Right
+    planes[2] = row(3) + row(1); // Bottom
+    planes[3] = row(3) - row(1); // Top
+    planes[4] = row(3) + row(2); // Near
+    planes[5] = row(3) - row(2); // Far
+
+    for (auto& plane : planes) {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f) plane /= length;
+    }
+}
+
+bool Frustum::Intersects(const AABB& box) const
+{
+    if (!box.IsValid()) return false;
+
+    for (const auto& plane : planes) {
+        // Pick the box corner furthest along the plane normal
+        glm::vec3 positive(
+            plane.x >= 0.0f ? box.max.x : box.min.x,
+            plane.y >= 0.0f ? box.max.y : box.min.y,
+            plane.z >= 0.0f ? box.max.z : box.min.z
+        );
+
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+FrustumTest Frustum::Classify(const AABB& box) const
+{
+    if (!box.IsValid()) return FrustumTest::Outside;
+
+    FrustumTest result = FrustumTest::Inside;
+    for (const auto& plane : planes) {
+        glm::vec3 normal(plane);
+
+        // Corner furthest along the normal decides outside, the nearest one decides inside
+        glm::vec3 positive = glm::mix(box.min, box.max, glm::vec3(glm::greaterThanEqual(normal, glm::vec3(0.0f))));
+        glm::vec3 negative = glm::mix(box.max, box.min, glm::vec3(glm::greaterThanEqual(normal, glm::vec3(0.0f))));
+
+        if (glm::dot(normal, positive) + plane.w < 0.0f) return FrustumTest::Outside;
+        if (glm::dot(normal, negative) + plane.w < 0.0f) result = FrustumTest::Intersecting;
+    }
+    return result;
+}
+
+bool Frustum::Contains(const glm::vec3& point) const
+{
+    for (const auto& plane : planes) {
+        if (glm::dot(glm::vec3(plane), point) + plane.w < 0.0f) return false;
+    }
+    return true;
+}
+
+OcclusionBuffer::OcclusionBuffer(int width, int height) :
+    width(width),
+    height(height),
+    m_depth(static_cast<size_t>(width) * height, 1.0f)
+{
+}
+
+void OcclusionBuffer::Clear(const glm::mat4& viewProjection)
+{
+    m_viewProjection = viewProjection;
+    std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+}
+
+void OcclusionBuffer::RasterizeOccluder(const Mesh& mesh)
+{
+    const glm::mat4 mvp = m_viewProjection * mesh.GetModelMatrix();
+
+    // Transform every vertex once, triangles then only index into this array
+    m_clipVertices.resize(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        m_clipVertices[i] = mvp * glm::vec4(mesh.vertices[i].position, 1.0f);
+    }
+
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        const glm::vec4& c0 = m_clipVertices[mesh.indices[i]];
+        const glm::vec4& c1 = m_clipVertices[mesh.indices[i + 1]];
+        const glm::vec4& c2 = m_clipVertices[mesh.indices[i + 2]];
+
+        // Triangles touching the camera plane are skipped instead of clipped,
+        // dropping occluder area is always safe
+        if (c0.w < kMinClipW || c1.w < kMinClipW || c2.w < kMinClipW) continue;
+
+        // Viewport transform
+        glm::vec3 p0((c0.x / c0.w * 0.5f + 0.5f) * width, (c0.y / c0.w * 0.5f + 0.5f) * height, c0.z / c0.w * 0.5f + 0.5f);
+        glm::vec3 p1((c1.x / c1.w * 0.5f + 0.5f) * width, (c1.y / c1.w * 0.5f + 0.5f) * height, c1.z / c1.w * 0.5f + 0.5f);
+        glm::vec3 p2((c2.x / c2.w * 0.5f + 0.5f) * width, (c2.y / c2.w * 0.5f + 0.5f) * height, c2.z / c2.w * 0.5f + 0.5f);
+
+        float area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+        if (std::abs(area) < 1e-8f) continue;
+        float invArea = 1.0f / area;
+
+        int minX = std::max(0, static_cast<int>(std::floor(std::min({ p0.x, p1.x, p2.x }))));
+        int maxX = std::min(width - 1, static_cast<int>(std::ceil(std::max({ p0.x, p1.x, p2.x }))));
+        int minY = std::max(0, static_cast<int>(std::floor(std::min({ p0.y, p1.y, p2.y }))));
+        int maxY = std::min(height - 1, static_cast<int>(std::ceil(std::max({ p0.y, p1.y, p2.y }))));
+
+        for (int y = minY; y <= maxY; ++y) {
+            float py = y + 0.5f;
+            for (int x = minX; x <= maxX; ++x) {
+                float px = x + 0.5f;
+
+                // Barycentric weights from edge functions, sign follows the winding
+                float w0 = ((p2.x - p1.x) * (py - p1.y) - (p2.y - p1.y) * (px - p1.x)) * invArea;
+                float w1 = ((p0.x - p2.x) * (py - p2.y) - (p0.y - p2.y) * (px - p2.x)) * invArea;
+                float w2 = 1.0f - w0 - w1;
+                if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+                float depth = w0 * p0.z + w1 * p1.z + w2 * p2.z;
+                float& stored = m_depth[static_cast<size_t>(y) * width + x];
+                if (depth < stored) stored = depth;
+            }
+        }
+    }
+}
+
+bool OcclusionBuffer::ProjectBox(const AABB& worldBox, glm::vec2& screenMin, glm::vec2& screenMax, float& nearestDepth) const
+{
+    screenMin = glm::vec2(FLT_MAX);
+    screenMax = glm::vec2(-FLT_MAX);
+    nearestDepth = 1.0f;
+
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec3 point(
+            (corner & 1) ? worldBox.max.x : worldBox.min.x,
+            (corner & 2) ? worldBox.max.y : worldBox.min.y,
+            (corner & 4) ? worldBox.max.z : worldBox.min.z
+        );
+
+        glm::vec4 clip = m_viewProjection * glm::vec4(point, 1.0f);
+        if (clip.w < kMinClipW) return false;
+
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        glm::vec2 screen((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height);
+        screenMin = glm::min(screenMin, screen);
+        screenMax = glm::max(screenMax, screen);
+        nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+    }
+    return true;
+}
+
+bool OcclusionBuffer::IsVisible(const AABB& worldBox) const
+{
+    glm::vec2 screenMin, screenMax;
+    float nearestDepth;
+
+    // Boxes crossing the camera plane are always visible
+    if (!ProjectBox(worldBox, screenMin, screenMax, nearestDepth)) return true;
+
+    int minX = std::max(0, static_cast<int>(std::floor(screenMin.x)));
+    int maxX = std::min(width - 1, static_cast<int>(std::ceil(screenMax.x)));
+    int minY = std::max(0, static_cast<int>(std::floor(screenMin.y)));
+    int maxY = std::min(height - 1, static_cast<int>(std::ceil(screenMax.y)));
+    if (minX > maxX || minY > maxY) return true;
+
+    for (int y = minY; y <= maxY; ++y) {
+        for (int x = minX; x <= maxX; ++x) {
+            if (m_depth[static_cast<size_t>(y) * width + x] >= nearestDepth) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+float OcclusionBuffer::ScreenCoverage(const AABB& worldBox) const
+{
+    glm::vec2 screenMin, screenMax;
+    float nearestDepth;
+
+    // A box around the camera covers the whole screen
+    if (!ProjectBox(worldBox, screenMin, screenMax, nearestDepth)) return 1.0f;
+
+    screenMin = glm::clamp(screenMin, glm::vec2(0.0f), glm::vec2((float)width, (float)height));
+    screenMax = glm::clamp(screenMax, glm::vec2(0.0f), glm::vec2((float)width, (float)height));
+    glm::vec2 size = screenMax - screenMin;
+    return (size.x * size.y) / (static_cast<float>(width) * height);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <cfloat>
+#include <glm/glm.hpp>
+
+class Mesh;
+
+// Axis-aligned bounding box used for culling and spatial queries
+struct AABB {
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    bool IsValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+    void Expand(const glm::vec3& point);
+    void Expand(const AABB& other);
+    glm::vec3 Center() const { return (min + max) * 0.5f; }
+    glm::vec3 Extent() const { return (max - min) * 0.5f; }
+
+    // Returns the box that encloses this box after applying the transform
+    AABB Transformed(const glm::mat4& matrix) const;
+};
+
+// Result of classifying a box against a frustum
+enum class FrustumTest {
+    Outside,
+    Intersecting,
+    Inside
+};
+
+// View frustum described by six inward facing planes (ax + by + cz + d >= 0 is inside)
+class Frustum {
+public:
+    // Extracts the planes from a combined projection * view (* model) matrix
+    void Update(const glm::mat4& viewProjection);
+
+    // Conservative test, returns false only if the box is completely outside
+    bool Intersects(const AABB& box) const;
+
+    // Like Intersects, but also reports boxes that are completely inside
+    FrustumTest Classify(const AABB& box) const;
+
+    bool Contains(const glm::vec3& point) const;
+
+    glm::vec4 planes[6];
+};
+
+// Low resolution software depth buffer used for coarse occlusion culling.
+// Large occluders are rasterized with their real triangles, occludees are
+// tested with the screen rectangle and nearest depth of their bounding box.
+class OcclusionBuffer {
+public:
+    OcclusionBuffer(int width = 256, int height = 128);
+
+    void Clear(const glm::mat4& viewProjection);
+
+    // Rasterizes all triangles of the mesh into the depth buffer
+    void RasterizeOccluder(const Mesh& mesh);
+
+    // Returns false only if every covered pixel is closer than the box
+    bool IsVisible(const AABB& worldBox) const;
+
+    // Returns the fraction of the screen covered by the projected box (0 - 1)
+    float ScreenCoverage(const AABB& worldBox) const;
+
+    int width;
+    int height;
+
+private:
+    // Projects the box to the screen, returns false if it crosses the camera plane
+    bool ProjectBox(const AABB& worldBox, glm::vec2& screenMin, glm::vec2& screenMax, float& nearestDepth) const;
+
+    glm::mat4 m_viewProjection = glm::mat4(1.0f);
+    std::vector<float> m_depth;
+    std::vector<glm::vec4> m_clipVertices; // Scratch storage reused between occluders
+};
@@ -0,0 +1,74 @@
+#include "GpuTimer.h"
+#include "Profiler.h"
+
+const char* GpuPassName(GpuPass pass)
+{
+    switch (pass) {
+    case GpuPass::Grid: return "GPU grid";
+    case GpuPass::Axes: return "GPU axes";
+    case GpuPass::Scene: return "GPU scene";
+    case GpuPass::Picking: return "GPU picking";
+    case GpuPass::ImGui: return "GPU ImGui";
+    default: return "GPU";
+    }
+}
+
+GpuPassTimer::~GpuPassTimer()
+{
+    for (auto& set : m_queries) {
+        for (auto& query : set) {
+            if (query.id != 0) glDeleteQueries(1, &query.id);
+        }
+    }
+}
+
+void GpuPassTimer::Init()
+{
+    for (auto& set : m_queries) {
+        for (auto& query : set) {
+            glGenQueries(1, &query.id);
+        }
+    }
+}
+
+void GpuPassTimer::BeginFrame()
+{
+    m_set = (m_set + 1) % kQuerySets;
+
+    for (int pass = 0; pass < kPassCount; ++pass) {
+        Query& query = m_queries[m_set][pass];
+        if (!query.pending) continue;
+
+        // Still running, Begin() leaves this pass untimed until the result is in
+        GLint available = 0;
+        glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &elapsedNs);
+        query.pending = false;
+
+        m_lastMs[pass] = static_cast<float>(elapsedNs * 1.0e-6);
+        Profiler::RecordGpu(GpuPassName(static_cast<GpuPass>(pass)), query.submitNs, query.submitNs + elapsedNs);
+    }
+}
+
+void GpuPassTimer::Begin(GpuPass pass)
+{
+    // Another pass is being timed, or this one already ran this frame (a second pick)
+    Query& query = m_queries[m_set][static_cast<int>(pass)];
+    if (query.id == 0 || m_activePass >= 0 || query.pending) return;
+
+    query.submitNs = Profiler::Now();
+    glBeginQuery(GL_TIME_ELAPSED, query.id);
+    m_activePass = static_cast<int>(pass);
+}
+
+void GpuPassTimer::End(GpuPass pass)
+{
+    if (m_activePass != static_cast<int>(pass)) return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    m_queries[m_set][m_activePass].pending = true;
+    m_activePass = -1;
+}
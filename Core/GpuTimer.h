@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+
+// Render passes timed on the GPU
+enum class GpuPass {
+    Grid, Axes, Scene, Picking, ImGui, Count
+};
+
+const char* GpuPassName(GpuPass pass);
+
+// GL_TIME_ELAPSED queries around each render pass. Two query sets alternate between frames and a
+// set is only read back when it comes round again, two frames later. If the GPU has not finished
+// it by then the pass simply goes untimed for a frame, the CPU never waits on a result.
+//
+// Finished results are kept per pass and also recorded on the profiler's GPU track. They are
+// placed at the time the pass was submitted, the GPU runs it somewhat later.
+class GpuPassTimer {
+public:
+    GpuPassTimer() {}
+    ~GpuPassTimer();
+
+    // Needs a current GL context
+    void Init();
+
+    // Collects the results of the set about to be reused, call once per frame before any pass
+    void BeginFrame();
+
+    // Passes cannot nest, GL allows one GL_TIME_ELAPSED query at a time
+    void Begin(GpuPass pass);
+    void End(GpuPass pass);
+
+    // Last measured GPU time, negative until the pass has been timed once
+    float GetMs(GpuPass pass) const { return m_lastMs[static_cast<int>(pass)]; }
+
+private:
+    static constexpr int kQuerySets = 2;
+    static constexpr int kPassCount = static_cast<int>(GpuPass::Count);
+
+    struct Query {
+        GLuint id = 0;
+        bool pending = false;    // Issued and not read back yet
+        uint64_t submitNs = 0;   // Profiler::Now() when the pass began
+    };
+    Query m_queries[kQuerySets][kPassCount];
+    int m_set = 0;
+    int m_activePass = -1;
+    float m_lastMs[kPassCount] = { -1.0f, -1.0f, -1.0f, -1.0f, -1.0f };
+};
+
+// Times the GPU work issued during its lifetime
+class GpuPassScope {
+public:
+    GpuPassScope(GpuPassTimer& timer, GpuPass pass) : m_timer(timer), m_pass(pass) { m_timer.Begin(m_pass); }
+    ~GpuPassScope() { m_timer.End(m_pass); }
+
+    GpuPassScope(const GpuPassScope&) = delete;
+    GpuPassScope& operator=(const GpuPassScope&) = delete;
+
+private:
+    GpuPassTimer& m_timer;
+    GpuPass m_pass;
+};
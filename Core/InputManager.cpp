@@ -4,14 +4,18 @@
 LeftMousePicker InputManager::m_leftMouseButton;
 int InputManager::m_mouseX = 0;
 int InputManager::m_mouseY = 0;
+std::atomic<bool> InputManager::m_redrawRequested{ true };
 
 void InputManager::MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
+    MarkEvent();
+
     if (button == GLFW_MOUSE_BUTTON_LEFT) {
         double xpos, ypos;
         glfwGetCursorPos(window, &xpos, &ypos);
 
         m_leftMouseButton.IsPressed = (action == GLFW_PRESS);
+        if (action == GLFW_PRESS) m_leftMouseButton.ClickPending = true;
         m_leftMouseButton.x = static_cast<int>(xpos);
         m_leftMouseButton.y = static_cast<int>(ypos);
 
@@ -38,3 +42,34 @@ int InputManager::GetMouseY()
 {
     return m_mouseY;
 }
+
+void InputManager::InstallEventCallbacks(GLFWwindow* window)
+{
+    // Every callback only flags that something changed, the main loop decides what to redraw
+    glfwSetCursorPosCallback(window, [](GLFWwindow*, double, double) { MarkEvent(); });
+    glfwSetScrollCallback(window, [](GLFWwindow*, double, double) { MarkEvent(); });
+    glfwSetKeyCallback(window, [](GLFWwindow*, int, int, int, int) { MarkEvent(); });
+    glfwSetCharCallback(window, [](GLFWwindow*, unsigned int) { MarkEvent(); });
+    glfwSetCursorEnterCallback(window, [](GLFWwindow*, int) { MarkEvent(); });
+    glfwSetWindowFocusCallback(window, [](GLFWwindow*, int) { MarkEvent(); });
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow*, int, int) { MarkEvent(); });
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow*) { MarkEvent(); });
+}
+
+void InputManager::RequestRedraw()
+{
+    m_redrawRequested.store(true, std::memory_order_release);
+
+    // Wakes glfwWaitEventsTimeout on the main thread
+    glfwPostEmptyEvent();
+}
+
+bool InputManager::ConsumeRedrawRequest()
+{
+    return m_redrawRequested.exchange(false, std::memory_order_acq_rel);
+}
+
+void InputManager::MarkEvent()
+{
+    m_redrawRequested.store(true, std::memory_order_release);
+}
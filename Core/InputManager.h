@@ -5,10 +5,12 @@
 
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <atomic>
 
 // Struct to track left mouse button state and click position
 struct LeftMousePicker {
     bool IsPressed = false;
+    bool ClickPending = false;  // Set on press, cleared once the click has been handled
     int x = 0;
     int y = 0;
 };
@@ -26,9 +28,21 @@ public:
     static int GetMouseX();
     static int GetMouseY();
 
+    // Render on demand: install before ImGui so its callbacks chain to ours
+    static void InstallEventCallbacks(GLFWwindow* window);
+
+    // Asks the main loop for a new frame, safe to call from any thread
+    static void RequestRedraw();
+
+    // Returns true (once) if input arrived or a redraw was requested since the last call
+    static bool ConsumeRedrawRequest();
+
 private:
+    static void MarkEvent();
+
     static int m_mouseX;
     static int m_mouseY;
+    static std::atomic<bool> m_redrawRequested;
 };
 
 #endif // INPUT_MANAGER_H
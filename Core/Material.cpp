@@ -0,0 +1,185 @@
+#include "Material.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr double kSpeedOfLight = 299792458.0;
+
+MaterialLibrary::MaterialLibrary()
+{
+    Material conductor;
+    conductor.name = "Perfect Conductor";
+    conductor.perfectConductor = true;
+    Add(conductor);
+
+    // Magnetically loaded coating on a metal skin
+    Material absorber;
+    absorber.name = "Radar Absorbing Coating";
+    absorber.permittivity = { 7.0f, -0.4f };
+    absorber.permeability = { 1.8f, -2.2f };
+    absorber.coatingThickness = 1.5e-3f;
+    Add(absorber);
+
+    Material composite;
+    composite.name = "Glass Fibre Composite";
+    composite.permittivity = { 4.4f, -0.08f };
+    Add(composite);
+
+    Material concrete;
+    concrete.name = "Concrete";
+    concrete.permittivity = { 6.0f, -0.5f };
+    Add(concrete);
+
+    BuildTables();
+}
+
+MaterialID MaterialLibrary::Add(const Material& material)
+{
+    m_materials.push_back(material);
+    m_tables.emplace_back();
+    return static_cast<MaterialID>(m_materials.size() - 1);
+}
+
+const Material& MaterialLibrary::Get(MaterialID id) const
+{
+    return id < m_materials.size() ? m_materials[id] : m_materials[0];
+}
+
+void MaterialLibrary::Set(MaterialID id, const Material& material)
+{
+    if (id >= m_materials.size()) return;
+    m_materials[id] = material;
+    m_tables[id].stale = true;
+}
+
+void MaterialLibrary::SetFrequencyRange(float minFrequency, float maxFrequency)
+{
+    if (minFrequency <= 0.0f || maxFrequency < minFrequency) return;
+    if (minFrequency == m_minFrequency && maxFrequency == m_maxFrequency) return;
+
+    m_minFrequency = minFrequency;
+    m_maxFrequency = maxFrequency;
+    for (auto& table : m_tables) {
+        table.stale = true;
+    }
+}
+
+void MaterialLibrary::BuildTables()
+{
+    bool changed = false;
+    for (size_t i = 0; i < m_tables.size(); ++i) {
+        if (!m_tables[i].stale) continue;
+        BuildTable(i);
+        changed = true;
+    }
+    if (changed) m_version++;
+}
+
+void MaterialLibrary::BuildTable(size_t index)
+{
+    ReflectionTable& table = m_tables[index];
+    table.te.resize(kAngleSamples * kFrequencySamples);
+    table.tm.resize(kAngleSamples * kFrequencySamples);
+
+    for (int f = 0; f < kFrequencySamples; ++f) {
+        double frequency = m_minFrequency + (m_maxFrequency - m_minFrequency) * f / (kFrequencySamples - 1);
+        for (int a = 0; a < kAngleSamples; ++a) {
+            double cosIncidence = static_cast<double>(a) / (kAngleSamples - 1);
+            std::complex<double> te, tm;
+            EvaluateReflection(m_materials[index], cosIncidence, frequency, te, tm);
+            table.te[f * kAngleSamples + a] = std::complex<float>(te);
+            table.tm[f * kAngleSamples + a] = std::complex<float>(tm);
+        }
+    }
+    table.stale = false;
+}
+
+void MaterialLibrary::Reflection(MaterialID id, float cosIncidence, float frequency,
+    std::complex<float>& te, std::complex<float>& tm) const
+{
+    if (id >= m_materials.size()) id = 0;
+
+    const ReflectionTable& table = m_tables[id];
+    if (table.stale) {
+        std::complex<double> exactTE, exactTM;
+        EvaluateReflection(m_materials[id], cosIncidence, frequency, exactTE, exactTM);
+        te = std::complex<float>(exactTE);
+        tm = std::complex<float>(exactTM);
+        return;
+    }
+
+    // Continuous table coordinates, clamped to the sampled range
+    float angle = std::clamp(cosIncidence, 0.0f, 1.0f) * (kAngleSamples - 1);
+    float band = (m_maxFrequency > m_minFrequency) ? (frequency - m_minFrequency) / (m_maxFrequency - m_minFrequency) : 0.0f;
+    float row = std::clamp(band, 0.0f, 1.0f) * (kFrequencySamples - 1);
+
+    int a0 = std::min(static_cast<int>(angle), kAngleSamples - 2);
+    int f0 = std::min(static_cast<int>(row), kFrequencySamples - 2);
+    float wa = angle - a0;
+    float wf = row - f0;
+
+    auto sample = [&](const std::vector<std::complex<float>>& values) {
+        const std::complex<float>* low = &values[f0 * kAngleSamples + a0];
+        const std::complex<float>* high = low + kAngleSamples;
+        std::complex<float> lowValue = low[0] + (low[1] - low[0]) * wa;
+        std::complex<float> highValue = high[0] + (high[1] - high[0]) * wa;
+        return lowValue + (highValue - lowValue) * wf;
+    };
+    te = sample(table.te);
+    tm = sample(table.tm);
+}
+
+float MaterialLibrary::NormalReflectivity(MaterialID id) const
+{
+    std::complex<float> te, tm;
+    Reflection(id, 1.0f, 0.5f * (m_minFrequency + m_maxFrequency), te, tm);
+    return std::abs(te);
+}
+
+std::vector<float> MaterialLibrary::NormalReflectivities() const
+{
+    std::vector<float> values(m_materials.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = NormalReflectivity(static_cast<MaterialID>(i));
+    }
+    return values;
+}
+
+void MaterialLibrary::EvaluateReflection(const Material& material, double cosIncidence, double frequency,
+    std::complex<double>& te, std::complex<double>& tm)
+{
+    if (material.perfectConductor) {
+        te = -1.0;
+        tm = -1.0;
+        return;
+    }
+
+    // Grazing incidence reflects everything with a phase flip, avoid dividing by zero there
+    cosIncidence = std::clamp(cosIncidence, 1e-6, 1.0);
+    double sinSquared = 1.0 - cosIncidence * cosIncidence;
+
+    std::complex<double> permittivity(material.permittivity);
+    std::complex<double> permeability(material.permeability);
+
+    // n cos(theta_t), on the branch that decays into the material
+    std::complex<double> normalIndex = std::sqrt(permittivity * permeability - sinSquared);
+    if (normalIndex.imag() > 0.0) normalIndex = -normalIndex;
+
+    // Wave impedances normal to the surface, relative to free space
+    std::complex<double> impedanceTE = permeability / normalIndex;
+    std::complex<double> impedanceTM = normalIndex / permittivity;
+
+    // A coating is a transmission line shorted by the conducting backing
+    if (material.coatingThickness > 0.0f) {
+        double wavenumber = 2.0 * 3.14159265358979323846 * frequency / kSpeedOfLight;
+        std::complex<double> j(0.0, 1.0);
+        std::complex<double> electricalLength = std::tan(wavenumber * material.coatingThickness * normalIndex);
+        impedanceTE = j * impedanceTE * electricalLength;
+        impedanceTM = j * impedanceTM * electricalLength;
+    }
+
+    double freeSpaceTE = 1.0 / cosIncidence;
+    double freeSpaceTM = cosIncidence;
+    te = (impedanceTE - freeSpaceTE) / (impedanceTE + freeSpaceTE);
+    tm = (impedanceTM - freeSpaceTM) / (impedanceTM + freeSpaceTM);
+}
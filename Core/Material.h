@@ -0,0 +1,79 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Triangles reference their material by index into the MaterialLibrary
+using MaterialID = uint16_t;
+
+// Electromagnetic description of a surface
+struct Material {
+    std::string name;
+    std::complex<float> permittivity = { 1.0f, 0.0f };  // Relative, eps' - j eps'' (exp(jwt) convention)
+    std::complex<float> permeability = { 1.0f, 0.0f };  // Relative, mu' - j mu''
+    float coatingThickness = 0.0f;   // Metres. Above 0 the material is a layer on a conducting backing,
+                                     // otherwise it fills the half space behind the surface
+    bool perfectConductor = false;   // Ignores the constitutive parameters, reflects everything
+};
+
+// Fresnel reflection coefficients of every material, sampled over the cosine of the incidence
+// angle and over frequency. The solver reads these instead of evaluating the formulas per triangle.
+class MaterialLibrary {
+public:
+    // Starts with a perfect conductor (ID 0) and a few common radar materials
+    MaterialLibrary();
+
+    MaterialID Add(const Material& material);
+    size_t Size() const { return m_materials.size(); }
+
+    // Out of range IDs fall back to the perfect conductor
+    const Material& Get(MaterialID id) const;
+
+    // Replaces a material, its table is rebuilt on the next BuildTables()
+    void Set(MaterialID id, const Material& material);
+
+    // Frequency band covered by the tables, lookups outside it are clamped to the edges
+    void SetFrequencyRange(float minFrequency, float maxFrequency);
+    float GetMinFrequency() const { return m_minFrequency; }
+    float GetMaxFrequency() const { return m_maxFrequency; }
+
+    // Recomputes the tables of changed materials. Solvers call this before their inner loops,
+    // lookups into a stale table fall back to the closed form.
+    void BuildTables();
+
+    // Bumped whenever a table changes, results cached with an older version are stale
+    uint32_t GetVersion() const { return m_version; }
+
+    // Bilinear table lookup of the TE (perpendicular) and TM (parallel) reflection coefficients.
+    // cosIncidence is the cosine between the surface normal and the direction to the source.
+    void Reflection(MaterialID id, float cosIncidence, float frequency,
+        std::complex<float>& te, std::complex<float>& tm) const;
+
+    // |reflection| at normal incidence and the centre of the band, shown by the heat map
+    float NormalReflectivity(MaterialID id) const;
+    std::vector<float> NormalReflectivities() const;
+
+    // Closed form coefficients the tables are sampled from
+    static void EvaluateReflection(const Material& material, double cosIncidence, double frequency,
+        std::complex<double>& te, std::complex<double>& tm);
+
+    static constexpr int kAngleSamples = 128;      // Uniform in cos(incidence), dense enough near grazing
+    static constexpr int kFrequencySamples = 64;
+
+private:
+    struct ReflectionTable {
+        std::vector<std::complex<float>> te;  // [frequency * kAngleSamples + angle]
+        std::vector<std::complex<float>> tm;
+        bool stale = true;
+    };
+
+    void BuildTable(size_t index);
+
+    std::vector<Material> m_materials;
+    std::vector<ReflectionTable> m_tables;
+    float m_minFrequency = 1.0e9f;
+    float m_maxFrequency = 18.0e9f;
+    uint32_t m_version = 0;
+};
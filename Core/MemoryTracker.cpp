@@ -0,0 +1,90 @@
+#include "MemoryTracker.h"
+
+#include <atomic>
+#include <cstdio>
+
+static constexpr int kCategoryCount = static_cast<int>(MemoryCategory::Count);
+
+static std::atomic<uint64_t> s_current[kCategoryCount];
+static std::atomic<uint64_t> s_peak[kCategoryCount];
+
+const char* MemoryCategoryName(MemoryCategory category)
+{
+    switch (category) {
+    case MemoryCategory::Geometry: return "Geometry";
+    case MemoryCategory::BVH: return "BVH";
+    case MemoryCategory::Solver: return "Solver";
+    case MemoryCategory::GpuBuffers: return "GPU buffers";
+    case MemoryCategory::UI: return "UI";
+    default: return "Other";
+    }
+}
+
+void MemoryTracker::Add(MemoryCategory category, uint64_t bytes)
+{
+    int index = static_cast<int>(category);
+    uint64_t current = s_current[index].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+    // Raise the peak unless another thread already raised it higher
+    uint64_t peak = s_peak[index].load(std::memory_order_relaxed);
+    while (current > peak && !s_peak[index].compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+}
+
+void MemoryTracker::Remove(MemoryCategory category, uint64_t bytes)
+{
+    s_current[static_cast<int>(category)].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::GetCurrent(MemoryCategory category)
+{
+    return s_current[static_cast<int>(category)].load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::GetPeak(MemoryCategory category)
+{
+    return s_peak[static_cast<int>(category)].load(std::memory_order_relaxed);
+}
+
+void MemoryTracker::ResetPeaks()
+{
+    for (int index = 0; index < kCategoryCount; ++index) {
+        s_peak[index].store(s_current[index].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+void MemoryTracker::Print(std::ostream& out)
+{
+    char line[128];
+    for (int index = 0; index < kCategoryCount; ++index) {
+        MemoryCategory category = static_cast<MemoryCategory>(index);
+        std::snprintf(line, sizeof(line), "  %-12s %10.2f MB  (peak %.2f MB)\n", MemoryCategoryName(category),
+            GetCurrent(category) / (1024.0 * 1024.0), GetPeak(category) / (1024.0 * 1024.0));
+        out << line;
+    }
+}
+
+MemoryAccount& MemoryAccount::operator=(const MemoryAccount& other)
+{
+    if (this == &other) return *this;
+    Set(0);
+    m_category = other.m_category;
+    Set(other.m_bytes);
+    return *this;
+}
+
+MemoryAccount& MemoryAccount::operator=(MemoryAccount&& other) noexcept
+{
+    if (this == &other) return *this;
+    Set(0);
+    m_category = other.m_category;
+    m_bytes = other.m_bytes;
+    other.m_bytes = 0;
+    return *this;
+}
+
+void MemoryAccount::Set(uint64_t bytes)
+{
+    if (bytes > m_bytes) MemoryTracker::Add(m_category, bytes - m_bytes);
+    else if (bytes < m_bytes) MemoryTracker::Remove(m_category, m_bytes - bytes);
+    m_bytes = bytes;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+// Subsystems memory is budgeted by
+enum class MemoryCategory {
+    Geometry,     // Mesh vertices, indices, triangles and the per triangle arrays
+    BVH,          // Hierarchies and their build scratch
+    Solver,       // Solver caches and shadow rasterizer buffers
+    GpuBuffers,   // GL buffers and textures, as allocated by us (the driver may pad them)
+    UI,           // ImGui allocations
+    Count
+};
+
+const char* MemoryCategoryName(MemoryCategory category);
+
+// Process wide bytes per category and their high-water marks. The numbers are what the owners
+// report through MemoryAccount, container capacities and GL allocation sizes, so they add up to
+// less than the process RSS: allocator overhead, code and driver memory are not in any category.
+class MemoryTracker {
+public:
+    static void Add(MemoryCategory category, uint64_t bytes);
+    static void Remove(MemoryCategory category, uint64_t bytes);
+
+    static uint64_t GetCurrent(MemoryCategory category);
+    static uint64_t GetPeak(MemoryCategory category);
+    // Peaks restart from the current values
+    static void ResetPeaks();
+
+    // One line per category, for logs
+    static void Print(std::ostream& out);
+};
+
+// Bytes one object holds in a category. Owners call Set() after their storage changes; the
+// destructor gives the bytes back, copies account for their own copy and moves hand them over.
+class MemoryAccount {
+public:
+    explicit MemoryAccount(MemoryCategory category) : m_category(category) {}
+    ~MemoryAccount() { Set(0); }
+
+    MemoryAccount(const MemoryAccount& other) : m_category(other.m_category) { Set(other.m_bytes); }
+    MemoryAccount(MemoryAccount&& other) noexcept : m_category(other.m_category), m_bytes(other.m_bytes) { other.m_bytes = 0; }
+    MemoryAccount& operator=(const MemoryAccount& other);
+    MemoryAccount& operator=(MemoryAccount&& other) noexcept;
+
+    void Set(uint64_t bytes);
+    uint64_t GetBytes() const { return m_bytes; }
+
+private:
+    MemoryCategory m_category;
+    uint64_t m_bytes = 0;
+};
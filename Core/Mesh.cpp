@@ -1,6 +1,19 @@
 #include "Mesh.h"
+#include "Profiler.h"
+#include "ScratchArena.h"
 #include "rapidobj.hpp"
 
+// Ends a loading stage: records it for the profiler, restarts the clock for the next stage and
+// returns the stage's milliseconds
+static float EndStage(const char* name, uint64_t& startNs)
+{
+    uint64_t now = Profiler::Now();
+    if (Profiler::IsEnabled()) Profiler::Record(name, startNs, now, Profiler::CurrentDepth());
+    float ms = static_cast<float>(now - startNs) * 1.0e-6f;
+    startNs = now;
+    return ms;
+}
+
 Mesh::Mesh(const std::string& Path) :
     position(0.0f),
     rotation(0.0f),
@@ -42,24 +55,40 @@ void Mesh::UpdateModelMatrix()
     // 3. Scale
     modelMatrix = glm::scale(modelMatrix, scale);
 
-    CalculateDimensions();
+    UpdateWorldBounds();
 }
 
 void Mesh::Clean()
 {
     // Free the GPU resources (VAO, VBO, EBO)
     if (VAO_obj != 0) {
-        glDeleteVertexArrays(1, &VAO_obj);
+        glDeleteVertexArrays(1, &VAO_obj.value);
         VAO_obj = 0;  // Set to 0 to prevent double-deletion
     }
     if (VBO_obj != 0) {
-        glDeleteBuffers(1, &VBO_obj);
+        glDeleteBuffers(1, &VBO_obj.value);
         VBO_obj = 0;  // Set to 0 to prevent double-deletion
     }
     if (EBO_obj != 0) {
-        glDeleteBuffers(1, &EBO_obj);
+        glDeleteBuffers(1, &EBO_obj.value);
         EBO_obj = 0;  // Set to 0 to prevent double-deletion
     }
+    if (selectionTexture != 0) {
+        glDeleteTextures(1, &selectionTexture.value);
+        selectionTexture = 0;
+    }
+    if (selectionBuffer != 0) {
+        glDeleteBuffers(1, &selectionBuffer.value);
+        selectionBuffer = 0;
+    }
+    if (heatMapTexture != 0) {
+        glDeleteTextures(1, &heatMapTexture.value);
+        heatMapTexture = 0;
+    }
+    if (heatMapBuffer != 0) {
+        glDeleteBuffers(1, &heatMapBuffer.value);
+        heatMapBuffer = 0;
+    }
 
     // Clean up the shader program
     if (objectShaderProgram) {
@@ -73,10 +102,21 @@ void Mesh::Clean()
 
     indices.clear();
     indices.shrink_to_fit();  // Release memory allocated by the vector
+
+    bvh.Clear();
+    bvhDirty = true;
+    adjacency = TriangleAdjacency();
+
+    gpuMemory.Set(0);
+    UpdateMemoryUsage();
 }
 
 void Mesh::LoadObjectModelFromDisk(const std::string& Path)
 {
+    PROFILE_SCOPE("Load OBJ");
+    uint64_t stageStart = Profiler::Now();
+    lastLoadTimings = MeshLoadTimings();
+
     rapidobj::Result result = rapidobj::ParseFile(Path);
     if (result.error) {
         std::cout << "Error loading OBJ: " << result.error.code.message() << '\n';
@@ -88,6 +128,16 @@ void Mesh::LoadObjectModelFromDisk(const std::string& Path)
         return;
     }
     this->fileName = this->extractFilename(Path);
+    lastLoadTimings.parseMs = EndStage("OBJ parse", stageStart);
+
+    // The parsed file and the weld map below live until the end of the load, they are what sets
+    // the geometry peak of large models
+    size_t parsedBytes = result.attributes.positions.size() * sizeof(float);
+    for (const auto& shape : result.shapes) {
+        parsedBytes += shape.mesh.indices.size() * sizeof(rapidobj::Index);
+    }
+    MemoryAccount loadScratch(MemoryCategory::Geometry);
+    loadScratch.Set(parsedBytes);
 
     // Clear previous data just in case
     vertices.clear();
@@ -123,7 +173,12 @@ void Mesh::LoadObjectModelFromDisk(const std::string& Path)
         }
     };
 
-    std::unordered_map<VertexData, unsigned int, VertexDataHash> uniqueVertices;
+    // Map nodes come from an arena sized for one node per OBJ position, which replaces a heap
+    // allocation per unique vertex with a few large blocks freed together at the end of the load
+    using WeldEntry = std::pair<const VertexData, unsigned int>;
+    ScratchArena weldArena(MemoryCategory::Geometry, estimatedVertexCount * (sizeof(WeldEntry) + 4 * sizeof(void*)) + 4096);
+    std::unordered_map<VertexData, unsigned int, VertexDataHash, std::equal_to<VertexData>, ArenaAllocator<WeldEntry>>
+        uniqueVertices(0, VertexDataHash(), std::equal_to<VertexData>(), ArenaAllocator<WeldEntry>(weldArena));
     uniqueVertices.reserve(estimatedVertexCount);
 
     // Pre-allocate indices space
@@ -165,37 +220,41 @@ void Mesh::LoadObjectModelFromDisk(const std::string& Path)
         }
     }
     this->numTriangles = indices.size() / 3;
-    this->modelMemoryMB = (vertices.size() * sizeof(Vertex) + indices.size() * sizeof(GLuint)) / (1024.0 * 1024.0);
+    UpdateMemoryUsage();
+    lastLoadTimings.weldMs = EndStage("OBJ weld", stageStart);
+
     this->UpdateTriangleData();
     this->CalculateDimensions();
+    lastLoadTimings.triangleDataMs = EndStage("Triangle data", stageStart);
     std::cout << "Object " << this->fileName << " created." << std::endl;
 }
 
 void Mesh::CalculateDimensions()
+{
+    // Calculate the bounding box in model space
+    localBounds = AABB();
+    for (const auto& vertex : vertices) {
+        localBounds.Expand(vertex.position);
+    }
+
+    UpdateWorldBounds();
+}
+
+void Mesh::UpdateWorldBounds()
 {
     // Check if we have any vertices
-    if (vertices.empty()) {
+    if (!localBounds.IsValid()) {
+        worldBounds = AABB();
         height = 0.0f;
         length = 0.0f;
         return;
     }
 
-    // Calculate the bounding box in model space
-    glm::vec3 minBounds(FLT_MAX);
-    glm::vec3 maxBounds(-FLT_MAX);
-
-    for (const auto& vertex : vertices) {
-        minBounds.x = std::min(minBounds.x, vertex.position.x);
-        minBounds.y = std::min(minBounds.y, vertex.position.y);
-        minBounds.z = std::min(minBounds.z, vertex.position.z);
-
-        maxBounds.x = std::max(maxBounds.x, vertex.position.x);
-        maxBounds.y = std::max(maxBounds.y, vertex.position.y);
-        maxBounds.z = std::max(maxBounds.z, vertex.position.z);
-    }
+    // World space box follows the model matrix without touching the vertices
+    worldBounds = localBounds.Transformed(modelMatrix);
 
     // Calculate dimensions
-    glm::vec3 dimensions = maxBounds - minBounds;
+    glm::vec3 dimensions = localBounds.max - localBounds.min;
 
     // Height is along the Y axis
     height = dimensions.y * scale.y;
@@ -238,10 +297,353 @@ void Mesh::UpdateTriangleData()
 
         triangles.push_back(tri);
     }
+
+    // Fresh triangles start unselected, the whole mask needs an upload
+    selectionMask.assign((triangles.size() + 31) / 32, 0u);
+    selectionDirty.Reset();
+    selectionDirty.Mark(0, selectionMask.size());
+    selectedTriangleCount = 0;
+
+    // Old contributions belong to a different triangulation, every triangle needs solving
+    rcsContribution.clear();
+    solverDirtyMask.assign((triangles.size() + 63) / 64, ~uint64_t(0));
+    if (triangles.size() % 64 != 0) {
+        solverDirtyMask.back() = (uint64_t(1) << (triangles.size() % 64)) - 1;
+    }
+    solverDirtyCount = triangles.size();
+    uniformMaterialDirty = true;
+    RefillHeatMap();
+
+    InvalidateBVH();
+}
+
+void Mesh::CollectWeldedEdges(std::vector<std::pair<uint64_t, uint32_t>>& edges) const
+{
+    // Weld vertices by position, split normals or colors must not split the surface
+    struct PositionHash {
+        size_t operator()(const glm::vec3& p) const {
+            size_t h = std::hash<float>()(p.x);
+            h ^= std::hash<float>()(p.y) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            h ^= std::hash<float>()(p.z) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+    std::unordered_map<glm::vec3, uint32_t, PositionHash> weldMap;
+    weldMap.reserve(vertices.size());
+    std::vector<uint32_t> weldedIndex(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        auto result = weldMap.emplace(vertices[i].position, static_cast<uint32_t>(weldMap.size()));
+        weldedIndex[i] = result.first->second;
+    }
+
+    // Every edge as (sorted vertex pair, corner), sorting brings shared edges together
+    size_t triangleCount = indices.size() / 3;
+    edges.clear();
+    edges.reserve(indices.size());
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (int e = 0; e < 3; ++e) {
+            uint64_t a = weldedIndex[indices[t * 3 + e]];
+            uint64_t b = weldedIndex[indices[t * 3 + (e + 1) % 3]];
+            if (a == b) continue; // Degenerate edge
+            edges.emplace_back((std::min(a, b) << 32) | std::max(a, b), static_cast<uint32_t>(t * 3 + e));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+}
+
+const TriangleAdjacency& Mesh::GetAdjacency()
+{
+    if (adjacency.IsBuilt() || indices.empty()) return adjacency;
+    PROFILE_SCOPE("Adjacency");
+
+    std::vector<std::pair<uint64_t, uint32_t>> edges;
+    CollectWeldedEdges(edges);
+    size_t triangleCount = indices.size() / 3;
+
+    // Count neighbours first, then fill the rows
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i;
+        while (j < edges.size() && edges[j].first == edges[i].first) ++j;
+        for (size_t a = i; a < j; ++a) {
+            for (size_t b = a + 1; b < j; ++b) {
+                uint32_t first = edges[a].second / 3;
+                uint32_t second = edges[b].second / 3;
+                if (first == second) continue;
+                pairs.emplace_back(first, second);
+            }
+        }
+        i = j;
+    }
+
+    MemoryAccount scratch(MemoryCategory::Geometry);
+    scratch.Set(edges.capacity() * sizeof(edges[0]) + pairs.capacity() * sizeof(pairs[0]));
+
+    adjacency.offsets.assign(triangleCount + 1, 0);
+    for (const auto& pair : pairs) {
+        adjacency.offsets[pair.first + 1]++;
+        adjacency.offsets[pair.second + 1]++;
+    }
+    for (size_t t = 0; t < triangleCount; ++t) {
+        adjacency.offsets[t + 1] += adjacency.offsets[t];
+    }
+
+    adjacency.neighbours.resize(adjacency.offsets[triangleCount]);
+    std::vector<uint32_t> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (const auto& pair : pairs) {
+        adjacency.neighbours[cursor[pair.first]++] = pair.second;
+        adjacency.neighbours[cursor[pair.second]++] = pair.first;
+    }
+
+    UpdateMemoryUsage();
+    return adjacency;
+}
+
+const std::vector<FeatureEdge>& Mesh::GetFeatureEdges(float angleThresholdDegrees)
+{
+    if (featureEdgeAngle == angleThresholdDegrees || indices.empty()) return featureEdges;
+    PROFILE_SCOPE("Feature edges");
+    featureEdges.clear();
+    featureEdgeAngle = angleThresholdDegrees;
+
+    std::vector<std::pair<uint64_t, uint32_t>> edges;
+    CollectWeldedEdges(edges);
+
+    auto position = [&](uint32_t corner) { return vertices[indices[corner]].position; };
+    auto nextCorner = [](uint32_t corner) { return corner - corner % 3 + (corner + 1) % 3; };
+    auto faceNormal = [&](uint32_t triangle) {
+        return glm::cross(position(triangle * 3 + 1) - position(triangle * 3), position(triangle * 3 + 2) - position(triangle * 3));
+    };
+
+    const float pi = glm::pi<float>();
+    float cosThreshold = std::cos(glm::radians(angleThresholdDegrees));
+
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i;
+        while (j < edges.size() && edges[j].first == edges[i].first) ++j;
+        size_t count = j - i;
+
+        uint32_t corner = edges[i].second;
+        FeatureEdge edge;
+        edge.vertices[0] = indices[corner];
+        edge.vertices[1] = indices[nextCorner(corner)];
+        edge.faces[0] = corner / 3;
+        edge.faces[1] = FeatureEdge::kOpenEdge;
+        edge.wedgeAngle = 0.0f;
+
+        if (count == 1) {
+            featureEdges.push_back(edge);
+        }
+        else if (count == 2) {
+            // Non manifold edges (more than two faces) have no single wedge and are skipped
+            uint32_t otherCorner = edges[i + 1].second;
+            glm::vec3 normal = faceNormal(corner / 3);
+            glm::vec3 otherNormal = faceNormal(otherCorner / 3);
+            float normalLengths = glm::length(normal) * glm::length(otherNormal);
+
+            // Consistently wound neighbours run along the shared edge in opposite directions,
+            // otherwise the other normal points the wrong way
+            if (position(otherCorner) == position(corner)) otherNormal = -otherNormal;
+
+            float cosAngle = normalLengths > 0.0f ? glm::dot(normal, otherNormal) / normalLengths : 1.0f;
+            if (cosAngle < cosThreshold) {
+                // Convex when the other face bends away behind this face's plane
+                glm::vec3 otherCentroid = (position(otherCorner - otherCorner % 3) +
+                    position(otherCorner - otherCorner % 3 + 1) + position(otherCorner - otherCorner % 3 + 2)) / 3.0f;
+                bool convex = glm::dot(normal, otherCentroid - position(corner)) < 0.0f;
+                float foldAngle = std::acos(std::clamp(cosAngle, -1.0f, 1.0f));
+
+                edge.faces[1] = otherCorner / 3;
+                edge.wedgeAngle = convex ? pi - foldAngle : pi + foldAngle;
+                featureEdges.push_back(edge);
+            }
+        }
+        i = j;
+    }
+
+    UpdateMemoryUsage();
+    return featureEdges;
+}
+
+const BVH& Mesh::GetBVH()
+{
+    if (bvhDirty) {
+        bvh.Build(*this);
+        bvhDirty = false;
+    }
+    return bvh;
 }
 
 void Mesh::SetTriangleSelected(size_t triangleIndex, bool selection)
 {
     if (triangleIndex >= triangles.size()) return;
+    if (this->triangles[triangleIndex].selected == selection) return;
     this->triangles[triangleIndex].selected = selection;
+
+    // Mirror the flag into the bitset and remember which word needs an upload
+    size_t wordIndex = triangleIndex / 32;
+    GLuint bit = 1u << (triangleIndex % 32);
+    if (selection) {
+        selectionMask[wordIndex] |= bit;
+        selectedTriangleCount++;
+    }
+    else {
+        selectionMask[wordIndex] &= ~bit;
+        selectedTriangleCount--;
+    }
+    selectionDirty.Mark(wordIndex, wordIndex + 1);
+}
+
+void Mesh::ClearSelection()
+{
+    if (selectedTriangleCount == 0) return;
+
+    for (size_t word = 0; word < selectionMask.size(); ++word) {
+        if (selectionMask[word] == 0) continue;
+
+        // Only visit the triangles whose bit is actually set
+        for (size_t bit = 0; bit < 32; ++bit) {
+            if (selectionMask[word] & (1u << bit)) {
+                triangles[word * 32 + bit].selected = false;
+            }
+        }
+        selectionMask[word] = 0;
+        selectionDirty.Mark(word, word + 1);
+    }
+    selectedTriangleCount = 0;
+}
+
+bool Mesh::IsTriangleSelected(size_t triangleIndex) const
+{
+    if (triangleIndex >= triangles.size()) return false;
+    return (selectionMask[triangleIndex / 32] >> (triangleIndex % 32)) & 1u;
+}
+
+// Returns false if the triangle already had this material, so brush strokes
+// passing over the same area do not upload or invalidate anything again
+bool Mesh::SetTriangleMaterial(size_t triangleIndex, MaterialID material)
+{
+    if (triangleIndex >= triangles.size()) return false;
+    if (triangles[triangleIndex].material == material) return false;
+    triangles[triangleIndex].material = material;
+    MarkTriangleSolverDirty(triangleIndex);
+    uniformMaterialDirty = true;
+
+    if (heatMapSource == HeatMapSource::Reflectivity) {
+        heatMapValues[triangleIndex] = MaterialReflectivity(material);
+        heatMapDirty.Mark(triangleIndex, triangleIndex + 1);
+    }
+    return true;
+}
+
+bool Mesh::GetUniformMaterial(MaterialID& material)
+{
+    if (uniformMaterialDirty) {
+        uniformMaterialID = triangles.empty() ? 0 : triangles[0].material;
+        uniformMaterial = std::all_of(triangles.begin(), triangles.end(),
+            [&](const Triangle& triangle) { return triangle.material == uniformMaterialID; });
+        uniformMaterialDirty = false;
+    }
+    material = uniformMaterialID;
+    return uniformMaterial;
+}
+
+void Mesh::SetMaterialReflectivities(const std::vector<float>& reflectivities)
+{
+    if (materialReflectivity == reflectivities) return;
+    materialReflectivity = reflectivities;
+    if (heatMapSource == HeatMapSource::Reflectivity) RefillHeatMap();
+    UpdateMemoryUsage();
+}
+
+float Mesh::MaterialReflectivity(MaterialID material) const
+{
+    // Before the library is known every material shows as a perfect reflector
+    return material < materialReflectivity.size() ? materialReflectivity[material] : 1.0f;
+}
+
+void Mesh::MarkTriangleSolverDirty(size_t triangleIndex)
+{
+    if (triangleIndex >= triangles.size()) return;
+    if (solverDirtyMask.size() * 64 < triangles.size()) {
+        solverDirtyMask.resize((triangles.size() + 63) / 64, 0);
+    }
+
+    uint64_t bit = uint64_t(1) << (triangleIndex % 64);
+    uint64_t& word = solverDirtyMask[triangleIndex / 64];
+    if ((word & bit) == 0) {
+        word |= bit;
+        solverDirtyCount++;
+    }
+}
+
+bool Mesh::IsTriangleSolverDirty(size_t triangleIndex) const
+{
+    if (triangleIndex / 64 >= solverDirtyMask.size()) return false;
+    return (solverDirtyMask[triangleIndex / 64] >> (triangleIndex % 64)) & 1u;
+}
+
+void Mesh::ClearSolverDirty()
+{
+    std::fill(solverDirtyMask.begin(), solverDirtyMask.end(), 0);
+    solverDirtyCount = 0;
+}
+
+void Mesh::SetTriangleContributions(size_t firstTriangle, const float* values, size_t count)
+{
+    if (firstTriangle >= triangles.size()) return;
+    count = std::min(count, triangles.size() - firstTriangle);
+
+    if (rcsContribution.size() != triangles.size()) {
+        rcsContribution.assign(triangles.size(), 0.0f);
+        UpdateMemoryUsage();
+    }
+    std::copy(values, values + count, rcsContribution.begin() + firstTriangle);
+
+    // Solvers write in chunks, so only the written slice is uploaded again
+    if (heatMapSource == HeatMapSource::RCSContribution) {
+        std::copy(values, values + count, heatMapValues.begin() + firstTriangle);
+        heatMapDirty.Mark(firstTriangle, firstTriangle + count);
+    }
+}
+
+void Mesh::UpdateMemoryUsage()
+{
+    auto bytes = [](const auto& container) { return static_cast<uint64_t>(container.capacity() * sizeof(container[0])); };
+    auto pageBytes = [](const DirtyPages& dirty) { return static_cast<uint64_t>(dirty.pages.capacity() / 8); };
+
+    uint64_t total = bytes(vertices) + bytes(indices) + bytes(triangles) +
+        bytes(selectionMask) + bytes(heatMapValues) + bytes(materialReflectivity) +
+        bytes(rcsContribution) + bytes(solverDirtyMask) +
+        bytes(adjacency.offsets) + bytes(adjacency.neighbours) + bytes(featureEdges) +
+        pageBytes(selectionDirty) + pageBytes(heatMapDirty);
+    geometryMemory.Set(total);
+    modelMemoryMB = static_cast<float>(total / (1024.0 * 1024.0));
+}
+
+void Mesh::SetHeatMapSource(HeatMapSource source)
+{
+    if (heatMapSource == source) return;
+    heatMapSource = source;
+    RefillHeatMap();
+}
+
+void Mesh::RefillHeatMap()
+{
+    heatMapValues.resize(triangles.size());
+
+    if (heatMapSource == HeatMapSource::Reflectivity) {
+        for (size_t i = 0; i < triangles.size(); ++i) {
+            heatMapValues[i] = MaterialReflectivity(triangles[i].material);
+        }
+    }
+    else if (rcsContribution.size() == triangles.size()) {
+        std::copy(rcsContribution.begin(), rcsContribution.end(), heatMapValues.begin());
+    }
+    else {
+        std::fill(heatMapValues.begin(), heatMapValues.end(), 0.0f);
+    }
+
+    heatMapDirty.Reset();
+    heatMapDirty.Mark(0, heatMapValues.size());
 }
@@ -3,14 +3,22 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <tuple>
 #include <unordered_map>
+#include <utility>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
 
-#include "Camera.h"
+#include "ShaderClass.h"
+#include "Culling.h"
+#include "BVH.h"
+#include "Material.h"
+#include "Primitive.h"
+#include "MemoryTracker.h"
 
 // Structure to standardize the vertices used in the meshes
 struct Vertex
@@ -19,9 +27,71 @@ struct Vertex
 	glm::vec3 color;
 };
 
+// OpenGL object name that is handed over on move, so only one mesh ever deletes it
+struct GLObjectName
+{
+	GLuint value = 0;
+
+	GLObjectName() = default;
+	GLObjectName(GLObjectName&& other) noexcept : value(std::exchange(other.value, 0)) {}
+	// Swapping hands the old name to the moved-from mesh, whose Clean() then deletes it
+	GLObjectName& operator=(GLObjectName&& other) noexcept { std::swap(value, other.value); return *this; }
+	GLObjectName& operator=(GLuint name) { value = name; return *this; }
+	operator GLuint() const { return value; }
+};
+
+// Fixed size pages of a per triangle array that changed since the last GPU upload.
+// Scattered edits (brush strokes, lasso) only upload the pages they touched,
+// a single [min, max) range would grow to the whole buffer.
+struct DirtyPages
+{
+	static constexpr size_t kPageSize = 1024; // Elements per page
+
+	std::vector<bool> pages;
+	size_t dirtyCount = 0;
+
+	bool Empty() const { return dirtyCount == 0; }
+	void Reset()
+	{
+		std::fill(pages.begin(), pages.end(), false);
+		dirtyCount = 0;
+	}
+	void Mark(size_t first, size_t last)
+	{
+		if (first >= last) return;
+		size_t lastPage = (last - 1) / kPageSize;
+		if (pages.size() <= lastPage) pages.resize(lastPage + 1, false);
+		for (size_t page = first / kPageSize; page <= lastPage; ++page) {
+			if (!pages[page]) { pages[page] = true; dirtyCount++; }
+		}
+	}
+
+	// Calls function(first, last) once per run of consecutive dirty pages, clamped to elementCount
+	template<typename Function>
+	void ForEachRun(size_t elementCount, Function function) const
+	{
+		for (size_t page = 0; page < pages.size();) {
+			if (!pages[page]) { ++page; continue; }
+			size_t runEnd = page;
+			while (runEnd < pages.size() && pages[runEnd]) ++runEnd;
+			size_t first = page * kPageSize;
+			size_t last = std::min(runEnd * kPageSize, elementCount);
+			if (first < last) function(first, last);
+			page = runEnd;
+		}
+	}
+};
+
+// Per triangle quantity shown by the heat map display mode
+enum class HeatMapSource
+{
+	Reflectivity,       // Normal incidence reflectivity of the triangle's material
+	RCSContribution
+};
+
 struct Triangle {
 	// Triangle face properties
-	float reflectivity = 1.0f;
+	MaterialID material = 0;
 	bool selected = false;
 	glm::vec3 normal = glm::vec3(0.0f, 1.0f, 0.0f);
 
@@ -38,6 +108,35 @@ struct Triangle {
 	Triangle() = default;
 };
 
+// Triangles sharing an edge, in compressed sparse rows:
+// the neighbours of triangle t are neighbours[offsets[t]] .. neighbours[offsets[t + 1] - 1]
+struct TriangleAdjacency
+{
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> neighbours;
+
+	bool IsBuilt() const { return !offsets.empty(); }
+};
+
+// Edge where the surface folds by more than a threshold angle, or an open boundary.
+// The scattering solver adds the diffraction of these edges to the facet sum.
+struct FeatureEdge
+{
+	static constexpr uint32_t kOpenEdge = UINT32_MAX;
+
+	uint32_t vertices[2];  // Endpoints in the winding order of faces[0]
+	uint32_t faces[2];     // Triangles on either side, faces[1] is kOpenEdge on a boundary
+	float wedgeAngle;      // Interior angle between the faces in radians, 0 for a boundary (knife edge)
+};
+
+// Wall clock of the stages of the last LoadObjectModelFromDisk
+struct MeshLoadTimings
+{
+	float parseMs = 0.0f;         // rapidobj parse and triangulation
+	float weldMs = 0.0f;          // Merging OBJ corners into shared vertices
+	float triangleDataMs = 0.0f;  // Normals, masks and bounds
+};
+
 class Mesh
 {
 public:
@@ -52,9 +151,21 @@ public:
 	void Clean();
 	void LoadObjectModelFromDisk(const std::string& Path);
 	void CalculateDimensions();
+	void UpdateWorldBounds();
 	std::string extractFilename(const std::string& path);
 	void UpdateTriangleData();
 	void SetTriangleSelected(size_t triangleIndex, bool selection);
+	void ClearSelection();
+	bool IsTriangleSelected(size_t triangleIndex) const;
+	bool SetTriangleMaterial(size_t triangleIndex, MaterialID material);
+	// True when every triangle uses the same material, rescanned only after material edits
+	bool GetUniformMaterial(MaterialID& material);
+	void SetMaterialReflectivities(const std::vector<float>& reflectivities);
+	void SetTriangleContributions(size_t firstTriangle, const float* values, size_t count);
+	void SetHeatMapSource(HeatMapSource source);
+	// Reports the capacity of the CPU side arrays to the Geometry category and modelMemoryMB.
+	// Called after every change that can grow or free them.
+	void UpdateMemoryUsage();
 
 	std::vector<Triangle> triangles;
 	std::vector <Vertex> vertices;
@@ -62,10 +173,44 @@ public:
 	
 	std::string fileName;
 	size_t numTriangles = 0;
-	float modelMemoryMB;
+	float modelMemoryMB = 0.0f;  // CPU side geometry, see UpdateMemoryUsage
 	float length = 0;
 	float height = 0;
 	bool isVisible = true;
+	MeshLoadTimings lastLoadTimings;
+
+	// Shape the procedural creators built the mesh from, PrimitiveType::None for loaded models
+	PrimitiveShape primitive;
+
+	// Bounding boxes, the local one is cached so transforms never rescan vertices
+	AABB localBounds;
+	AABB worldBounds;
+
+	// Triangle hierarchy in model space for ray and region queries, built on first use
+	const BVH& GetBVH();
+	void InvalidateBVH() { bvhDirty = true; adjacency = TriangleAdjacency(); featureEdges.clear(); featureEdgeAngle = -1.0f; UpdateMemoryUsage(); }
+
+	// Edge adjacency, vertices at the same position count as shared. Built on first use.
+	const TriangleAdjacency& GetAdjacency();
+
+	// Wedge edges whose face normals differ by more than the threshold, plus open boundary edges.
+	// Rebuilt when the threshold changes.
+	const std::vector<FeatureEdge>& GetFeatureEdges(float angleThresholdDegrees);
+
+	// Calls function(triangleIndex) for every selected triangle, skipping empty words of the bitset
+	template<typename Function>
+	void ForEachSelectedTriangle(Function function) const
+	{
+		for (size_t word = 0; word < selectionMask.size(); ++word) {
+			GLuint bits = selectionMask[word];
+			while (bits != 0) {
+				size_t bit = 0;
+				while (((bits >> bit) & 1u) == 0) ++bit;
+				function(word * 32 + bit);
+				bits &= bits - 1; // Clear the lowest set bit
+			}
+		}
+	}
 
 	// Transformation methods
 	void UpdateModelMatrix();
@@ -76,11 +221,55 @@ public:
 	glm::vec3 rotation = glm::vec3(0.0f); // In degrees
 	glm::vec3 scale = glm::vec3(1.0f);
 
+	// Selection bitset mirrored to the GPU, one bit per triangle indexed by gl_PrimitiveID
+	std::vector<GLuint> selectionMask;
+	DirtyPages selectionDirty;        // Words that changed since the last upload
+	size_t selectedTriangleCount = 0;
+
+	// Per triangle scalar shown by the heat map, mirrored to the GPU the same way
+	std::vector<float> heatMapValues;
+	DirtyPages heatMapDirty;
+	HeatMapSource heatMapSource = HeatMapSource::Reflectivity;
+	std::vector<float> materialReflectivity;  // Heat map value of each MaterialID, from the MaterialLibrary
+
+	// Latest RCS contribution of each triangle, empty until a solver writes into it
+	std::vector<float> rcsContribution;
+
+	// Triangles whose properties changed since a solver last consumed them, one bit per triangle.
+	// Solvers can re-evaluate only these instead of the whole mesh.
+	std::vector<uint64_t> solverDirtyMask;
+	size_t solverDirtyCount = 0;
+	void MarkTriangleSolverDirty(size_t triangleIndex);
+	bool IsTriangleSolverDirty(size_t triangleIndex) const;
+	void ClearSolverDirty();
+
 	// Object
 	std::unique_ptr<Shader> objectShaderProgram;
-	GLuint VAO_obj, VBO_obj, EBO_obj;
+	GLObjectName VAO_obj, VBO_obj, EBO_obj;
+	GLObjectName selectionBuffer, selectionTexture;
+	GLObjectName heatMapBuffer, heatMapTexture;
+	MemoryAccount gpuMemory{ MemoryCategory::GpuBuffers };  // Set by the renderer when it uploads the buffers
 
 private:
+	void RefillHeatMap();
+	float MaterialReflectivity(MaterialID material) const;
+
+	// Edges of every triangle keyed by their welded endpoints and sorted, so shared edges are adjacent.
+	// The value is the corner the edge starts at (triangle * 3 + edge).
+	void CollectWeldedEdges(std::vector<std::pair<uint64_t, uint32_t>>& edges) const;
+
+	BVH bvh;
+	bool bvhDirty = true;
+	TriangleAdjacency adjacency;
+	std::vector<FeatureEdge> featureEdges;
+	float featureEdgeAngle = -1.0f;  // Threshold featureEdges was built with
+
+	MemoryAccount geometryMemory{ MemoryCategory::Geometry };
+
+	bool uniformMaterialDirty = true;
+	bool uniformMaterial = true;
+	MaterialID uniformMaterialID = 0;
+
 	glm::mat4 modelMatrix = glm::mat4(1.0f);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,499 @@
+#include "MeshGenerators.h"
+
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+
+void FinishGeneratedMesh(Mesh& mesh)
+{
+    // Calculate number of triangles
+    mesh.numTriangles = mesh.indices.size() / 3;
+
+    // Calculate dimensions
+    mesh.CalculateDimensions();
+
+    // Build per triangle data (normals, selection mask), also accounts the memory
+    mesh.UpdateTriangleData();
+}
+
+void GeneratePlaneMesh(Mesh& mesh, int axis, float start, float end, float start2, float end2, const MeshDetail& detail)
+{
+    // Segments along each side, fixed or sized for the analysis wavelength
+    int segments1 = detail.LOD;
+    int segments2 = detail.LOD;
+    if (detail.tessellation.wavelengthDriven) {
+        segments1 = StraightSegments(end - start, detail.frequency, detail.tessellation);
+        segments2 = StraightSegments(end2 - start2, detail.frequency, detail.tessellation);
+    }
+    float dx1 = (end - start) / segments1;
+    float dx2 = (end2 - start2) / segments2;
+    mesh.vertices.reserve(mesh.vertices.size() + size_t(segments1 + 1) * (segments2 + 1));
+    mesh.indices.reserve(mesh.indices.size() + size_t(segments1) * segments2 * 6);
+
+    // Generate vertices
+    for (int i = 0; i <= segments1; i++) {
+        for (int j = 0; j <= segments2; j++) {
+            float pos1 = start + i * dx1;
+            float pos2 = start2 + j * dx2;
+
+            Vertex vertex;
+
+            // Set position based on the selected axis
+            switch (axis) {
+            case 0: // X-axis (YZ plane)
+                vertex.position = glm::vec3(0.0f, pos1, pos2);
+                break;
+            case 1: // Y-axis (XZ plane)
+                vertex.position = glm::vec3(pos1, 0.0f, pos2);
+                break;
+            case 2: // Z-axis (XY plane)
+                vertex.position = glm::vec3(pos1, pos2, 0.0f);
+                break;
+            }
+
+            vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+
+    // Generate indices for triangles
+    int rowLength = segments2 + 1;
+    for (int i = 0; i < segments1; i++) {
+        for (int j = 0; j < segments2; j++) {
+            int topLeft = i * rowLength + j;
+            int topRight = topLeft + 1;
+            int bottomLeft = (i + 1) * rowLength + j;
+            int bottomRight = bottomLeft + 1;
+
+            // First triangle (top-left, bottom-left, bottom-right)
+            mesh.indices.push_back(topLeft);
+            mesh.indices.push_back(bottomLeft);
+            mesh.indices.push_back(bottomRight);
+
+            // Second triangle (top-left, bottom-right, top-right)
+            mesh.indices.push_back(topLeft);
+            mesh.indices.push_back(bottomRight);
+            mesh.indices.push_back(topRight);
+        }
+    }
+
+    // Keep the parametric plate for the analytic solver
+    glm::vec3 first(0.0f), second(0.0f);
+    first[axis == 0 ? 1 : 0] = 1.0f;
+    second[axis == 2 ? 1 : 2] = 1.0f;
+    mesh.primitive.type = PrimitiveType::Plate;
+    mesh.primitive.origin = first * 0.5f * (start + end) + second * 0.5f * (start2 + end2);
+    mesh.primitive.axes[0] = first;
+    mesh.primitive.axes[1] = second;
+    mesh.primitive.axes[2] = glm::cross(first, second);
+    mesh.primitive.size = glm::vec3(std::abs(end - start), std::abs(end2 - start2), 0.0f);
+
+    FinishGeneratedMesh(mesh);
+}
+
+void GenerateCubeMesh(Mesh& mesh, const glm::vec3& center, const glm::vec3& dimensions, const MeshDetail& detail)
+{
+    glm::vec3 halfDimensions = dimensions * 0.5f;
+
+    // Segments along each axis, fixed or sized for the analysis wavelength
+    glm::ivec3 segments(detail.LOD);
+    if (detail.tessellation.wavelengthDriven) {
+        for (int axis = 0; axis < 3; ++axis) {
+            segments[axis] = StraightSegments(dimensions[axis], detail.frequency, detail.tessellation);
+        }
+    }
+
+    // Each face spans two axes (first, second) at -half or +half along the third. Faces on the
+    // negative side reverse the winding so every normal points out of the cube.
+    struct Face {
+        int first, second, normal;
+        float side;
+    };
+    const Face faces[6] = {
+        { 0, 1, 2,  1.0f },  // front face (z = max)
+        { 0, 1, 2, -1.0f },  // back face (z = min)
+        { 1, 2, 0, -1.0f },  // left face (x = min)
+        { 1, 2, 0,  1.0f },  // right face (x = max)
+        { 0, 2, 1, -1.0f },  // bottom face (y = min)
+        { 0, 2, 1,  1.0f },  // top face (y = max)
+    };
+
+    // Sized up front, the faces append to the same arrays
+    size_t vertexCount = 0, indexCount = 0;
+    for (const Face& face : faces) {
+        vertexCount += size_t(segments[face.first] + 1) * (segments[face.second] + 1);
+        indexCount += size_t(segments[face.first]) * segments[face.second] * 6;
+    }
+    mesh.vertices.reserve(mesh.vertices.size() + vertexCount);
+    mesh.indices.reserve(mesh.indices.size() + indexCount);
+
+    for (const Face& face : faces) {
+        int count1 = segments[face.first];
+        int count2 = segments[face.second];
+        int firstVertex = static_cast<int>(mesh.vertices.size());
+
+        for (int i = 0; i <= count1; i++) {
+            for (int j = 0; j <= count2; j++) {
+                glm::vec3 position;
+                position[face.first] = -halfDimensions[face.first] + dimensions[face.first] * i / count1;
+                position[face.second] = -halfDimensions[face.second] + dimensions[face.second] * j / count2;
+                position[face.normal] = face.side * halfDimensions[face.normal];
+
+                Vertex vertex;
+                vertex.position = position + center;
+                vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);  // Color can be adjusted
+                mesh.vertices.push_back(vertex);
+            }
+        }
+
+        // first x second points along +normal for the right handed axis pairs (x, y), (y, z) and
+        // (z, x). (x, z) is left handed, its outward winding is the other way round.
+        bool flip = (face.side < 0.0f) != (face.first == 0 && face.second == 2);
+
+        int rowLength = count2 + 1;
+        for (int i = 0; i < count1; i++) {
+            for (int j = 0; j < count2; j++) {
+                int topLeft = firstVertex + i * rowLength + j;
+                int topRight = topLeft + 1;
+                int bottomLeft = firstVertex + (i + 1) * rowLength + j;
+                int bottomRight = bottomLeft + 1;
+
+                if (!flip) {
+                    mesh.indices.insert(mesh.indices.end(), { (GLuint)topLeft, (GLuint)bottomLeft, (GLuint)bottomRight });
+                    mesh.indices.insert(mesh.indices.end(), { (GLuint)topLeft, (GLuint)bottomRight, (GLuint)topRight });
+                }
+                else {
+                    mesh.indices.insert(mesh.indices.end(), { (GLuint)topLeft, (GLuint)bottomRight, (GLuint)bottomLeft });
+                    mesh.indices.insert(mesh.indices.end(), { (GLuint)topLeft, (GLuint)topRight, (GLuint)bottomRight });
+                }
+            }
+        }
+    }
+
+    mesh.primitive.type = PrimitiveType::Box;
+    mesh.primitive.origin = center;
+    mesh.primitive.size = dimensions;
+
+    FinishGeneratedMesh(mesh);
+}
+
+void GenerateSphereMesh(Mesh& mesh, const glm::vec3& center, float radius, const MeshDetail& detail)
+{
+    // Rings from pole to pole and sectors around the vertical axis. A fixed level of detail
+    // uses the same count for both, wavelength driven tessellation sizes them by arc length.
+    int rings = detail.LOD;
+    int sectors = detail.LOD;
+    if (detail.tessellation.wavelengthDriven) {
+        rings = ArcSegments(radius, glm::pi<float>(), detail.frequency, detail.tessellation, 2);
+        sectors = ArcSegments(radius, glm::two_pi<float>(), detail.frequency, detail.tessellation);
+    }
+    float phiStep = glm::pi<float>() / rings;              // Latitude angle step
+    float thetaStep = glm::pi<float>() * 2.0f / sectors;   // Longitude angle step
+    mesh.vertices.reserve(mesh.vertices.size() + size_t(rings + 1) * (sectors + 1));
+    mesh.indices.reserve(mesh.indices.size() + size_t(std::max(2 * rings - 2, 0)) * sectors * 3);  // No quads at the poles
+
+    // Generate vertices
+    for (int i = 0; i <= rings; ++i) {
+        // The last ring and column are pinned to the exact pole and seam angles, rounding in
+        // i * step would leave them a hair apart and open the surface for the edge adjacency
+        float phi = i == rings ? glm::pi<float>() : i * phiStep;
+        float sinPhi = i == rings ? 0.0f : sin(phi);
+        for (int j = 0; j <= sectors; ++j) {
+            float theta = j == sectors ? 0.0f : j * thetaStep;
+
+            // Spherical to Cartesian conversion
+            float x = center.x + radius * sinPhi * cos(theta);
+            float y = center.y + radius * cos(phi);
+            float z = center.z + radius * sinPhi * sin(theta);
+
+            Vertex vertex;
+            vertex.position = glm::vec3(x, y, z);
+            vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);  // White color for the vertices
+            mesh.vertices.push_back(vertex);
+        }
+    }
+
+    // Generate indices, wound counter clockwise seen from outside
+    for (int i = 0; i < rings; ++i) {
+        for (int j = 0; j < sectors; ++j) {
+            int first = i * (sectors + 1) + j;
+            int second = first + sectors + 1;
+
+            // First triangle (top-left, top-right, bottom-left), degenerate at the top pole
+            if (i > 0) {
+                mesh.indices.push_back(first);
+                mesh.indices.push_back(first + 1);
+                mesh.indices.push_back(second);
+            }
+
+            // Second triangle (bottom-left, top-right, bottom-right), degenerate at the bottom pole
+            if (i < rings - 1) {
+                mesh.indices.push_back(second);
+                mesh.indices.push_back(first + 1);
+                mesh.indices.push_back(second + 1);
+            }
+        }
+    }
+
+    mesh.primitive.type = PrimitiveType::Sphere;
+    mesh.primitive.origin = center;
+    mesh.primitive.size = glm::vec3(radius, 0.0f, 0.0f);
+
+    FinishGeneratedMesh(mesh);
+}
+
+void GenerateCylinderMesh(Mesh& mesh, const glm::vec3& center, float radius, float height, const MeshDetail& detail)
+{
+    // A fixed level of detail only subdivides around the axis. Wavelength driven tessellation
+    // also splits the side into rows and the caps into rings.
+    int sectors = detail.LOD;
+    int rows = 1;
+    int capRings = 1;
+    if (detail.tessellation.wavelengthDriven) {
+        sectors = ArcSegments(radius, glm::two_pi<float>(), detail.frequency, detail.tessellation);
+        rows = StraightSegments(height, detail.frequency, detail.tessellation);
+        capRings = StraightSegments(radius, detail.frequency, detail.tessellation);
+    }
+    float angleStep = glm::two_pi<float>() / sectors;
+    float halfHeight = height / 2.0f;
+
+    // Side rows, then per cap its inner rings and a centre vertex
+    mesh.vertices.reserve(mesh.vertices.size() + size_t(rows + 1) * sectors + 2 * (size_t(capRings - 1) * sectors + 1));
+    mesh.indices.reserve(mesh.indices.size() + size_t(rows) * sectors * 6 + 2 * (size_t(capRings - 1) * sectors * 6 + size_t(sectors) * 3));
+
+    auto addVertex = [&](float ringRadius, int i, float y) {
+        Vertex vertex;
+        vertex.position = glm::vec3(ringRadius * cos(i * angleStep), y, ringRadius * sin(i * angleStep)) + center;
+        vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
+        mesh.vertices.push_back(vertex);
+    };
+
+    // Side rows from the top circle down to the bottom circle
+    for (int row = 0; row <= rows; row++) {
+        float y = halfHeight - height * row / rows;
+        for (int i = 0; i < sectors; i++) {
+            addVertex(radius, i, y);
+        }
+    }
+
+    // Side triangles
+    for (int row = 0; row < rows; row++) {
+        for (int i = 0; i < sectors; i++) {
+            int next = (i + 1) % sectors;
+            GLuint top = row * sectors + i;
+            GLuint topNext = row * sectors + next;
+            GLuint bottom = top + sectors;
+            GLuint bottomNext = topNext + sectors;
+
+            mesh.indices.insert(mesh.indices.end(), { top, topNext, bottom });
+            mesh.indices.insert(mesh.indices.end(), { topNext, bottomNext, bottom });
+        }
+    }
+
+    // Caps share the rim with the side and step inwards ring by ring to a centre vertex.
+    // Angles grow from +X towards +Z, counter clockwise seen from below, so the top cap
+    // reverses its triangles to face up.
+    auto addCap = [&](int rimRow, float y, bool top) {
+        auto addTriangle = [&](GLuint a, GLuint b, GLuint c) {
+            if (top) mesh.indices.insert(mesh.indices.end(), { a, c, b });
+            else mesh.indices.insert(mesh.indices.end(), { a, b, c });
+        };
+
+        GLuint outer = rimRow * sectors;
+        for (int ring = capRings - 1; ring >= 1; ring--) {
+            GLuint inner = static_cast<GLuint>(mesh.vertices.size());
+            for (int i = 0; i < sectors; i++) {
+                addVertex(radius * ring / capRings, i, y);
+            }
+            for (int i = 0; i < sectors; i++) {
+                int next = (i + 1) % sectors;
+                addTriangle(outer + i, outer + next, inner + i);
+                addTriangle(outer + next, inner + next, inner + i);
+            }
+            outer = inner;
+        }
+
+        GLuint centerIndex = static_cast<GLuint>(mesh.vertices.size());
+        Vertex centerVertex;
+        centerVertex.position = glm::vec3(0.0f, y, 0.0f) + center;
+        centerVertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
+        mesh.vertices.push_back(centerVertex);
+
+        for (int i = 0; i < sectors; i++) {
+            addTriangle(outer + i, outer + (i + 1) % sectors, centerIndex);
+        }
+    };
+    addCap(0, halfHeight, true);
+    addCap(rows, -halfHeight, false);
+
+    mesh.primitive.type = PrimitiveType::Cylinder;
+    mesh.primitive.origin = center;
+    mesh.primitive.size = glm::vec3(radius, height, 0.0f);
+
+    FinishGeneratedMesh(mesh);
+}
+
+void GenerateDiskMesh(Mesh& mesh, const glm::vec3& center, float radius, int axis, const MeshDetail& detail)
+{
+    // A fixed level of detail draws a single fan, wavelength driven tessellation adds rings
+    int segments = detail.LOD;
+    int rings = 1;
+    if (detail.tessellation.wavelengthDriven) {
+        segments = ArcSegments(radius, glm::two_pi<float>(), detail.frequency, detail.tessellation);
+        rings = StraightSegments(radius, detail.frequency, detail.tessellation);
+    }
+    float angleStep = glm::two_pi<float>() / segments;
+    mesh.vertices.reserve(mesh.vertices.size() + 1 + size_t(rings) * segments);
+    mesh.indices.reserve(mesh.indices.size() + size_t(segments) * 3 + size_t(rings - 1) * segments * 6);
+
+    auto addVertex = [&](float x, float y) {
+        Vertex vertex;
+
+        switch (axis) {
+            case 0: // X-axis (disk lies in YZ plane)
+                vertex.position = glm::vec3(center.x, center.y + x, center.z + y);
+                break;
+            case 1: // Y-axis (disk lies in XZ plane)
+                vertex.position = glm::vec3(center.x + x, center.y, center.z + y);
+                break;
+            case 2: // Z-axis (disk lies in XY plane)
+            default:
+                vertex.position = glm::vec3(center.x + x, center.y + y, center.z);
+                break;
+        }
+
+        vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
+        mesh.vertices.push_back(vertex);
+    };
+
+    // Add center vertex
+    addVertex(0.0f, 0.0f);
+
+    // Rings of perimeter vertices, innermost first
+    for (int ring = 1; ring <= rings; ++ring) {
+        float ringRadius = radius * ring / rings;
+        for (int i = 0; i < segments; ++i) {
+            addVertex(ringRadius * cos(i * angleStep), ringRadius * sin(i * angleStep));
+        }
+    }
+
+    // Triangle fan around the center
+    int centerIndex = 0;
+    for (int i = 0; i < segments; ++i) {
+        mesh.indices.push_back(centerIndex);
+        mesh.indices.push_back(1 + i);
+        mesh.indices.push_back(1 + (i + 1) % segments);
+    }
+
+    // Quads between consecutive rings, wound like the fan
+    for (int ring = 1; ring < rings; ++ring) {
+        int inner = 1 + (ring - 1) * segments;
+        int outer = inner + segments;
+        for (int i = 0; i < segments; ++i) {
+            int next = (i + 1) % segments;
+            mesh.indices.insert(mesh.indices.end(), { (GLuint)(inner + i), (GLuint)(outer + i), (GLuint)(outer + next) });
+            mesh.indices.insert(mesh.indices.end(), { (GLuint)(inner + i), (GLuint)(outer + next), (GLuint)(inner + next) });
+        }
+    }
+
+    // The disk spans axes[0] and axes[1] the way the vertices above map (x, y)
+    glm::vec3 first(0.0f), second(0.0f);
+    first[axis == 0 ? 1 : 0] = 1.0f;
+    second[axis == 2 ? 1 : 2] = 1.0f;
+    mesh.primitive.type = PrimitiveType::Disk;
+    mesh.primitive.origin = center;
+    mesh.primitive.axes[0] = first;
+    mesh.primitive.axes[1] = second;
+    mesh.primitive.axes[2] = glm::cross(first, second);
+    mesh.primitive.size = glm::vec3(radius, 0.0f, 0.0f);
+
+    FinishGeneratedMesh(mesh);
+}
+
+void GenerateTrihedralMesh(Mesh& mesh, const glm::vec3& center, float size)
+{
+    float h = size; // Half-length of each square face edge
+
+    // Define the 3 perpendicular planes meeting at the center
+    glm::vec3 p0 = center;                         // Corner point (common vertex)
+    glm::vec3 p1 = center + glm::vec3(h, 0, 0);    // X direction
+    glm::vec3 p2 = center + glm::vec3(0, h, 0);    // Y direction
+    glm::vec3 p3 = center + glm::vec3(0, 0, h);    // Z direction
+
+    glm::vec3 p4 = center + glm::vec3(h, h, 0);    // XY plane
+    glm::vec3 p5 = center + glm::vec3(h, 0, h);    // XZ plane
+    glm::vec3 p6 = center + glm::vec3(0, h, h);    // YZ plane
+
+    // Set color white
+    glm::vec3 color(1.0f, 1.0f, 1.0f);
+
+    // Vertices
+    std::vector<glm::vec3> positions = { p0, p1, p2, p3, p4, p5, p6 };
+    for (const auto& pos : positions) {
+        Vertex v;
+        v.position = pos;
+        v.color = color;
+        mesh.vertices.push_back(v);
+    }
+
+    // Indices for the three triangle faces, wound so the normals face into the corner
+    // Each triangle is defined as (corner, edge1, edge2)
+    mesh.indices.insert(mesh.indices.end(), {
+        0, 1, 2,  // XY plane
+        0, 3, 1,  // XZ plane
+        0, 2, 3   // YZ plane
+        });
+
+    mesh.primitive.type = PrimitiveType::Trihedral;
+    mesh.primitive.origin = center;
+    mesh.primitive.size = glm::vec3(h, 0.0f, 0.0f);
+
+    FinishGeneratedMesh(mesh);
+}
+
+void GenerateDihedralMesh(Mesh& mesh, const glm::vec3& center, float size)
+{
+    float h = size; // Half-length of square face edge
+
+    // Define base point (corner where plates meet)
+    glm::vec3 p0 = center;
+
+    // First plane in XY
+    glm::vec3 p1 = p0 + glm::vec3(h, 0, 0);
+    glm::vec3 p2 = p0 + glm::vec3(0, h, 0);
+    glm::vec3 p3 = p0 + glm::vec3(h, h, 0);
+
+    // Second plane in XZ
+    glm::vec3 p4 = p0 + glm::vec3(0, 0, h);
+    glm::vec3 p5 = p0 + glm::vec3(h, 0, h);
+
+    glm::vec3 color(1.0f, 1.0f, 1.0f); // white color
+
+    // Push vertices
+    std::vector<glm::vec3> positions = { p0, p1, p2, p3, p4, p5 };
+    for (const auto& pos : positions) {
+        Vertex v;
+        v.position = pos;
+        v.color = color;
+        mesh.vertices.push_back(v);
+    }
+
+    // Indices for two square planes, each as two triangles
+    // XY face: p0, p1, p2, p3
+    mesh.indices.insert(mesh.indices.end(), {
+        0, 1, 2,
+        2, 1, 3
+        });
+
+    // XZ face: p0, p1, p4, p5, wound to face into the corner like the XY face
+    mesh.indices.insert(mesh.indices.end(), {
+        0, 4, 1,
+        4, 5, 1
+        });
+
+    // The plates meet along X
+    mesh.primitive.type = PrimitiveType::Dihedral;
+    mesh.primitive.origin = center;
+    mesh.primitive.size = glm::vec3(h, h, 0.0f);
+
+    FinishGeneratedMesh(mesh);
+}
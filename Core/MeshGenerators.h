@@ -0,0 +1,30 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "Tessellation.h"
+
+// How finely the generators subdivide. LOD is the fixed segment count of the original creators,
+// wavelength driven tessellation replaces it with facets sized for the analysis frequency.
+struct MeshDetail {
+    int LOD = 10;
+    TessellationSettings tessellation;
+    float frequency = 10.0e9f;   // Hz, only used by wavelength driven tessellation
+};
+
+// Procedural meshes shared by the editor and the batch runner. Each fills the vertices, indices
+// and the parametric primitive of an empty mesh, then calls FinishGeneratedMesh. No GL work is
+// done here, uploading is left to the caller.
+//
+// Axis arguments pick the plane normal: 0 = X (YZ plane), 1 = Y (XZ plane), 2 = Z (XY plane).
+void GeneratePlaneMesh(Mesh& mesh, int axis, float start, float end, float start2, float end2, const MeshDetail& detail);
+void GenerateCubeMesh(Mesh& mesh, const glm::vec3& center, const glm::vec3& dimensions, const MeshDetail& detail);
+void GenerateSphereMesh(Mesh& mesh, const glm::vec3& center, float radius, const MeshDetail& detail);
+void GenerateCylinderMesh(Mesh& mesh, const glm::vec3& center, float radius, float height, const MeshDetail& detail);
+void GenerateDiskMesh(Mesh& mesh, const glm::vec3& center, float radius, int axis, const MeshDetail& detail);
+void GenerateTrihedralMesh(Mesh& mesh, const glm::vec3& center, float size);
+void GenerateDihedralMesh(Mesh& mesh, const glm::vec3& center, float size);
+
+// Statistics, bounds and per triangle data of a freshly built mesh
+void FinishGeneratedMesh(Mesh& mesh);
@@ -1,22 +1,54 @@
 #include "PickingTexture.h"
 
+#include <algorithm>
+#include <cstring>
+
 PickingTexture::~PickingTexture()
+{
+    DeleteAttachments();
+
+    for (auto& slot : m_slots) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+        }
+        if (slot.pbo != 0) {
+            glDeleteBuffers(1, &slot.pbo);
+        }
+    }
+}
+
+void PickingTexture::DeleteAttachments()
 {
     if (m_fbo != 0) {
         glDeleteFramebuffers(1, &m_fbo);
+        m_fbo = 0;
     }
 
     if (m_pickingTexture != 0) {
         glDeleteTextures(1, &m_pickingTexture);
+        m_pickingTexture = 0;
     }
 
     if (m_depthTexture != 0) {
         glDeleteTextures(1, &m_depthTexture);
+        m_depthTexture = 0;
     }
+    UpdateMemoryUsage();
+}
+
+void PickingTexture::UpdateMemoryUsage()
+{
+    // RGB32UI IDs plus a 32 bit depth texel per pixel
+    uint64_t bytes = m_pickingTexture != 0 ? uint64_t(m_width) * m_height * (sizeof(PixelInfo) + 4) : 0;
+    for (const auto& slot : m_slots) bytes += slot.capacity;
+    m_memory.Set(bytes);
 }
 
 void PickingTexture::Init(unsigned int WindowWidth, unsigned int WindowHeight)
 {
+    m_width = WindowWidth;
+    m_height = WindowHeight;
+
     // Create the FBO
     glGenFramebuffers(1, &m_fbo);
     glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
@@ -46,6 +78,17 @@ void PickingTexture::Init(unsigned int WindowWidth, unsigned int WindowHeight)
     // Restore the default framebuffer
     glBindTexture(GL_TEXTURE_2D, 0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    UpdateMemoryUsage();
+}
+
+void PickingTexture::Resize(unsigned int WindowWidth, unsigned int WindowHeight)
+{
+    if (WindowWidth == 0 || WindowHeight == 0) return; // Minimized window
+    if (WindowWidth == m_width && WindowHeight == m_height) return;
+
+    // Reads already queued keep their own PBO, only the attachments are replaced
+    DeleteAttachments();
+    Init(WindowWidth, WindowHeight);
 }
 
 void PickingTexture::EnableWriting()
@@ -59,18 +102,93 @@ void PickingTexture::DisableWriting()
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 }
 
-PickingTexture::PixelInfo PickingTexture::ReadPixel(unsigned int x, unsigned int y)
+void PickingTexture::RequestRegion(int x, int y, int radius)
 {
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    // Clamp the block to the texture
+    int x0 = std::max(0, x - radius);
+    int y0 = std::max(0, y - radius);
+    int x1 = std::min(static_cast<int>(m_width) - 1, x + radius);
+    int y1 = std::min(static_cast<int>(m_height) - 1, y + radius);
+    if (x0 > x1 || y0 > y1) return;
+
+    // With every slot in flight the oldest read is dropped, the newest click matters most
+    if (m_pendingCount == kReadbackSlots) {
+        ReadbackSlot& oldest = m_slots[m_firstPending];
+        glDeleteSync(oldest.fence);
+        oldest.fence = nullptr;
+        m_firstPending = (m_firstPending + 1) % kReadbackSlots;
+        m_pendingCount--;
+    }
+
+    ReadbackSlot& slot = m_slots[(m_firstPending + m_pendingCount) % kReadbackSlots];
+    slot.region.x = x0;
+    slot.region.y = y0;
+    slot.region.width = x1 - x0 + 1;
+    slot.region.height = y1 - y0 + 1;
+    slot.region.centerX = x;
+    slot.region.centerY = y;
+
+    size_t bytes = static_cast<size_t>(slot.region.width) * slot.region.height * sizeof(PixelInfo);
+    if (slot.pbo == 0) {
+        glGenBuffers(1, &slot.pbo);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (slot.capacity < bytes) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        slot.capacity = bytes;
+        UpdateMemoryUsage();
+    }
 
+    // With a pack buffer bound glReadPixels only queues the copy
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
     glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(x0, y0, slot.region.width, slot.region.height, GL_RGB_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-    PixelInfo Pixel;
-    glReadPixels(x, y, 1, 1, GL_RGB_INTEGER, GL_UNSIGNED_INT, &Pixel);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_pendingCount++;
+}
 
-    glReadBuffer(GL_NONE);
+bool PickingTexture::PollRegion(PickRegion& region)
+{
+    if (m_pendingCount == 0) return false;
 
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    ReadbackSlot& slot = m_slots[m_firstPending];
+
+    // Zero timeout, only asks whether the copy is done. The flush makes sure the fence is submitted.
+    GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status == GL_TIMEOUT_EXPIRED) return false;
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    m_firstPending = (m_firstPending + 1) % kReadbackSlots;
+    m_pendingCount--;
 
-    return Pixel;
-}
\ No newline at end of file
+    if (status == GL_WAIT_FAILED) {
+        std::cerr << "Picking readback failed" << std::endl;
+        return false;
+    }
+
+    region = slot.region;
+    region.pixels.resize(static_cast<size_t>(region.width) * region.height);
+
+    size_t bytes = region.pixels.size() * sizeof(PixelInfo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+    if (data) {
+        std::memcpy(region.pixels.data(), data, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return data != nullptr;
+}
+
+PickingTexture::PixelInfo PickingTexture::PickRegion::At(int px, int py) const
+{
+    if (px < x || py < y || px >= x + width || py >= y + height) return PixelInfo();
+    return pixels[static_cast<size_t>(py - y) * width + (px - x)];
+}
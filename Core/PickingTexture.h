@@ -1,8 +1,11 @@
 #pragma once
 
 #include <iostream>
+#include <vector>
 #include <glad/glad.h>
 
+#include "MemoryTracker.h"
+
 class PickingTexture
 {
 public:
@@ -12,6 +15,9 @@ public:
 
     void Init(unsigned int WindowWidth, unsigned int WindowHeight);
 
+    // Recreates the attachments if the framebuffer size changed
+    void Resize(unsigned int WindowWidth, unsigned int WindowHeight);
+
     void EnableWriting();
 
     void DisableWriting();
@@ -27,10 +33,56 @@ public:
         }
     };
 
-    PixelInfo ReadPixel(unsigned int x, unsigned int y);
+    // Block of pixels read back around a requested point, in OpenGL window coordinates
+    struct PickRegion {
+        int x = 0;             // Bottom left corner of the block
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        int centerX = 0;       // The pixel the read was requested for
+        int centerY = 0;
+        std::vector<PixelInfo> pixels;  // Row major, bottom row first
+
+        // Returns an empty pixel (ObjectID 0) outside the block
+        PixelInfo At(int px, int py) const;
+        PixelInfo Center() const { return At(centerX, centerY); }
+    };
+
+    // Queues an asynchronous read of the block within radius pixels of (x, y).
+    // The copy goes into a pixel buffer object, so the call never waits for the GPU.
+    void RequestRegion(int x, int y, int radius);
+
+    // Returns true and fills region once the oldest queued read has finished on the GPU
+    bool PollRegion(PickRegion& region);
+
+    bool HasPendingReads() const { return m_pendingCount > 0; }
+
+    unsigned int GetWidth() const { return m_width; }
+    unsigned int GetHeight() const { return m_height; }
 
 private:
+    void DeleteAttachments();
+    // Reports the attachments and the readback buffers to the GPU buffers category
+    void UpdateMemoryUsage();
+
+    // Ring of readbacks, each guarded by a fence so it can be resolved frames later
+    static constexpr int kReadbackSlots = 3;
+    struct ReadbackSlot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        size_t capacity = 0;   // Bytes allocated in the PBO
+        PickRegion region;     // Geometry of the read, pixels are filled on resolve
+    };
+    ReadbackSlot m_slots[kReadbackSlots];
+    int m_firstPending = 0;
+    int m_pendingCount = 0;
+
+    unsigned int m_width = 0;
+    unsigned int m_height = 0;
+
     GLuint m_fbo = 0;
     GLuint m_pickingTexture = 0;
     GLuint m_depthTexture = 0;
-};
\ No newline at end of file
+
+    MemoryAccount m_memory{ MemoryCategory::GpuBuffers };
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+enum class PrimitiveType {
+    None, Plate, Box, Sphere, Cylinder, Disk, Trihedral, Dihedral
+};
+
+// Parametric description of a mesh built by one of the procedural creators, in model space.
+// The analytic scattering formulas evaluate this instead of the triangles.
+//
+//   Plate      origin is the centre, axes[0] and axes[1] span the sides, size.xy are their lengths
+//   Box        origin is the centre, size holds the lengths along axes[0..2]
+//   Sphere     origin is the centre, size.x the radius
+//   Cylinder   origin is the centre, axes[1] the axis, size.x the radius and size.y the height
+//   Disk       origin is the centre, axes[2] the normal, size.x the radius
+//   Trihedral  origin is the corner, axes[0..2] run along the three edges of length size.x
+//   Dihedral   origin is the corner, axes[0] runs along the fold of length size.x,
+//              axes[1] and axes[2] across the two plates of width size.y
+struct PrimitiveShape {
+    PrimitiveType type = PrimitiveType::None;
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 axes[3] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+    glm::vec3 size = glm::vec3(0.0f);
+};
@@ -0,0 +1,260 @@
+#include "Profiler.h"
+#include "SystemMetrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+// Ring slots are atomics so a reader racing the writer gets stale values instead of undefined
+// behaviour. Events the writer may have touched during the copy are dropped by the reader.
+struct EventSlot {
+    std::atomic<const char*> name{ nullptr };
+    std::atomic<uint64_t> startNs{ 0 };
+    std::atomic<uint64_t> endNs{ 0 };
+    std::atomic<uint32_t> depth{ 0 };
+    std::atomic<ProfileEventKind> kind{ ProfileEventKind::Scope };
+    std::atomic<uint64_t> count{ 0 };
+};
+
+struct ThreadBuffer {
+    std::unique_ptr<EventSlot[]> slots = std::make_unique<EventSlot[]>(Profiler::kEventsPerThread);
+    std::atomic<uint64_t> written{ 0 };   // Events ever recorded, slot = index % kEventsPerThread
+    std::atomic<bool> inUse{ true };      // Cleared when the owning thread exits, the next new thread reuses it
+    uint32_t index = 0;
+    std::string name;                     // Guarded by the registry mutex
+};
+
+// Buffers live until the process ends, threads may still record while statics are destroyed
+struct ProfilerRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+static ProfilerRegistry& Registry()
+{
+    static ProfilerRegistry* registry = new ProfilerRegistry();
+    return *registry;
+}
+
+static std::atomic<bool> s_enabled{ true };
+static thread_local uint32_t t_depth = 0;
+
+// Hands the buffer back when its thread exits
+struct ThreadBufferHandle {
+    ThreadBuffer* buffer = nullptr;
+    ~ThreadBufferHandle()
+    {
+        if (buffer) buffer->inUse.store(false, std::memory_order_release);
+    }
+};
+static thread_local ThreadBufferHandle t_handle;
+
+// The calling thread's buffer, registered on first use. Only this first call locks.
+static ThreadBuffer& LocalBuffer()
+{
+    if (t_handle.buffer) return *t_handle.buffer;
+
+    ProfilerRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& buffer : registry.buffers) {
+        if (!buffer->inUse.load(std::memory_order_acquire)) {
+            buffer->inUse.store(true, std::memory_order_relaxed);
+            buffer->name = "Thread " + std::to_string(buffer->index);
+            t_handle.buffer = buffer.get();
+            return *t_handle.buffer;
+        }
+    }
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->index = static_cast<uint32_t>(registry.buffers.size());
+    buffer->name = "Thread " + std::to_string(buffer->index);
+    t_handle.buffer = buffer.get();
+    registry.buffers.push_back(std::move(buffer));
+    return *t_handle.buffer;
+}
+
+// Lane for GPU timer results, registered like a thread but never handed to one
+static ThreadBuffer& GpuBuffer()
+{
+    static ThreadBuffer* gpu = [] {
+        ProfilerRegistry& registry = Registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->index = static_cast<uint32_t>(registry.buffers.size());
+        buffer->name = "GPU";
+        registry.buffers.push_back(std::move(buffer));
+        return registry.buffers.back().get();
+    }();
+    return *gpu;
+}
+
+// Only the thread owning the buffer appends
+static void Append(ThreadBuffer& buffer, const ProfileEvent& event)
+{
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    EventSlot& slot = buffer.slots[index % Profiler::kEventsPerThread];
+
+    // Pairs with the fence in CopyEvents: a reader that sees any of these stores also sees
+    // the write count published before them and knows the slot was being reused
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(event.name, std::memory_order_relaxed);
+    slot.startNs.store(event.startNs, std::memory_order_relaxed);
+    slot.endNs.store(event.endNs, std::memory_order_relaxed);
+    slot.depth.store(event.depth, std::memory_order_relaxed);
+    slot.kind.store(event.kind, std::memory_order_relaxed);
+    slot.count.store(event.count, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+// Copies events first..written that ended at or after sinceNs, minus the ones the writer reused
+// while they were copied. Returns how many of those were dropped. Called with the registry locked.
+static uint64_t CopyEvents(const ThreadBuffer& buffer, uint64_t first, uint64_t written, uint64_t sinceNs,
+    std::vector<ProfileEvent>& events)
+{
+    std::vector<uint64_t> indices;
+    for (uint64_t i = first; i < written; ++i) {
+        const EventSlot& slot = buffer.slots[i % Profiler::kEventsPerThread];
+        ProfileEvent event;
+        event.endNs = slot.endNs.load(std::memory_order_relaxed);
+        if (event.endNs < sinceNs) continue;
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.startNs = slot.startNs.load(std::memory_order_relaxed);
+        event.depth = slot.depth.load(std::memory_order_relaxed);
+        event.kind = slot.kind.load(std::memory_order_relaxed);
+        event.count = slot.count.load(std::memory_order_relaxed);
+        events.push_back(event);
+        indices.push_back(i);
+    }
+
+    // Slot i is reused by event i + kEventsPerThread, which starts once the count reaches it
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t writtenAfter = buffer.written.load(std::memory_order_relaxed);
+    size_t stale = 0;
+    while (stale < indices.size() && indices[stale] + Profiler::kEventsPerThread <= writtenAfter) ++stale;
+    events.erase(events.begin(), events.begin() + stale);
+    return stale;
+}
+
+uint64_t Profiler::Now()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool Profiler::IsEnabled()
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+    SetNativeThreadName(name);
+    ThreadBuffer& buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(Registry().mutex);
+    buffer.name = name;
+}
+
+void Profiler::Record(const char* name, uint64_t startNs, uint64_t endNs, uint32_t depth)
+{
+    ProfileEvent event;
+    event.name = name;
+    event.startNs = startNs;
+    event.endNs = endNs;
+    event.depth = depth;
+    Append(LocalBuffer(), event);
+}
+
+void Profiler::Count(const char* name, uint64_t count)
+{
+    if (!IsEnabled() || count == 0) return;
+    ProfileEvent event;
+    event.name = name;
+    event.startNs = event.endNs = Now();
+    event.depth = t_depth;
+    event.kind = ProfileEventKind::Counter;
+    event.count = count;
+    Append(LocalBuffer(), event);
+}
+
+void Profiler::RecordGpu(const char* name, uint64_t startNs, uint64_t endNs)
+{
+    if (!IsEnabled()) return;
+    ProfileEvent event;
+    event.name = name;
+    event.startNs = startNs;
+    event.endNs = endNs;
+    Append(GpuBuffer(), event);
+}
+
+uint32_t Profiler::CurrentDepth()
+{
+    return t_depth;
+}
+
+void Profiler::Collect(uint64_t sinceNs, std::vector<ProfileThreadSnapshot>& threads)
+{
+    threads.clear();
+    ProfilerRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (const auto& buffer : registry.buffers) {
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        if (written == 0) continue;
+        uint64_t first = written > kEventsPerThread ? written - kEventsPerThread : 0;
+
+        ProfileThreadSnapshot snapshot;
+        snapshot.name = buffer->name;
+        snapshot.threadIndex = buffer->index;
+        CopyEvents(*buffer, first, written, sinceNs, snapshot.events);
+        threads.push_back(std::move(snapshot));
+    }
+}
+
+uint64_t Profiler::Drain(std::vector<uint64_t>& cursors, std::vector<ProfileThreadSnapshot>& threads)
+{
+    threads.clear();
+    ProfilerRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (cursors.size() < registry.buffers.size()) cursors.resize(registry.buffers.size(), 0);
+
+    uint64_t dropped = 0;
+    for (const auto& buffer : registry.buffers) {
+        uint64_t& cursor = cursors[buffer->index];
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        if (written <= cursor) continue;
+
+        // Whatever fell out of the ring since the last drain is gone
+        uint64_t first = std::max(cursor, written > kEventsPerThread ? written - kEventsPerThread : 0);
+        dropped += first - cursor;
+
+        ProfileThreadSnapshot snapshot;
+        snapshot.name = buffer->name;
+        snapshot.threadIndex = buffer->index;
+        dropped += CopyEvents(*buffer, first, written, 0, snapshot.events);
+        cursor = written;
+        threads.push_back(std::move(snapshot));
+    }
+    return dropped;
+}
+
+ProfileScope::ProfileScope(const char* name) : m_name(name)
+{
+    if (!s_enabled.load(std::memory_order_relaxed)) return;
+    m_active = true;
+    ++t_depth;
+    m_start = Profiler::Now();
+}
+
+ProfileScope::~ProfileScope()
+{
+    if (!m_active) return;
+    uint64_t end = Profiler::Now();
+    --t_depth;
+    Profiler::Record(m_name, m_start, end, t_depth);
+}
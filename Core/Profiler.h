@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scopes compile to nothing with SCATTERX_PROFILER=0. They are on by default: a scope costs two
+// clock reads and a few stores into a buffer only its own thread writes.
+#ifndef SCATTERX_PROFILER
+#define SCATTERX_PROFILER 1
+#endif
+
+enum class ProfileEventKind : uint8_t {
+    Scope,      // startNs to endNs
+    Counter,    // count units of work done at endNs, e.g. rays traced by one pick
+};
+
+// A closed scope or a counter increment. Names are not copied, they must be string literals or
+// otherwise outlive the program.
+struct ProfileEvent {
+    const char* name = nullptr;
+    uint64_t startNs = 0;   // Profiler::Now() clock
+    uint64_t endNs = 0;
+    uint32_t depth = 0;     // Scopes open around it on the same thread
+    ProfileEventKind kind = ProfileEventKind::Scope;
+    uint64_t count = 0;     // Counter only
+};
+
+// Events of one thread copied out of its ring buffer, ordered by end time
+struct ProfileThreadSnapshot {
+    std::string name;
+    uint32_t threadIndex = 0;   // Order the thread first recorded in, stable for the whole run
+    std::vector<ProfileEvent> events;
+};
+
+// Hot path profiler. Every thread records into its own fixed size ring buffer, the oldest events
+// are overwritten. Writers never lock or wait: the owning thread stores the event and publishes it
+// by bumping its write count. Readers copy a range and then drop whatever the writer may have
+// overwritten while they were copying.
+class Profiler {
+public:
+    static constexpr size_t kEventsPerThread = size_t(1) << 14;
+
+    // Monotonic nanoseconds shared by every thread
+    static uint64_t Now();
+
+    // Disabled scopes skip the clock and the buffer, recorded events stay readable
+    static bool IsEnabled();
+    static void SetEnabled(bool enabled);
+
+    // Label shown for the calling thread, e.g. "Main" or "Worker 2". Also given to the OS thread.
+    static void SetThreadName(const std::string& name);
+
+    // Appends a closed scope to the calling thread's buffer
+    static void Record(const char* name, uint64_t startNs, uint64_t endNs, uint32_t depth);
+    // Adds count to the named counter, summed per name when exported
+    static void Count(const char* name, uint64_t count);
+    // GPU pass times go to their own "GPU" lane. Only the thread owning the GL context may call this.
+    static void RecordGpu(const char* name, uint64_t startNs, uint64_t endNs);
+    // Scopes currently open on the calling thread, for events recorded by hand
+    static uint32_t CurrentDepth();
+
+    // Copies the events of every thread that ended at or after sinceNs
+    static void Collect(uint64_t sinceNs, std::vector<ProfileThreadSnapshot>& threads);
+    // Copies the events recorded since the last drain with the same cursors, indexed by threadIndex.
+    // Returns how many were overwritten before they could be copied.
+    static uint64_t Drain(std::vector<uint64_t>& cursors, std::vector<ProfileThreadSnapshot>& threads);
+};
+
+// Times its own lifetime, see PROFILE_SCOPE
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_start = 0;
+    bool m_active = false;
+};
+
+#if SCATTERX_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
@@ -1,12 +1,18 @@
 #include "Renderer.h"
 #include "Mesh.h"
+#include "Profiler.h"
 
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
 
 Renderer::Renderer():
     camera(1280, 720)
 {
+    // Resized to the real framebuffer by resize() on the first frame
     m_pickingTexture.Init(1280, 720);
+    gpuTimer.Init();
 
     setupGridLayout();
     setupCoordinateSystem();
@@ -17,7 +23,6 @@ Renderer::Renderer():
 Renderer::~Renderer() {
     // Clean grid layout
     glDeleteVertexArrays(1, &VAO_grid);
-    glDeleteBuffers(1, &VBO_grid);
 
     // Clean coordinate system
     glDeleteVertexArrays(1, &VAO_axis);
@@ -26,56 +31,25 @@ Renderer::~Renderer() {
 
 void Renderer::setupGridLayout()
 {
-    float half = size / 2.0f;
-    step = size / divisions; // Step size is the side length of the grid squares
-
-    std::vector<float> vertices;
-
-    float r = 0.4f, g = 0.4f, b = 0.4f;
-
-    for (int i = 0; i <= divisions; ++i) {
-        float k = -half + i * step;
-
-        // vertical line (constant X, varies Z)
-        vertices.insert(vertices.end(), { k, 0.0f, -half, r, g, b });
-        vertices.insert(vertices.end(), { k, 0.0f,  half, r, g, b });
-
-        // horizontal line (constant Z, varies X)
-        vertices.insert(vertices.end(), { -half, 0.0f, k, r, g, b });
-        vertices.insert(vertices.end(), { half, 0.0f, k, r, g, b });
-    }
-
+    // The grid has no vertex data, core profile still needs a VAO bound to draw
     glGenVertexArrays(1, &VAO_grid);
-    glGenBuffers(1, &VBO_grid);
-    glBindVertexArray(VAO_grid);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_grid);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 
-    // Position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // Color
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindVertexArray(0);
-
-    gridShaderProgram = std::make_unique<Shader>("shaders/default.vert", "shaders/default.frag");
+    gridShaderProgram = std::make_unique<Shader>("Shaders/grid.vert", "Shaders/grid.frag");
 }
 
 void Renderer::setupCoordinateSystem() {
-    // Define vertices for coordinate axes: X (red), Y (green), Z (blue)
+    // Define unit vertices for coordinate axes: X (red), Y (green), Z (blue)
+    // They are scaled to half the grid size when drawn, so grid changes never rebuild them
     GLfloat vertices[] = {
         // X-axis
         0.0f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f,
-        size / 2, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f,
+        1.0f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f,
         // Y-axis
         0.0f, 0.0f, 0.0f,  0.0f, 1.0f, 0.0f,
-        0.0f, size / 2, 0.0f,  0.0f, 1.0f, 0.0f,
+        0.0f, 1.0f, 0.0f,  0.0f, 1.0f, 0.0f,
         // Z-axis
         0.0f, 0.0f, 0.0f,  0.0f, 0.0f, 1.0f,
-        0.0f, 0.0f, size / 2,  0.0f, 0.0f, 1.0f
+        0.0f, 0.0f, 1.0f,  0.0f, 0.0f, 1.0f
     };
 
     // Generate and bind VAO and VBO
@@ -98,23 +72,64 @@ void Renderer::setupCoordinateSystem() {
     glBindVertexArray(0);
 
     // Load the shader for axes
-    axisShaderProgram = std::make_unique<Shader>("shaders/default.vert", "shaders/default.frag");
+    axisShaderProgram = std::make_unique<Shader>("Shaders/default.vert", "Shaders/default.frag");
 }
 
 void Renderer::setupPickingShader()
 {
     // Create a new shader program for picking
-    pickingShaderProgram = std::make_unique<Shader>("shaders/picking.vert", "shaders/picking.frag");
+    pickingShaderProgram = std::make_unique<Shader>("Shaders/picking.vert", "Shaders/picking.frag");
+}
+
+// Creates a buffer texture holding one value per triangle (or per 32 triangles for bitsets).
+// Returns the bytes allocated on the GPU.
+static size_t createTriangleBufferTexture(GLObjectName& buffer, GLObjectName& texture, GLenum format, const void* data, size_t bytes)
+{
+    glGenBuffers(1, &buffer.value);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    // Never allocate an empty buffer, texture buffers need at least one texel
+    size_t allocated = std::max<size_t>(bytes, 4);
+    glBufferData(GL_TEXTURE_BUFFER, allocated, nullptr, GL_DYNAMIC_DRAW);
+    if (bytes > 0) {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+    }
+
+    glGenTextures(1, &texture.value);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    return allocated;
+}
+
+// Uploads only the pages that changed since the last frame
+static void uploadDirtyPages(GLuint buffer, const void* data, size_t elementSize, size_t elementCount, DirtyPages& dirty)
+{
+    if (buffer == 0 || dirty.Empty()) return;
+
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    dirty.ForEachRun(elementCount, [&](size_t first, size_t last) {
+        glBufferSubData(GL_TEXTURE_BUFFER,
+            first * elementSize,
+            (last - first) * elementSize,
+            static_cast<const char*>(data) + first * elementSize);
+    });
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    dirty.Reset();
 }
 
 void Renderer::setupSceneCollection() // This is where we pass layout inputs
 {
     for (int i = 0; i < this->sceneCollectionMeshes.size(); ++i)
     {
+        // Meshes that already own GPU buffers keep them, only new meshes are uploaded
+        if (sceneCollectionMeshes[i].VAO_obj != 0) continue;
+
         // Generate and bind VAO and VBO
-        glGenVertexArrays(1, &sceneCollectionMeshes[i].VAO_obj);
-        glGenBuffers(1, &sceneCollectionMeshes[i].VBO_obj);
-        glGenBuffers(1, &sceneCollectionMeshes[i].EBO_obj); // Create an Element Buffer Object for indices
+        glGenVertexArrays(1, &sceneCollectionMeshes[i].VAO_obj.value);
+        glGenBuffers(1, &sceneCollectionMeshes[i].VBO_obj.value);
+        glGenBuffers(1, &sceneCollectionMeshes[i].EBO_obj.value); // Create an Element Buffer Object for indices
 
         glBindVertexArray(sceneCollectionMeshes[i].VAO_obj);
         // Bind and set vertex buffer data
@@ -134,8 +149,21 @@ void Renderer::setupSceneCollection() // This is where we pass layout inputs
 
         glBindVertexArray(0); // Unbind VAO
 
+        // Per triangle data as texture buffers, the fragment shader indexes them with gl_PrimitiveID
+        Mesh& mesh = sceneCollectionMeshes[i];
+        mesh.SetMaterialReflectivities(materials.NormalReflectivities());
+        size_t gpuBytes = mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(GLuint);
+        gpuBytes += createTriangleBufferTexture(mesh.selectionBuffer, mesh.selectionTexture, GL_R32UI,
+            mesh.selectionMask.data(), mesh.selectionMask.size() * sizeof(GLuint));
+        mesh.selectionDirty.Reset();
+
+        gpuBytes += createTriangleBufferTexture(mesh.heatMapBuffer, mesh.heatMapTexture, GL_R32F,
+            mesh.heatMapValues.data(), mesh.heatMapValues.size() * sizeof(float));
+        mesh.heatMapDirty.Reset();
+        mesh.gpuMemory.Set(gpuBytes);
+
         // Load the shader for object
-        sceneCollectionMeshes[i].objectShaderProgram = std::make_unique<Shader>("shaders/default.vert", "shaders/default.frag");
+        sceneCollectionMeshes[i].objectShaderProgram = std::make_unique<Shader>("Shaders/default.vert", "Shaders/default.frag");
         
         // Initialize the model matrix for this mesh
         sceneCollectionMeshes[i].UpdateModelMatrix();
@@ -144,40 +172,45 @@ void Renderer::setupSceneCollection() // This is where we pass layout inputs
 
 void Renderer::drawGridLayout()
 {
-    if (gridNeedsUpdate) {
-        glDeleteBuffers(1, &VBO_grid);
-        glDeleteVertexArrays(1, &VAO_grid);
-        setupGridLayout();
-        setupCoordinateSystem();
-        gridNeedsUpdate = false;
-    }
+    PROFILE_SCOPE("Draw grid");
+    GpuPassScope gpuPass(gpuTimer, GpuPass::Grid);
+    // Adaptive subdivision: every decade of camera height multiplies the spacing by 10.
+    // Same formula as grid.frag, kept here so the inspector can show the current step.
+    float baseStep = size / divisions;
+    float cameraHeight = std::max(std::abs(camera.Position.y), 1e-4f);
+    float lod = std::max(0.0f, std::log10(cameraHeight / baseStep) - 1.0f);
+    step = baseStep * std::pow(10.0f, std::floor(lod));
 
     gridShaderProgram->Activate();
 
-    // Create an identity model matrix (no transformations for grid system)
-    glm::mat4 modelMatrix = glm::mat4(1.0f);
+    // The fragment shader unprojects each pixel and intersects the y = 0 plane
+    glm::mat4 viewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+    glUniformMatrix4fv(glGetUniformLocation(gridShaderProgram->ID, "invCamMatrix"), 1, GL_FALSE, glm::value_ptr(glm::inverse(viewProjection)));
+    glUniform3fv(glGetUniformLocation(gridShaderProgram->ID, "cameraPos"), 1, glm::value_ptr(camera.Position));
+    glUniform3fv(glGetUniformLocation(gridShaderProgram->ID, "gridColor"), 1, glm::value_ptr(gridColor));
+    glUniform1f(glGetUniformLocation(gridShaderProgram->ID, "baseStep"), baseStep);
+    glUniform1f(glGetUniformLocation(gridShaderProgram->ID, "halfSize"), size / 2.0f);
+    glUniform1f(glGetUniformLocation(gridShaderProgram->ID, "fadeDistance"), camera.farPlane);
 
-    // Pass the model matrix to the shader
-    glUniformMatrix4fv(
-        glGetUniformLocation(axisShaderProgram->ID, "modelMatrix"),
-        1,
-        GL_FALSE,
-        glm::value_ptr(modelMatrix)
-    );
-
-    camera.Matrix(camera.fov, camera.nearPlane, camera.farPlane, *gridShaderProgram, "camMatrix");
+    // Lines fade out with distance, blend them over the background
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     glBindVertexArray(VAO_grid);
-    glDrawArrays(GL_LINES, 0, (divisions + 1) * 4);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
     glBindVertexArray(0);
+
+    glDisable(GL_BLEND);
 }
 
 void Renderer::drawCoordinateSystem() {
+    PROFILE_SCOPE("Draw axes");
+    GpuPassScope gpuPass(gpuTimer, GpuPass::Axes);
     // Activate the shader program
     axisShaderProgram->Activate();
 
-    // Create an identity model matrix (no transformations for coordinate system)
-    glm::mat4 modelMatrix = glm::mat4(1.0f);
+    // Scale the unit axes to half the grid size
+    glm::mat4 modelMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(size / 2.0f));
 
     // Pass the model matrix to the shader
     glUniformMatrix4fv(
@@ -197,103 +230,157 @@ void Renderer::drawCoordinateSystem() {
 }
 
 void Renderer::drawSceneCollection() {
+    PROFILE_SCOPE("Draw scene");
+    GpuPassScope gpuPass(gpuTimer, GpuPass::Scene);
+    for (int i : visibleMeshIndices) {
+        // Activate the mesh's shader program
+        sceneCollectionMeshes[i].objectShaderProgram->Activate();
+
+        // Set mode
+        glPolygonMode(GL_FRONT_AND_BACK, this->isWireframeMode ? GL_LINE : GL_FILL);
+
+        // Model matrix is refreshed once per frame in updateVisibility()
+        glm::mat4 modelMatrix = sceneCollectionMeshes[i].GetModelMatrix();
+
+        // Pass the model matrix to the shader
+        glUniformMatrix4fv(
+            glGetUniformLocation(sceneCollectionMeshes[i].objectShaderProgram->ID, "modelMatrix"),
+            1, GL_FALSE, glm::value_ptr(modelMatrix)
+        );
+
+        // Set the camera matrix
+        camera.Matrix(camera.fov, camera.nearPlane, camera.farPlane,
+            *sceneCollectionMeshes[i].objectShaderProgram, "camMatrix");
+
+        // Bind the VAO
+        glBindVertexArray(sceneCollectionMeshes[i].VAO_obj);
+
+        // Push only the per triangle values that changed since the last frame
+        uploadTriangleData(sceneCollectionMeshes[i]);
+
+        GLuint programID = sceneCollectionMeshes[i].objectShaderProgram->ID;
+
+        // Selected triangles are highlighted in the fragment shader, one draw per mesh
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, sceneCollectionMeshes[i].selectionTexture);
+        glUniform1i(glGetUniformLocation(programID, "selectionMask"), 1);
+        glUniform1i(glGetUniformLocation(programID, "useSelectionMask"), sceneCollectionMeshes[i].selectedTriangleCount > 0);
+        glUniform3f(glGetUniformLocation(programID, "highlightColor"), 0.0f, 1.0f, 0.0f);  // Green highlight
+
+        // Heat map colors every triangle by its value through the colormap
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_BUFFER, sceneCollectionMeshes[i].heatMapTexture);
+        glUniform1i(glGetUniformLocation(programID, "heatMapValues"), 2);
+        glUniform1i(glGetUniformLocation(programID, "useHeatMap"), isHeatMapMode);
+        glUniform1i(glGetUniformLocation(programID, "heatMapLogScale"), heatMapLogScale);
+        glUniform2f(glGetUniformLocation(programID, "heatMapRange"), heatMapRange.x, heatMapRange.y);
+
+        glDrawElements(GL_TRIANGLES, sceneCollectionMeshes[i].indices.size(), GL_UNSIGNED_INT, 0);
+
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(0);
+    }
+}
+
+void Renderer::uploadTriangleData(Mesh& mesh)
+{
+    uploadDirtyPages(mesh.selectionBuffer, mesh.selectionMask.data(), sizeof(GLuint), mesh.selectionMask.size(), mesh.selectionDirty);
+
+    if (isHeatMapMode) {
+        // Switching the source refills the values and marks them all dirty
+        mesh.SetHeatMapSource(heatMapSource);
+        uploadDirtyPages(mesh.heatMapBuffer, mesh.heatMapValues.data(), sizeof(float), mesh.heatMapValues.size(), mesh.heatMapDirty);
+    }
+}
+
+void Renderer::clearSelection()
+{
+    for (auto& mesh : sceneCollectionMeshes) {
+        mesh.ClearSelection();
+    }
+    pickedObjectID = -1;
+    pickedTriangleID = -1;
+}
+
+void Renderer::updateVisibility()
+{
+    PROFILE_SCOPE("Visibility");
+    m_frameArena.Reset();
+    visibleMeshIndices.clear();
+    frustumCulledCount = 0;
+    occlusionCulledCount = 0;
+
+    glm::mat4 viewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+    m_frustum.Update(viewProjection);
+
+    // Frustum pass against the cached world space bounding boxes
     for (int i = 0; i < sceneCollectionMeshes.size(); ++i) {
-        if (sceneCollectionMeshes[i].isVisible) {
-            // Activate the mesh's shader program
-            sceneCollectionMeshes[i].objectShaderProgram->Activate();
-
-            // Set mode
-            glPolygonMode(GL_FRONT_AND_BACK, this->isWireframeMode ? GL_LINE : GL_FILL);
-
-            // Update model matrix
-            sceneCollectionMeshes[i].UpdateModelMatrix();
-            glm::mat4 modelMatrix = sceneCollectionMeshes[i].GetModelMatrix();
-
-            // Pass the model matrix to the shader
-            glUniformMatrix4fv(
-                glGetUniformLocation(sceneCollectionMeshes[i].objectShaderProgram->ID, "modelMatrix"),
-                1, GL_FALSE, glm::value_ptr(modelMatrix)
-            );
-
-            // Set the camera matrix
-            camera.Matrix(camera.fov, camera.nearPlane, camera.farPlane,
-                *sceneCollectionMeshes[i].objectShaderProgram, "camMatrix");
-
-            // Bind the VAO
-            glBindVertexArray(sceneCollectionMeshes[i].VAO_obj);
-
-            // Check if this is the picked object
-            if (i == pickedObjectID) {
-                // Calculate the number of indices and triangles
-                size_t numIndices = sceneCollectionMeshes[i].indices.size();
-                size_t numTriangles = numIndices / 3;
-
-                // Make sure the picked triangle is valid
-                if (pickedTriangleID >= 0 && pickedTriangleID < numTriangles) {
-                    // Set highlight uniform to 0 (not highlighted) for non-picked triangles
-                    glUniform1i(
-                        glGetUniformLocation(sceneCollectionMeshes[i].objectShaderProgram->ID, "isHighlighted"),
-                        0
-                    );
-
-                    // Draw the triangles before the picked triangle
-                    if (pickedTriangleID > 0) {
-                        size_t beforeIndices = pickedTriangleID * 3;
-                        glDrawElements(GL_TRIANGLES, beforeIndices, GL_UNSIGNED_INT, 0);
-                    }
-
-                    // Draw the triangles after the picked triangle
-                    if (pickedTriangleID < numTriangles - 1) {
-                        size_t startIndex = (pickedTriangleID + 1) * 3;
-                        size_t afterIndices = numIndices - startIndex;
-                        glDrawElements(GL_TRIANGLES, afterIndices, GL_UNSIGNED_INT,
-                            (void*)(startIndex * sizeof(GLuint)));
-                    }
-
-                    // Now draw the picked triangle with highlighting
-                    glUniform1i(
-                        glGetUniformLocation(sceneCollectionMeshes[i].objectShaderProgram->ID, "isHighlighted"),
-                        1
-                    );
-                    glUniform3f(
-                        glGetUniformLocation(sceneCollectionMeshes[i].objectShaderProgram->ID, "highlightColor"),
-                        0.0f, 1.0f, 0.0f  // Green highlight
-                    );
-
-                    // Draw just the picked triangle
-                    size_t startIndex = pickedTriangleID * 3;
-                    glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT,
-                        (void*)(startIndex * sizeof(GLuint)));
-                }
-                else {
-                    // Invalid triangle ID, draw the whole object
-                    glUniform1i(
-                        glGetUniformLocation(sceneCollectionMeshes[i].objectShaderProgram->ID, "isHighlighted"),
-                        0
-                    );
-                    glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0);
-                }
-            }
-            else {
-                // Not the picked object, draw normally
-                glUniform1i(
-                    glGetUniformLocation(sceneCollectionMeshes[i].objectShaderProgram->ID, "isHighlighted"),
-                    0
-                );
-                glDrawElements(GL_TRIANGLES, sceneCollectionMeshes[i].indices.size(), GL_UNSIGNED_INT, 0);
-            }
-
-            glBindVertexArray(0);
+        Mesh& mesh = sceneCollectionMeshes[i];
+        if (!mesh.isVisible) continue;
+
+        // Cheap, only transforms the cached local box
+        mesh.UpdateModelMatrix();
+
+        if (frustumCullingEnabled && !m_frustum.Intersects(mesh.worldBounds)) {
+            frustumCulledCount++;
+            continue;
+        }
+        visibleMeshIndices.push_back(i);
+    }
+
+    if (!occlusionCullingEnabled || visibleMeshIndices.size() < 2) return;
+
+    // Pick the largest on screen meshes as occluders
+    m_occlusionBuffer.Clear(viewProjection);
+
+    std::pair<float, int>* occluderCandidates = m_frameArena.AllocateArray<std::pair<float, int>>(visibleMeshIndices.size());
+    size_t candidateCount = 0;
+    for (int i : visibleMeshIndices) {
+        const Mesh& mesh = sceneCollectionMeshes[i];
+        if (mesh.numTriangles > occluderTriangleBudget) continue;
+
+        float coverage = m_occlusionBuffer.ScreenCoverage(mesh.worldBounds);
+        if (coverage >= occluderMinCoverage) {
+            occluderCandidates[candidateCount++] = { coverage, i };
         }
     }
+    if (candidateCount == 0) return;
+
+    std::sort(occluderCandidates, occluderCandidates + candidateCount,
+        [](const auto& a, const auto& b) { return a.first > b.first; });
+    candidateCount = std::min(candidateCount, static_cast<size_t>(std::max(maxOccluders, 0)));
+
+    bool* isOccluder = m_frameArena.AllocateArray<bool>(sceneCollectionMeshes.size());
+    for (size_t c = 0; c < candidateCount; ++c) {
+        m_occlusionBuffer.RasterizeOccluder(sceneCollectionMeshes[occluderCandidates[c].second]);
+        isOccluder[occluderCandidates[c].second] = true;
+    }
+
+    // Compact the visibility list in place, occluders always stay visible
+    size_t writeIndex = 0;
+    for (int i : visibleMeshIndices) {
+        if (isOccluder[i] || m_occlusionBuffer.IsVisible(sceneCollectionMeshes[i].worldBounds)) {
+            visibleMeshIndices[writeIndex++] = i;
+        }
+        else {
+            occlusionCulledCount++;
+        }
+    }
+    visibleMeshIndices.resize(writeIndex);
 }
 
 void Renderer::drawPickingTexture() {
+    PROFILE_SCOPE("Picking pass");
+    GpuPassScope gpuPass(gpuTimer, GpuPass::Picking);
     // Enable writing to the picking texture
     m_pickingTexture.EnableWriting();
 
-    // Clear the buffers
+    // Clear the buffers, the nearest surface must win where meshes overlap
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
 
     // Activate the picking shader
     pickingShaderProgram->Activate();
@@ -303,8 +390,8 @@ void Renderer::drawPickingTexture() {
     glDrawBuffers(1, drawBuffers);
 
     // Calculate view and projection matrices from the camera
-    glm::mat4 viewMatrix = glm::lookAt(camera.Position, camera.Position + camera.Orientation, camera.Up);
-    glm::mat4 projectionMatrix = glm::perspective(glm::radians(camera.fov), (float)camera.width / camera.height, camera.nearPlane, camera.farPlane);
+    glm::mat4 viewMatrix = camera.GetViewMatrix();
+    glm::mat4 projectionMatrix = camera.GetProjectionMatrix();
 
     // Set camera view and projection matrices as uniforms
     glUniformMatrix4fv(
@@ -318,89 +405,374 @@ void Renderer::drawPickingTexture() {
     );
 
     // Draw each mesh in the scene collection with a unique object ID
-    for (int i = 0; i < sceneCollectionMeshes.size(); ++i) {
-        if (sceneCollectionMeshes[i].isVisible) {
-            // Set object index (starting from 1, since 0 is background)
-            glUniform1ui(
-                glGetUniformLocation(pickingShaderProgram->ID, "objectIndex"),
-                i + 1
-            );
-
-            // Set drawing index (using same index for now)
-            glUniform1ui(
-                glGetUniformLocation(pickingShaderProgram->ID, "drawIndex"),
-                i + 1
-            );
-
-            // Update and set the model matrix
-            sceneCollectionMeshes[i].UpdateModelMatrix();
-            glm::mat4 modelMatrix = sceneCollectionMeshes[i].GetModelMatrix();
-
-            // Pass the model matrix to the shader
-            glUniformMatrix4fv(
-                glGetUniformLocation(pickingShaderProgram->ID, "modelMatrix"),
-                1, GL_FALSE, glm::value_ptr(modelMatrix)
-            );
-
-            // Bind the VAO and draw the mesh
-            glBindVertexArray(sceneCollectionMeshes[i].VAO_obj);
-
-            // Draw the elements - primitive IDs are automatically assigned
-            glDrawElements(GL_TRIANGLES, sceneCollectionMeshes[i].indices.size(), GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
-        }
+    for (int i : visibleMeshIndices) {
+        // Set object index (starting from 1, since 0 is background)
+        glUniform1ui(
+            glGetUniformLocation(pickingShaderProgram->ID, "objectIndex"),
+            i + 1
+        );
+
+        // Set drawing index (using same index for now)
+        glUniform1ui(
+            glGetUniformLocation(pickingShaderProgram->ID, "drawIndex"),
+            i + 1
+        );
+
+        // Set the model matrix
+        glm::mat4 modelMatrix = sceneCollectionMeshes[i].GetModelMatrix();
+
+        // Pass the model matrix to the shader
+        glUniformMatrix4fv(
+            glGetUniformLocation(pickingShaderProgram->ID, "modelMatrix"),
+            1, GL_FALSE, glm::value_ptr(modelMatrix)
+        );
+
+        // Bind the VAO and draw the mesh
+        glBindVertexArray(sceneCollectionMeshes[i].VAO_obj);
+
+        // Draw the elements - primitive IDs are automatically assigned
+        glDrawElements(GL_TRIANGLES, sceneCollectionMeshes[i].indices.size(), GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
     }
 
     // Disable writing to the picking texture
     m_pickingTexture.DisableWriting();
+    glDisable(GL_DEPTH_TEST);
+}
+
+void Renderer::resize(int windowWidth, int windowHeight, int framebufferWidth, int framebufferHeight)
+{
+    if (windowWidth <= 0 || windowHeight <= 0 || framebufferWidth <= 0 || framebufferHeight <= 0) return; // Minimized
+
+    // The camera works in window coordinates (cursor), GL in framebuffer pixels
+    camera.width = windowWidth;
+    camera.height = windowHeight;
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
+    m_pickingTexture.Resize(framebufferWidth, framebufferHeight);
+}
+
+void Renderer::pick(int x, int y, SelectionMode mode)
+{
+    m_pickStartTime = std::chrono::high_resolution_clock::now();
+    m_pickMode = mode;
+
+    if (useGPUPicking) {
+        // Render the ID buffer and queue the readback, resolvePendingPicks() finishes the pick
+        drawPickingTexture();
 
-    // If the mouse is clicked, read the pixel to determine which object was clicked
-    if (m_InputManager.m_leftMouseButton.IsPressed) {
-        // Get the window size
         int width, height;
         glfwGetWindowSize(glfwGetCurrentContext(), &width, &height);
+        if (width <= 0 || height <= 0) return;
 
-        // Read the pixel at the mouse position
-        PickingTexture::PixelInfo pixel = m_pickingTexture.ReadPixel(
-            m_InputManager.m_leftMouseButton.x,
-            height - m_InputManager.m_leftMouseButton.y - 1  // Convert to OpenGL coordinates
-        );
+        // Window coordinates to framebuffer pixels, with the origin at the bottom
+        int pixelX = x * static_cast<int>(m_pickingTexture.GetWidth()) / width;
+        int pixelY = static_cast<int>(m_pickingTexture.GetHeight()) - 1 - y * static_cast<int>(m_pickingTexture.GetHeight()) / height;
+        m_pickingTexture.RequestRegion(pixelX, pixelY, pickRegionRadius);
+        return;
+    }
 
-        // Update the picked object ID and triangle ID
+    RayHit hit;
+    finishPick(raycast(x, y, hit), hit);
+}
+
+void Renderer::resolvePendingPicks()
+{
+    PROFILE_SCOPE("Resolve picks");
+    // Take the newest finished read, older ones are superseded
+    PickingTexture::PickRegion region;
+    bool resolved = false;
+    while (m_pickingTexture.PollRegion(region)) {
+        lastPickRegion = std::move(region);
+        resolved = true;
+    }
+
+    if (resolved) {
+        PickingTexture::PixelInfo pixel = lastPickRegion.Center();
+
+        RayHit hit;
         if (pixel.ObjectID != 0) {
-            // Store the previous selections
-            int prevObjectID = pickedObjectID;
-            int prevTriangleID = pickedTriangleID;
-
-            // Update the current selections
-            pickedObjectID = pixel.ObjectID - 1;  // Subtract 1 to get back to 0-based index
-            pickedTriangleID = pixel.PrimID;      // Store the primitive (triangle) ID
-
-            // If we have a valid selection, update the triangle's properties
-            if (pickedObjectID >= 0 && pickedObjectID < sceneCollectionMeshes.size()) {
-                Mesh& mesh = sceneCollectionMeshes[pickedObjectID];
-
-                // Clear previous selection if it exists
-                if (prevObjectID >= 0 && prevObjectID < sceneCollectionMeshes.size() &&
-                    prevTriangleID >= 0 && prevTriangleID < sceneCollectionMeshes[prevObjectID].triangles.size()) {
-                    sceneCollectionMeshes[prevObjectID].SetTriangleSelected(prevTriangleID, false);
-                }
-
-                // Set new selection
-                if (pickedTriangleID >= 0 && pickedTriangleID < mesh.triangles.size()) {
-                    mesh.SetTriangleSelected(pickedTriangleID, true);
-                    }
-                }
-            }
+            hit.meshIndex = pixel.ObjectID - 1;  // Subtract 1 to get back to 0-based index
+            hit.triangleIndex = pixel.PrimID;    // The primitive (triangle) ID
         }
-        else {
-            // Clear selection if clicking on background
-            if (pickedObjectID >= 0 && pickedObjectID < sceneCollectionMeshes.size() &&
-                pickedTriangleID >= 0 && pickedTriangleID < sceneCollectionMeshes[pickedObjectID].triangles.size()) {
-                sceneCollectionMeshes[pickedObjectID].SetTriangleSelected(pickedTriangleID, false);
-            }
-
-            pickedObjectID = -1;  // No object picked
-            pickedTriangleID = -1;  // No triangle picked
+        finishPick(pixel.ObjectID != 0, hit);
+    }
+
+    // Keep frames coming until the GPU has delivered every queued read
+    if (m_pickingTexture.HasPendingReads()) {
+        InputManager::RequestRedraw();
+    }
+}
+
+void Renderer::finishPick(bool found, const RayHit& hit)
+{
+    lastPickTimeUs = std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - m_pickStartTime).count();
+    lastPickHit = hit;
+
+    if (found) applyPick(hit.meshIndex, hit.triangleIndex);
+    else applyPick(-1, -1);
+}
+
+bool Renderer::raycast(int x, int y, RayHit& hit)
+{
+    int width, height;
+    glfwGetWindowSize(glfwGetCurrentContext(), &width, &height);
+    if (width <= 0 || height <= 0) return false;
+
+    glm::vec3 origin, direction;
+    camera.ScreenPointToRay(x + 0.5, y + 0.5, width, height, origin, direction);
+    glm::vec3 inverseDirection = 1.0f / direction;
+
+    hit = RayHit();
+    hit.distance = camera.farPlane;
+
+    uint64_t raysTraced = 0;
+    for (int i : visibleMeshIndices) {
+        Mesh& mesh = sceneCollectionMeshes[i];
+
+        // Cheap world space rejection before touching the hierarchy
+        if (RayIntersectsAABB(mesh.worldBounds, origin, inverseDirection, hit.distance) == FLT_MAX) continue;
+
+        // Trace in model space, the direction is left unnormalized so t stays in world units
+        glm::mat4 inverseModel = glm::inverse(mesh.GetModelMatrix());
+        glm::vec3 localOrigin = glm::vec3(inverseModel * glm::vec4(origin, 1.0f));
+        glm::vec3 localDirection = glm::vec3(inverseModel * glm::vec4(direction, 0.0f));
+
+        RayHit meshHit;
+        meshHit.distance = hit.distance;
+        raysTraced++;
+        if (mesh.GetBVH().Raycast(mesh, localOrigin, localDirection, meshHit)) {
+            hit.distance = meshHit.distance;
+            hit.triangleIndex = meshHit.triangleIndex;
+            hit.meshIndex = i;
         }
+    }
+    Profiler::Count("Rays traced", raysTraced);
+
+    if (hit.meshIndex < 0) return false;
+    hit.point = origin + direction * hit.distance;
+    return true;
+}
+
+void Renderer::applyPick(int objectID, int triangleID)
+{
+    bool valid = objectID >= 0 && objectID < sceneCollectionMeshes.size() &&
+        triangleID >= 0 && triangleID < sceneCollectionMeshes[objectID].triangles.size();
+
+    // A plain click starts a new selection, clicking the background clears it
+    if (m_pickMode == SelectionMode::Replace) clearSelection();
+    if (!valid) return;
+
+    Mesh& mesh = sceneCollectionMeshes[objectID];
+    bool select = (m_pickMode != SelectionMode::Subtract);
+    mesh.SetTriangleSelected(triangleID, select);
+
+    // The Object Editor shows the last picked triangle
+    pickedObjectID = select ? objectID : -1;
+    pickedTriangleID = select ? triangleID : -1;
+}
+
+void Renderer::applySelection(int meshIndex, const std::vector<uint32_t>& triangles, SelectionMode mode)
+{
+    Mesh& mesh = sceneCollectionMeshes[meshIndex];
+    bool select = (mode != SelectionMode::Subtract);
+    for (uint32_t triangle : triangles) {
+        mesh.SetTriangleSelected(triangle, select);
+    }
+
+    // Let the Object Editor show the first triangle of a new selection
+    if (select && !triangles.empty() && pickedObjectID < 0) {
+        pickedObjectID = meshIndex;
+        pickedTriangleID = static_cast<int>(triangles.front());
+    }
+}
+
+// Maps a window rectangle to the full clip space, narrowing the projection to that region
+static glm::mat4 RegionMatrix(glm::vec2 regionMin, glm::vec2 regionMax, int width, int height)
+{
+    // Window coordinates (y down) to normalized device coordinates (y up)
+    glm::vec2 ndcMin(2.0f * regionMin.x / width - 1.0f, 1.0f - 2.0f * regionMax.y / height);
+    glm::vec2 ndcMax(2.0f * regionMax.x / width - 1.0f, 1.0f - 2.0f * regionMin.y / height);
+    glm::vec2 size = glm::max(ndcMax - ndcMin, glm::vec2(1e-6f));
+
+    glm::mat4 region(1.0f);
+    region[0][0] = 2.0f / size.x;
+    region[1][1] = 2.0f / size.y;
+    region[3][0] = -(ndcMax.x + ndcMin.x) / size.x;
+    region[3][1] = -(ndcMax.y + ndcMin.y) / size.y;
+    return region;
+}
+
+size_t Renderer::selectInRectangle(glm::vec2 corner0, glm::vec2 corner1, SelectionMode mode)
+{
+    return selectInRegion(glm::min(corner0, corner1), glm::max(corner0, corner1), nullptr, mode);
+}
+
+size_t Renderer::selectInLasso(const std::vector<glm::vec2>& polygon, SelectionMode mode)
+{
+    if (polygon.size() < 3) return 0;
+
+    glm::vec2 regionMin(FLT_MAX), regionMax(-FLT_MAX);
+    for (const auto& point : polygon) {
+        regionMin = glm::min(regionMin, point);
+        regionMax = glm::max(regionMax, point);
+    }
+    return selectInRegion(regionMin, regionMax, &polygon, mode);
+}
+
+// Even-odd rule point in polygon test
+static bool PointInPolygon(const glm::vec2& point, const std::vector<glm::vec2>& polygon)
+{
+    bool inside = false;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        const glm::vec2& a = polygon[i];
+        const glm::vec2& b = polygon[j];
+        if ((a.y > point.y) != (b.y > point.y) &&
+            point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+size_t Renderer::selectInRegion(glm::vec2 regionMin, glm::vec2 regionMax, const std::vector<glm::vec2>* lasso, SelectionMode mode)
+{
+    PROFILE_SCOPE("Region selection");
+    auto start = std::chrono::high_resolution_clock::now();
+
+    int width, height;
+    glfwGetWindowSize(glfwGetCurrentContext(), &width, &height);
+    if (width <= 0 || height <= 0) return 0;
+    if (regionMax.x - regionMin.x < 1.0f || regionMax.y - regionMin.y < 1.0f) return 0;
+
+    if (mode == SelectionMode::Replace) clearSelection();
+
+    glm::mat4 viewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+    glm::mat4 regionViewProjection = RegionMatrix(regionMin, regionMax, width, height) * viewProjection;
+
+    size_t count = 0;
+    std::vector<uint32_t> triangles;
+    for (int i : visibleMeshIndices) {
+        Mesh& mesh = sceneCollectionMeshes[i];
+
+        // The region frustum is moved into model space, so the hierarchy is queried as built
+        Frustum frustum;
+        frustum.Update(regionViewProjection * mesh.GetModelMatrix());
+        if (!frustum.Intersects(mesh.localBounds)) continue;
+
+        triangles.clear();
+        mesh.GetBVH().QueryFrustum(mesh, frustum, triangles);
+
+        // The lasso refines the bounding rectangle with the projected centroids
+        if (lasso) {
+            glm::mat4 mvp = viewProjection * mesh.GetModelMatrix();
+            auto outside = [&](uint32_t triangle) {
+                glm::vec3 centroid = (mesh.vertices[mesh.indices[triangle * 3]].position +
+                                      mesh.vertices[mesh.indices[triangle * 3 + 1]].position +
+                                      mesh.vertices[mesh.indices[triangle * 3 + 2]].position) / 3.0f;
+                glm::vec4 clip = mvp * glm::vec4(centroid, 1.0f);
+                glm::vec2 window((clip.x / clip.w * 0.5f + 0.5f) * width, (0.5f - clip.y / clip.w * 0.5f) * height);
+                return !PointInPolygon(window, *lasso);
+            };
+            triangles.erase(std::remove_if(triangles.begin(), triangles.end(), outside), triangles.end());
+        }
+
+        applySelection(i, triangles, mode);
+        count += triangles.size();
+    }
+
+    lastSelectionTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return count;
+}
+
+size_t Renderer::selectConnected(bool coplanarOnly, float maxAngleDegrees, SelectionMode mode)
+{
+    PROFILE_SCOPE("Connected selection");
+    if (pickedObjectID < 0 || pickedObjectID >= sceneCollectionMeshes.size()) return 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    int meshIndex = pickedObjectID;
+    uint32_t seed = static_cast<uint32_t>(pickedTriangleID);
+    Mesh& mesh = sceneCollectionMeshes[meshIndex];
+    if (seed >= mesh.triangles.size()) return 0;
+
+    const TriangleAdjacency& adjacency = mesh.GetAdjacency();
+    float minCosine = std::cos(glm::radians(maxAngleDegrees));
+    glm::vec3 seedNormal = mesh.triangles[seed].normal;
+
+    // Breadth first flood fill over shared edges
+    std::vector<uint32_t> region;
+    std::vector<bool> visited(mesh.triangles.size(), false);
+    region.push_back(seed);
+    visited[seed] = true;
+    for (size_t head = 0; head < region.size(); ++head) {
+        uint32_t triangle = region[head];
+        for (uint32_t n = adjacency.offsets[triangle]; n < adjacency.offsets[triangle + 1]; ++n) {
+            uint32_t neighbour = adjacency.neighbours[n];
+            if (visited[neighbour]) continue;
+            visited[neighbour] = true;
+
+            if (coplanarOnly && glm::dot(mesh.triangles[neighbour].normal, seedNormal) < minCosine) continue;
+            region.push_back(neighbour);
+        }
+    }
+
+    if (mode == SelectionMode::Replace) clearSelection();
+    applySelection(meshIndex, region, mode);
+
+    lastSelectionTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return region.size();
+}
+
+size_t Renderer::getSelectedTriangleCount() const
+{
+    size_t count = 0;
+    for (const auto& mesh : sceneCollectionMeshes) {
+        count += mesh.selectedTriangleCount;
+    }
+    return count;
+}
+
+void Renderer::setSelectionMaterial(MaterialID material)
+{
+    for (auto& mesh : sceneCollectionMeshes) {
+        if (mesh.selectedTriangleCount == 0) continue;
+        mesh.ForEachSelectedTriangle([&](size_t triangle) {
+            mesh.SetTriangleMaterial(triangle, material);
+        });
+    }
+}
+
+size_t Renderer::paintMaterial(const glm::vec3& center, float radius, MaterialID material)
+{
+    PROFILE_SCOPE("Paint material");
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t changed = 0;
+
+    std::vector<uint32_t> brushTriangles;
+    for (int i : visibleMeshIndices) {
+        Mesh& mesh = sceneCollectionMeshes[i];
+
+        // World space sphere against the mesh bounds first
+        glm::vec3 offset = center - glm::clamp(center, mesh.worldBounds.min, mesh.worldBounds.max);
+        if (glm::dot(offset, offset) > radius * radius) continue;
+
+        // The query runs in model space. Non uniform scale turns the brush into an ellipsoid there,
+        // the geometric mean of the scale keeps the covered area close to the world space one.
+        glm::vec3 localCenter = glm::vec3(glm::inverse(mesh.GetModelMatrix()) * glm::vec4(center, 1.0f));
+        float meanScale = std::cbrt(std::abs(mesh.scale.x * mesh.scale.y * mesh.scale.z));
+        if (meanScale <= 0.0f) continue;
+
+        brushTriangles.clear();
+        mesh.GetBVH().QuerySphere(mesh, localCenter, radius / meanScale, brushTriangles);
+
+        // Only triangles whose value actually changes are marked for upload and for the solver
+        for (uint32_t triangle : brushTriangles) {
+            if (mesh.SetTriangleMaterial(triangle, material)) changed++;
+        }
+    }
+
+    lastPaintCount = changed;
+    lastPaintTimeUs = std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+    return changed;
 }
@@ -4,12 +4,24 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <vector>
+#include <chrono>
 
-#include "shaderClass.h"
+#include "ShaderClass.h"
 #include "Camera.h"
 #include "Mesh.h"
 #include "InputManager.h"
 #include "PickingTexture.h"
+#include "Culling.h"
+#include "Material.h"
+#include "GpuTimer.h"
+#include "ScratchArena.h"
+
+// How a new selection combines with the current one
+enum class SelectionMode {
+    Replace,
+    Add,
+    Subtract
+};
 
 class Renderer {
 public:
@@ -19,6 +31,7 @@ public:
     Camera camera;
     InputManager m_InputManager;
     std::vector<Mesh>sceneCollectionMeshes;
+    MaterialLibrary materials;
 
     void setupGridLayout();
     void setupSceneCollection();
@@ -30,29 +43,88 @@ public:
     void drawSceneCollection();
     void drawPickingTexture();
 
-    // Grid
-    bool gridNeedsUpdate = false;
+    // Culling
+    void updateVisibility();
+
+    // Selection
+    void uploadTriangleData(Mesh& mesh); // Uploads only the changed selection words and heat map values
+    void clearSelection();
+    size_t selectInRectangle(glm::vec2 corner0, glm::vec2 corner1, SelectionMode mode); // Window coordinates
+    size_t selectInLasso(const std::vector<glm::vec2>& polygon, SelectionMode mode);
+    size_t selectConnected(bool coplanarOnly, float maxAngleDegrees, SelectionMode mode); // Grows from the picked triangle
+    size_t getSelectedTriangleCount() const;
+    void setSelectionMaterial(MaterialID material);
+    float lastSelectionTimeMs = 0.0f;
+
+    // Painting, assigns the material to every triangle within radius of a world space point
+    size_t paintMaterial(const glm::vec3& center, float radius, MaterialID material);
+    size_t lastPaintCount = 0;       // Triangles changed by the last dab
+    float lastPaintTimeUs = 0.0f;
+
+    // Grid, drawn procedurally so slider changes only update uniforms
     float size = 150.0f;
     float divisions = 150.0f;
-    float step;
+    float step;                           // Finest line spacing currently shown (adapts to camera height)
+    glm::vec3 gridColor = glm::vec3(0.4f);
+
+    // Follows the window, keeps the viewport, camera and picking target in sync
+    void resize(int windowWidth, int windowHeight, int framebufferWidth, int framebufferHeight);
 
     // Picking
+    void pick(int x, int y, SelectionMode mode = SelectionMode::Replace); // Window coordinates
+    void resolvePendingPicks();            // Finishes GPU picks whose readback has arrived
+    bool raycast(int x, int y, RayHit& hit); // Closest visible triangle under a window point, through the BVH
     int pickedObjectID = -1;
     int pickedTriangleID = -1;
+    bool useGPUPicking = false;            // ID buffer readback instead of the BVH ray cast
+    int pickRegionRadius = 8;              // GPU readback block around the cursor, for hover and lasso use
+    PickingTexture::PickRegion lastPickRegion;
+    RayHit lastPickHit;
+    float lastPickTimeUs = 0.0f;           // Click to result, includes the readback latency on the GPU path
 
     // Display mode
     bool isWireframeMode = false;
+    bool isHeatMapMode = false;
+    HeatMapSource heatMapSource = HeatMapSource::Reflectivity;
+    glm::vec2 heatMapRange = glm::vec2(0.0f, 1.0f); // Values mapped to the ends of the colormap
+    bool heatMapLogScale = false;                   // Map 10*log10(value) instead, for RCS in dBsm
+
+    // GPU time of the grid, axes, scene and picking passes, the ImGui pass is timed by the application
+    GpuPassTimer gpuTimer;
+
+    // Culling
+    bool frustumCullingEnabled = true;
+    bool occlusionCullingEnabled = false;
+    float occluderMinCoverage = 0.05f;        // Screen fraction a mesh must cover to act as occluder
+    size_t occluderTriangleBudget = 65536;    // Meshes above this triangle count are never rasterized
+    int maxOccluders = 8;
+    std::vector<int> visibleMeshIndices;      // Rebuilt every frame, consumed by the draw and picking passes
+    size_t frustumCulledCount = 0;
+    size_t occlusionCulledCount = 0;
 
 private:
     // Coordinate system
     std::unique_ptr<Shader> axisShaderProgram;
     GLuint VAO_axis, VBO_axis;
 
-    // Grid
+    // Grid (empty VAO, the full screen triangle comes from gl_VertexID)
     std::unique_ptr<Shader> gridShaderProgram;
-    GLuint VAO_grid, VBO_grid;
+    GLuint VAO_grid;
 
     // Picking
+    void finishPick(bool found, const RayHit& hit);
+    void applyPick(int objectID, int triangleID);
+    void applySelection(int meshIndex, const std::vector<uint32_t>& triangles, SelectionMode mode);
+    size_t selectInRegion(glm::vec2 regionMin, glm::vec2 regionMax, const std::vector<glm::vec2>* lasso, SelectionMode mode);
+    SelectionMode m_pickMode = SelectionMode::Replace;
+    std::chrono::high_resolution_clock::time_point m_pickStartTime;
     std::unique_ptr<Shader> pickingShaderProgram;
     PickingTexture m_pickingTexture;
+
+    // Culling
+    Frustum m_frustum;
+    OcclusionBuffer m_occlusionBuffer;
+
+    // Scratch of the current frame, reset when updateVisibility starts the next one
+    ScratchArena m_frameArena{ MemoryCategory::Geometry, 4096 };
 };
@@ -0,0 +1,419 @@
+#include "Scattering.h"
+#include "AnalyticScattering.h"
+#include "CompensatedSum.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <cmath>
+
+static constexpr double kPi = 3.14159265358979323846;
+static constexpr double kSpeedOfLight = 299792458.0;
+// Facets per pool job, small enough to balance uneven meshes. Also the unit of the deterministic
+// sum: chunk boundaries only depend on the triangle count, never on the threads.
+static constexpr size_t kTrianglesPerChunk = 4096;
+
+void RadarFrame(const ScatteringSettings& settings, glm::dvec3& toRadar, glm::dvec3& horizontal, glm::dvec3& vertical)
+{
+    double azimuth = glm::radians(static_cast<double>(settings.azimuth));
+    double elevation = glm::radians(static_cast<double>(settings.elevation));
+
+    toRadar = glm::dvec3(std::cos(elevation) * std::sin(azimuth), std::sin(elevation), std::cos(elevation) * std::cos(azimuth));
+
+    // Horizontal stays defined looking straight down, it only depends on the azimuth
+    horizontal = glm::dvec3(std::cos(azimuth), 0.0, -std::sin(azimuth));
+    vertical = glm::cross(toRadar, horizontal);
+}
+
+// First divided difference of exp(jx), stable when a and b coincide
+static std::complex<double> DividedDifference(double a, double b)
+{
+    double half = 0.5 * (b - a);
+    double sinc = std::abs(half) < 1e-8 ? 1.0 : std::sin(half) / half;
+    return std::complex<double>(0.0, sinc) * std::polar(1.0, 0.5 * (a + b));
+}
+
+std::complex<double> FacetIntegral(const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c, const glm::dvec3& w)
+{
+    double doubleArea = glm::length(glm::cross(b - a, c - a));
+
+    // Over the unit simplex the integral is minus the second divided difference of exp(jx)
+    // at the vertex phases, which stays finite when phases coincide
+    double phases[3] = { glm::dot(w, a), glm::dot(w, b), glm::dot(w, c) };
+    std::sort(phases, phases + 3);
+
+    std::complex<double> simplexIntegral;
+    double span = phases[2] - phases[0];
+    if (span < 1e-3) {
+        // Nearly constant phase, Taylor expansion about the mean
+        double mean = (phases[0] + phases[1] + phases[2]) / 3.0;
+        double spread = 0.0;
+        for (double phase : phases) {
+            spread += (phase - mean) * (phase - mean);
+        }
+        simplexIntegral = std::polar(0.5 - spread / 48.0, mean);
+    }
+    else {
+        simplexIntegral = -(DividedDifference(phases[1], phases[2]) - DividedDifference(phases[0], phases[1])) / span;
+    }
+
+    return doubleArea * simplexIntegral;
+}
+
+std::complex<double> EdgeDiffraction(const glm::dvec3& start, const glm::dvec3& end, const glm::dvec3& normal,
+    const glm::dvec3& otherNormal, const glm::dvec3& faceInterior, double wedgeAngle, bool openEdge,
+    const glm::dvec3& toRadar, const glm::dvec3& polarization, double wavenumber)
+{
+    glm::dvec3 tangent = end - start;
+    double length = glm::length(tangent);
+    if (length <= 0.0) return 0.0;
+    tangent /= length;
+
+    // Looking along the edge there is no Keller cone back to the radar
+    double cosBeta = glm::dot(toRadar, tangent);
+    double sinBetaSquared = 1.0 - cosBeta * cosBeta;
+    if (sinBetaSquared < 1e-4) return 0.0;
+
+    // Angle of the radar around the edge, measured from face 0 through the exterior towards its normal
+    glm::dvec3 faceDirection = glm::cross(normal, tangent);
+    if (glm::dot(faceDirection, faceInterior - start) < 0.0) faceDirection = -faceDirection;
+    glm::dvec3 projected = toRadar - cosBeta * tangent;
+    double phi = std::atan2(glm::dot(projected, normal), glm::dot(projected, faceDirection));
+    if (phi < 0.0) phi += 2.0 * kPi;
+
+    double n = (2.0 * kPi - wedgeAngle) / kPi;
+    if (phi > n * kPi) return 0.0;  // Radar inside the material
+
+    // Keep off the exact reflection boundaries, where the Keller and PO terms cancel analytically
+    if (std::abs(phi - 0.5 * kPi) < 1e-4) phi += 2e-4;
+    if (std::abs(phi - (n - 0.5) * kPi) < 1e-4) phi += 2e-4;
+
+    // Keller coefficients in backscatter, soft for E along the edge and hard for E across it
+    double sinN = std::sin(kPi / n) / n;
+    double cosN = std::cos(kPi / n);
+    double x = sinN / (cosN - 1.0);
+    double y = sinN / (cosN - std::cos(2.0 * phi / n));
+    double soft = x - y;
+    double hard = -(x + y);
+
+    // Subtract the edge term physical optics already produced on each lit face. The facet sum only
+    // lights faces from the front, open edges therefore only remove the term of face 0.
+    double physicalOptics = 0.0;
+    if (glm::dot(toRadar, normal) > 0.0) physicalOptics += 0.5 * std::tan(phi);
+    if (!openEdge && glm::dot(toRadar, otherNormal) > 0.0) physicalOptics += 0.5 * std::tan(n * kPi - phi);
+    soft -= physicalOptics;
+    hard -= physicalOptics;
+
+    double softWeight = glm::dot(polarization, tangent);
+    softWeight = softWeight * softWeight / sinBetaSquared;
+    double coefficient = softWeight * soft + (1.0 - softWeight) * hard;
+
+    // Off broadside the phase runs along the edge, which integrates to a sinc
+    double alongEdge = wavenumber * length * cosBeta;
+    double sinc = std::abs(alongEdge) < 1e-6 ? 1.0 : std::sin(alongEdge) / alongEdge;
+
+    glm::dvec3 middle = 0.5 * (start + end);
+    double phase = 2.0 * wavenumber * glm::dot(toRadar, middle);
+    return std::complex<double>(0.0, length / std::sqrt(kPi) * coefficient * sinc) * std::polar(1.0, phase);
+}
+
+void PhysicalOpticsSolver::ClearCache()
+{
+    m_cache.clear();
+    m_cachedMaterialVersion = UINT32_MAX;
+    m_memory.Set(0);
+}
+
+ScatteringResult PhysicalOpticsSolver::Solve(std::vector<Mesh>& meshes, MaterialLibrary& materials, const ScatteringSettings& settings)
+{
+    PROFILE_SCOPE("PO solve");
+    auto start = std::chrono::high_resolution_clock::now();
+    ScatteringResult result;
+    m_scratch.Reset();
+
+    // The inner loop only reads tables
+    materials.BuildTables();
+
+    // Any change of aspect, frequency or material invalidates every cached contribution
+    bool cacheValid = (settings == m_cachedSettings) && (materials.GetVersion() == m_cachedMaterialVersion) &&
+        (shadowing == m_cachedShadowing) && (shadowRasterizer.resolution == m_cachedShadowResolution) &&
+        (m_cache.size() == meshes.size());
+    m_cachedSettings = settings;
+    m_cachedMaterialVersion = materials.GetVersion();
+    m_cachedShadowing = shadowing;
+    m_cachedShadowResolution = shadowRasterizer.resolution;
+
+    auto cacheMatches = [](const MeshCache& cache, const Mesh& mesh) {
+        if (!mesh.isVisible) return !cache.visible;
+        return cache.visible && cache.triangleData == mesh.triangles.data() && cache.triangleCount == mesh.triangles.size() &&
+            cache.modelMatrix == mesh.GetModelMatrix();
+    };
+
+    // With shadowing any moved, added or hidden mesh can change what the others see
+    if (cacheValid && shadowing) {
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            if (!cacheMatches(m_cache[i], meshes[i])) cacheValid = false;
+        }
+    }
+    m_cache.resize(meshes.size());
+
+    glm::dvec3 toRadar, horizontal, vertical;
+    RadarFrame(settings, toRadar, horizontal, vertical);
+
+    // Primitives with a single material have a closed form. The single bounce part doubles as the
+    // reference the facet sum is compared against, when every visible mesh has one.
+    AnalyticField* analyticFields = m_scratch.AllocateArray<AnalyticField>(meshes.size());
+    bool* analytic = m_scratch.AllocateArray<bool>(meshes.size());
+    size_t visibleMeshes = std::count_if(meshes.begin(), meshes.end(), [](const Mesh& mesh) { return mesh.isVisible; });
+    CompensatedComplexSum field;   // Meshes, analytic fields and edges, added in a fixed order
+    std::complex<double> referenceField = 0.0;
+    result.hasReference = visibleMeshes > 0;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        Mesh& mesh = meshes[i];
+        if (!mesh.isVisible) continue;
+
+        MaterialID material;
+        bool evaluated = false;
+        if (mesh.primitive.type != PrimitiveType::None && mesh.GetUniformMaterial(material)) {
+            std::complex<float> te, tm;
+            materials.Reflection(material, 1.0f, settings.frequency, te, tm);
+            evaluated = EvaluatePrimitive(mesh.primitive, mesh.GetModelMatrix(), std::complex<double>(te), settings, analyticFields[i]);
+        }
+        if (!evaluated) {
+            result.hasReference = false;
+            continue;
+        }
+        referenceField += analyticFields[i].singleBounce;
+        // The formula only takes the normal incidence coefficient, which is exact for conductors alone.
+        // Other materials go through the facets and their per angle TE and TM tables.
+        analytic[i] = analyticPrimitives && (!shadowing || visibleMeshes == 1) && materials.Get(material).perfectConductor;
+    }
+    if (result.hasReference) result.referenceRcs = std::norm(referenceField);
+
+    // The shadow raster is needed by meshes integrated facet by facet, and by the edges of every mesh
+    bool needsShadow = false;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        if (meshes[i].isVisible && (!analytic[i] || edgeDiffraction)) needsShadow = true;
+    }
+    if (!shadowing || !needsShadow) {
+        shadowRasterizer.Clear();
+    }
+    else if (!cacheValid || !shadowRasterizer.IsRendered()) {
+        shadowRasterizer.Render(meshes, toRadar, horizontal, vertical);
+    }
+    glm::dvec3 polarization = (settings.polarization == Polarization::HH) ? horizontal : vertical;
+
+    double wavelength = kSpeedOfLight / settings.frequency;
+    double wavenumber = 2.0 * kPi / wavelength;
+    glm::dvec3 phaseVector = 2.0 * wavenumber * toRadar;  // Round trip phase gradient
+    double amplitude = 2.0 * std::sqrt(kPi) / wavelength;
+
+    // Edges are summed as a pool task while the facets are integrated. The edge lists are
+    // built here first, the task only reads meshes and material tables.
+    ThreadPool& pool = this->pool ? *this->pool : ThreadPool::Global();
+    Task<std::complex<double>> edgeSum;
+    if (edgeDiffraction) {
+        // The task reads the list from the arena, which is only reset by the next Solve. Analytic meshes
+        // diffract too, their closed form only replaces the facet sum.
+        const std::vector<FeatureEdge>** edgeLists = m_scratch.AllocateArray<const std::vector<FeatureEdge>*>(meshes.size());
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            if (!meshes[i].isVisible) continue;
+            edgeLists[i] = &meshes[i].GetFeatureEdges(featureEdgeAngle);
+            result.featureEdges += edgeLists[i]->size();
+        }
+
+        const ShadowRasterizer* shadow = shadowing ? &shadowRasterizer : nullptr;
+        edgeSum = pool.Submit([&meshes, &materials, &settings, edgeLists, shadow, toRadar, polarization, wavenumber]() {
+            PROFILE_SCOPE("PO edges");
+            CompensatedComplexSum sum;
+            for (size_t i = 0; i < meshes.size(); ++i) {
+                if (!edgeLists[i]) continue;
+                const Mesh& mesh = meshes[i];
+
+                glm::dmat4 model(mesh.GetModelMatrix());
+                auto worldPosition = [&](uint32_t vertex) {
+                    return glm::dvec3(model * glm::dvec4(glm::dvec3(mesh.vertices[vertex].position), 1.0));
+                };
+                auto worldTriangle = [&](uint32_t triangle, glm::dvec3& normal, glm::dvec3& centroid) {
+                    glm::dvec3 a = worldPosition(mesh.indices[triangle * 3]);
+                    glm::dvec3 b = worldPosition(mesh.indices[triangle * 3 + 1]);
+                    glm::dvec3 c = worldPosition(mesh.indices[triangle * 3 + 2]);
+                    normal = glm::normalize(glm::cross(b - a, c - a));
+                    centroid = (a + b + c) / 3.0;
+                };
+
+                for (const FeatureEdge& edge : *edgeLists[i]) {
+                    glm::dvec3 start = worldPosition(edge.vertices[0]);
+                    glm::dvec3 end = worldPosition(edge.vertices[1]);
+
+                    // A hidden edge does not diffract, its midpoint is tested against the shadow depth buffer
+                    if (shadow && !shadow->IsPointVisible(0.5 * (start + end), 3.0 * shadow->GetPixelSize())) continue;
+
+                    bool openEdge = edge.faces[1] == FeatureEdge::kOpenEdge;
+                    glm::dvec3 normal, centroid, otherNormal(0.0), otherCentroid;
+                    worldTriangle(edge.faces[0], normal, centroid);
+                    if (!openEdge) worldTriangle(edge.faces[1], otherNormal, otherCentroid);
+
+                    // Fringe currents are for conductors, other materials scale them by their normal incidence reflection
+                    std::complex<float> te, tm;
+                    materials.Reflection(mesh.triangles[edge.faces[0]].material, 1.0f, settings.frequency, te, tm);
+                    std::complex<double> reflection(te);
+                    if (!openEdge) {
+                        materials.Reflection(mesh.triangles[edge.faces[1]].material, 1.0f, settings.frequency, te, tm);
+                        reflection = 0.5 * (reflection + std::complex<double>(te));
+                    }
+
+                    sum.Add(-reflection * EdgeDiffraction(start, end, normal, otherNormal, centroid, edge.wedgeAngle, openEdge, toRadar, polarization, wavenumber));
+                }
+            }
+            return sum.Get();
+        }, TaskPriority::Interactive);
+    }
+
+    for (size_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex) {
+        Mesh& mesh = meshes[meshIndex];
+        if (!mesh.isVisible) {
+            m_cache[meshIndex].visible = false;
+            continue;
+        }
+
+        MeshCache& cache = m_cache[meshIndex];
+        size_t triangleCount = mesh.triangles.size();
+
+        if (analytic[meshIndex]) {
+            cache.triangleData = mesh.triangles.data();
+            cache.triangleCount = triangleCount;
+            cache.modelMatrix = mesh.GetModelMatrix();
+            cache.visible = true;
+            cache.analytic = true;
+            cache.contributions.clear();
+            mesh.ClearSolverDirty();
+
+            field.Add(analyticFields[meshIndex].singleBounce);
+            field.Add(analyticFields[meshIndex].multiBounce);
+            result.analyticMeshes++;
+            continue;
+        }
+
+        bool incremental = cacheValid && cacheMatches(cache, mesh) && !cache.analytic;
+        if (!incremental) {
+            cache.triangleData = mesh.triangles.data();
+            cache.triangleCount = triangleCount;
+            cache.modelMatrix = mesh.GetModelMatrix();
+            cache.visible = mesh.isVisible;
+            cache.analytic = false;
+            cache.contributions.assign(triangleCount, 0.0);
+        }
+
+        glm::dmat4 model(mesh.GetModelMatrix());
+
+        // Triangles are independent, chunks of them run on the pool and each writes only its own cache slots.
+        // Every chunk also sums its slice of the cache in triangle order, cached triangles included, so an
+        // incremental solve gives the same total as a full one.
+        std::atomic<size_t> evaluated{ 0 };
+        std::atomic<size_t> lit{ 0 };
+        size_t chunkCount = (triangleCount + kTrianglesPerChunk - 1) / kTrianglesPerChunk;
+        CompensatedComplexSum* chunkSums = m_scratch.AllocateArray<CompensatedComplexSum>(chunkCount);
+        pool.ParallelFor(triangleCount, chunkCount, [&](size_t first, size_t last, size_t chunk) {
+            PROFILE_SCOPE("PO facets");
+            size_t chunkEvaluated = 0;
+            size_t chunkLit = 0;
+            CompensatedComplexSum& chunkSum = chunkSums[chunk];
+            for (size_t t = first; t < last; ++t) {
+                if (incremental && !mesh.IsTriangleSolverDirty(t)) {
+                    const std::complex<double>& cached = cache.contributions[t];
+                    chunkSum.Add(cached);
+                    if (cached != 0.0) chunkLit++;
+                    continue;
+                }
+                chunkEvaluated++;
+
+                const Triangle& triangle = mesh.triangles[t];
+                glm::dvec3 a = glm::dvec3(model * glm::dvec4(glm::dvec3(mesh.vertices[triangle.indices[0]].position), 1.0));
+                glm::dvec3 b = glm::dvec3(model * glm::dvec4(glm::dvec3(mesh.vertices[triangle.indices[1]].position), 1.0));
+                glm::dvec3 c = glm::dvec3(model * glm::dvec4(glm::dvec3(mesh.vertices[triangle.indices[2]].position), 1.0));
+
+                std::complex<double> value = 0.0;
+                glm::dvec3 normal = glm::cross(b - a, c - a);
+                double normalLength = glm::length(normal);
+                double cosIncidence = normalLength > 0.0 ? glm::dot(normal, toRadar) / normalLength : 0.0;
+
+                float litFraction = shadowing ? shadowRasterizer.LitFraction(meshIndex, t) : 1.0f;
+
+                if (cosIncidence > 0.0 && litFraction > 0.0f) {
+                    normal /= normalLength;
+
+                    std::complex<float> reflectionTE, reflectionTM;
+                    materials.Reflection(triangle.material, static_cast<float>(cosIncidence), settings.frequency, reflectionTE, reflectionTM);
+
+                    // Split the polarization into the parts perpendicular and parallel to the plane of incidence
+                    std::complex<double> reflection(reflectionTE);
+                    glm::dvec3 perpendicular = glm::cross(toRadar, normal);
+                    double perpendicularLength = glm::length(perpendicular);
+                    if (perpendicularLength > 1e-9) {
+                        perpendicular /= perpendicularLength;
+                        glm::dvec3 parallel = glm::cross(perpendicular, toRadar);
+                        double te = glm::dot(polarization, perpendicular);
+                        double tm = glm::dot(polarization, parallel);
+                        reflection = std::complex<double>(reflectionTE) * (te * te) + std::complex<double>(reflectionTM) * (tm * tm);
+                    }
+
+                    // A conductor (reflection -1) gives the classic 4 pi A^2 / lambda^2 at normal incidence
+                    // Partly hidden triangles are scaled by their visible area
+                    value = -reflection * amplitude * cosIncidence * static_cast<double>(litFraction) * FacetIntegral(a, b, c, phaseVector);
+                }
+                cache.contributions[t] = value;
+                chunkSum.Add(value);
+                if (value != 0.0) chunkLit++;
+            }
+            evaluated += chunkEvaluated;
+            lit += chunkLit;
+        });
+        field.Add(PairwiseSum(chunkSums, chunkCount));
+        result.litTriangles += lit;
+        result.evaluatedTriangles += evaluated;
+        result.cachedTriangles += triangleCount - evaluated;
+
+        // Writing into the mesh is not thread safe and happens here. A full solve hands over one slice.
+        if (writeContributions) {
+            if (!incremental) {
+                ScratchArena::Marker marker = m_scratch.GetMarker();
+                float* contributions = m_scratch.AllocateArray<float>(triangleCount);
+                for (size_t t = 0; t < triangleCount; ++t) {
+                    contributions[t] = static_cast<float>(std::norm(cache.contributions[t]));
+                }
+                mesh.SetTriangleContributions(0, contributions, triangleCount);
+                m_scratch.Rewind(marker);
+            }
+            else {
+                for (size_t t = 0; t < triangleCount; ++t) {
+                    if (!mesh.IsTriangleSolverDirty(t)) continue;
+                    float contribution = static_cast<float>(std::norm(cache.contributions[t]));
+                    mesh.SetTriangleContributions(t, &contribution, 1);
+                }
+            }
+        }
+        mesh.ClearSolverDirty();
+    }
+
+    if (edgeSum.IsValid()) {
+        result.edgeField = edgeSum.Get();
+        field.Add(result.edgeField);
+    }
+    result.field = field.Get();
+
+    result.rcs = std::norm(result.field);
+    result.rcsDBsm = result.rcs > 0.0 ? 10.0 * std::log10(result.rcs) : -300.0;
+    result.timeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    uint64_t cacheBytes = m_cache.capacity() * sizeof(MeshCache);
+    for (const MeshCache& cache : m_cache) cacheBytes += cache.contributions.capacity() * sizeof(std::complex<double>);
+    m_memory.Set(cacheBytes);
+
+    Profiler::Count("Triangles evaluated", result.evaluatedTriangles);
+    Profiler::Count("Cache hits", result.cachedTriangles);
+    return result;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Material.h"
+#include "ScratchArena.h"
+#include "ShadowRasterizer.h"
+
+class Mesh;
+class ThreadPool;
+
+// Transmit and receive polarization of a monostatic radar
+enum class Polarization {
+    HH, VV
+};
+
+// Radar looking at the scene from far away
+struct ScatteringSettings {
+    float frequency = 10.0e9f;   // Hz
+    float azimuth = 0.0f;        // Degrees around the vertical (Y) axis, 0 looks from +Z
+    float elevation = 0.0f;      // Degrees above the horizontal plane
+    Polarization polarization = Polarization::VV;
+
+    bool operator==(const ScatteringSettings&) const = default;
+};
+
+struct ScatteringResult {
+    std::complex<double> field = 0.0;  // Coherent sum of the sqrt(RCS) contributions, in metres
+    std::complex<double> edgeField = 0.0;  // Part of field diffracted by feature edges
+    double rcs = 0.0;                  // Square metres
+    double rcsDBsm = -300.0;
+    size_t litTriangles = 0;
+    size_t evaluatedTriangles = 0;     // Triangles integrated by this solve, the others came from the cache
+    size_t cachedTriangles = 0;        // Triangles whose cached contribution was reused
+    size_t featureEdges = 0;
+    size_t analyticMeshes = 0;         // Meshes evaluated from their primitive formula instead of facets
+    bool hasReference = false;         // Every visible mesh is a primitive, referenceRcs is meaningful
+    double referenceRcs = 0.0;         // Single bounce analytic RCS, what the facet sum converges to
+    float timeMs = 0.0f;
+};
+
+// Unit vector from the scene towards the radar and the polarization vectors perpendicular to it
+void RadarFrame(const ScatteringSettings& settings, glm::dvec3& toRadar, glm::dvec3& horizontal, glm::dvec3& vertical);
+
+// Integral of exp(j w.r) over the triangle abc, in closed form
+std::complex<double> FacetIntegral(const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c, const glm::dvec3& w);
+
+// Monostatic diffraction of one feature edge, zero when the radar looks into the wedge.
+// Endpoints, face normals and a point inside faces[0] are in world space.
+std::complex<double> EdgeDiffraction(const glm::dvec3& start, const glm::dvec3& end, const glm::dvec3& normal,
+    const glm::dvec3& otherNormal, const glm::dvec3& faceInterior, double wedgeAngle, bool openEdge,
+    const glm::dvec3& toRadar, const glm::dvec3& polarization, double wavenumber);
+
+// Monostatic RCS by physical optics over the triangles of every visible mesh. Single bounce,
+// triangles facing away from the radar are dark and the rest are weighted by how much of them the
+// ShadowRasterizer sees. Reflection comes from the material tables.
+// Feature edges add their diffraction as PTD fringe currents, summed as a task on the ThreadPool
+// while the facets are integrated in parallel chunks.
+//
+// Results are reproducible to the last bit whatever the thread count: facets are summed with
+// compensation in chunks of fixed size, and the chunk sums are merged pairwise in a fixed tree.
+//
+// Per triangle contributions are cached between solves. With unchanged settings and transforms only
+// the triangles a mesh marked solver dirty (painting, material edits) are integrated again.
+class PhysicalOpticsSolver {
+public:
+    ScatteringResult Solve(std::vector<Mesh>& meshes, MaterialLibrary& materials, const ScatteringSettings& settings);
+    void ClearCache();
+
+    // Writes |contribution|^2 of every recomputed triangle into Mesh::rcsContribution for the heat map
+    bool writeContributions = true;
+
+    bool edgeDiffraction = true;
+    float featureEdgeAngle = 20.0f;    // Degrees between face normals for an edge to diffract
+
+    bool shadowing = true;
+
+    // Procedural primitives made of one perfect conductor are evaluated from their closed form instead
+    // of their facets, their feature edges still diffract. Needs shadowing off or the primitive alone,
+    // other meshes would hide parts of it.
+    bool analyticPrimitives = true;
+    ShadowRasterizer shadowRasterizer;  // Rendered again only when the aspect or the geometry changes
+
+    ThreadPool* pool = nullptr;         // Pool the facets and edges run on, nullptr for ThreadPool::Global()
+
+private:
+    struct MeshCache {
+        const void* triangleData = nullptr;  // Identifies the mesh, the triangle storage moves with it
+        size_t triangleCount = 0;
+        glm::mat4 modelMatrix = glm::mat4(1.0f);
+        bool visible = false;
+        bool analytic = false;  // Evaluated by formula, contributions is empty
+        std::vector<std::complex<double>> contributions;
+    };
+
+    std::vector<MeshCache> m_cache;
+    ScatteringSettings m_cachedSettings;
+    uint32_t m_cachedMaterialVersion = UINT32_MAX;
+    bool m_cachedShadowing = false;
+    int m_cachedShadowResolution = 0;
+    MemoryAccount m_memory{ MemoryCategory::Solver };  // The contribution cache, the rasterizer has its own
+    ScratchArena m_scratch{ MemoryCategory::Solver };  // Per solve arrays, reset at the start of every Solve
+};
@@ -0,0 +1,78 @@
+#include "ScratchArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+ScratchArena::ScratchArena(MemoryCategory category, size_t blockBytes) :
+    m_blockBytes(std::max<size_t>(blockBytes, 64)),
+    m_memory(category)
+{
+}
+
+void* ScratchArena::Allocate(size_t bytes, size_t alignment)
+{
+    if (m_blocks.empty()) {
+        // First use, or the arena was moved from
+        m_block = m_offset = m_capacity = 0;
+        AddBlock(std::max(m_blockBytes, bytes + alignment));
+    }
+
+    // Aligned on the address, new char[] only guarantees the default new alignment
+    auto alignedOffset = [&]() {
+        uintptr_t base = reinterpret_cast<uintptr_t>(m_blocks[m_block].data.get());
+        uintptr_t aligned = (base + m_offset + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        return static_cast<size_t>(aligned - base);
+    };
+
+    size_t offset = alignedOffset();
+    if (offset + bytes > m_blocks[m_block].size) {
+        NextBlock(bytes, alignment);
+        offset = alignedOffset();
+    }
+    m_offset = offset + bytes;
+    return m_blocks[m_block].data.get() + offset;
+}
+
+void ScratchArena::NextBlock(size_t bytes, size_t alignment)
+{
+    // Blocks after the current one hold nothing, markers only ever point backwards
+    size_t next = m_block + 1;
+    if (next < m_blocks.size() && m_blocks[next].size < bytes + alignment) {
+        for (size_t i = next; i < m_blocks.size(); ++i) m_capacity -= m_blocks[i].size;
+        m_blocks.erase(m_blocks.begin() + next, m_blocks.end());
+    }
+    if (next == m_blocks.size()) {
+        // Doubling keeps the number of blocks logarithmic in the size of the round
+        AddBlock(std::max(m_blocks.back().size * 2, bytes + alignment));
+    }
+    m_block = next;
+    m_offset = 0;
+}
+
+void ScratchArena::AddBlock(size_t size)
+{
+    Block block;
+    block.data.reset(new char[size]);
+    block.size = size;
+    m_blocks.push_back(std::move(block));
+    m_capacity += size;
+    m_memory.Set(m_capacity);
+}
+
+void ScratchArena::Rewind(const Marker& marker)
+{
+    m_block = marker.block;
+    m_offset = marker.offset;
+}
+
+void ScratchArena::Reset()
+{
+    if (m_blocks.size() > 1) {
+        size_t total = m_capacity;
+        m_blocks.clear();
+        m_capacity = 0;
+        AddBlock(total);
+    }
+    m_block = 0;
+    m_offset = 0;
+}
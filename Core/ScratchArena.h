@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+// Linear allocator for scratch data that dies all at once, e.g. everything one solve or one frame
+// needs. Allocating bumps an offset, Reset() and Rewind() release everything after a point in O(1).
+// Blocks are kept for the next round, so once an arena has seen its largest round it no longer
+// touches the heap. Not thread safe: every thread or parallel chunk gets its own arena.
+class ScratchArena {
+public:
+    static constexpr size_t kDefaultBlockBytes = size_t(64) << 10;
+
+    // Position to Rewind() to
+    struct Marker {
+        size_t block = 0;
+        size_t offset = 0;
+    };
+
+    explicit ScratchArena(MemoryCategory category, size_t blockBytes = kDefaultBlockBytes);
+    ScratchArena(ScratchArena&&) noexcept = default;
+    ScratchArena& operator=(ScratchArena&&) noexcept = default;
+
+    void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    // count value initialized objects, zeroed for arithmetic types. They are never destroyed.
+    template<typename T>
+    T* AllocateArray(size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "arena memory is released without running destructors");
+        T* objects = static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+        for (size_t i = 0; i < count; ++i) new (objects + i) T();
+        return objects;
+    }
+
+    Marker GetMarker() const { return { m_block, m_offset }; }
+    // Releases everything allocated after the marker was taken
+    void Rewind(const Marker& marker);
+    // Releases everything. A round that needed several blocks leaves one block of their total size,
+    // so the next round of the same size fits without growing.
+    void Reset();
+
+    size_t GetCapacity() const { return m_capacity; }
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+    };
+
+    // Moves on to a block with room for bytes, reusing the next one if it is large enough
+    void NextBlock(size_t bytes, size_t alignment);
+    void AddBlock(size_t size);
+
+    std::vector<Block> m_blocks;
+    size_t m_block = 0;     // Block allocations currently come from
+    size_t m_offset = 0;    // Bytes used in it
+    size_t m_blockBytes;
+    size_t m_capacity = 0;
+    MemoryAccount m_memory;
+};
+
+// Standard allocator on top of an arena, for containers whose storage dies with it. deallocate()
+// does nothing, the memory comes back when the arena is reset or destroyed.
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(ScratchArena& arena) : m_arena(&arena) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.GetArena()) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(m_arena->Allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    ScratchArena* GetArena() const { return m_arena; }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.GetArena(); }
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return m_arena != other.GetArena(); }
+
+private:
+    ScratchArena* m_arena;
+};
@@ -0,0 +1,339 @@
+#include "ShadowRasterizer.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Twice the signed area of (a, b, p), positive when p is left of a->b. Swapping a and b
+// negates the result exactly, so neighbours sharing an edge agree on which side a pixel is.
+static inline float EdgeFunction(float ax, float ay, float bx, float by, float px, float py)
+{
+    return (ax - px) * (by - py) - (ay - py) * (bx - px);
+}
+
+// Counter clockwise top-left fill rule with y up, pixels exactly on an edge go to one triangle
+static inline bool IsTopLeft(float ax, float ay, float bx, float by)
+{
+    return (ay == by && bx < ax) || by < ay;
+}
+
+// Calls visit(x, y, depth) for every pixel of [x0, x1] x [y0, y1] whose centre the triangle
+// covers. Rasterization and the lit fractions share it, so both count exactly the same pixels.
+template<typename Vertex, typename Visit>
+static void ForEachCoveredPixel(Vertex a, Vertex b, Vertex c, int x0, int y0, int x1, int y1, Visit visit)
+{
+    // Only pixels whose centres fall inside the bounds, most sub-pixel triangles cover none
+    x0 = std::max(x0, static_cast<int>(std::ceil(std::min({ a.x, b.x, c.x }) - 0.5f)));
+    y0 = std::max(y0, static_cast<int>(std::ceil(std::min({ a.y, b.y, c.y }) - 0.5f)));
+    x1 = std::min(x1, static_cast<int>(std::floor(std::max({ a.x, b.x, c.x }) - 0.5f)));
+    y1 = std::min(y1, static_cast<int>(std::floor(std::max({ a.y, b.y, c.y }) - 0.5f)));
+    if (x0 > x1 || y0 > y1) return;
+
+    // Both sides are drawn, open surfaces cast shadows too. Wind them counter clockwise.
+    float area = EdgeFunction(a.x, a.y, b.x, b.y, c.x, c.y);
+    if (area == 0.0f) return;
+    if (area < 0.0f) {
+        std::swap(b, c);
+        area = -area;
+    }
+
+    bool topLeftA = IsTopLeft(b.x, b.y, c.x, c.y);
+    bool topLeftB = IsTopLeft(c.x, c.y, a.x, a.y);
+    bool topLeftC = IsTopLeft(a.x, a.y, b.x, b.y);
+    float inverseArea = 1.0f / area;
+
+    for (int y = y0; y <= y1; ++y) {
+        float py = y + 0.5f;
+        for (int x = x0; x <= x1; ++x) {
+            float px = x + 0.5f;
+
+            // Weights opposite each vertex, sampled at the pixel centre
+            float wa = EdgeFunction(b.x, b.y, c.x, c.y, px, py);
+            float wb = EdgeFunction(c.x, c.y, a.x, a.y, px, py);
+            float wc = EdgeFunction(a.x, a.y, b.x, b.y, px, py);
+            if (wa < 0.0f || (wa == 0.0f && !topLeftA)) continue;
+            if (wb < 0.0f || (wb == 0.0f && !topLeftB)) continue;
+            if (wc < 0.0f || (wc == 0.0f && !topLeftC)) continue;
+
+            visit(x, y, (wa * a.depth + wb * b.depth + wc * c.depth) * inverseArea);
+        }
+    }
+}
+
+void ShadowRasterizer::Clear()
+{
+    m_idBuffer.clear();
+    m_depthBuffer.clear();
+    m_litFractions.clear();
+    m_pixelCounts.clear();
+    m_projected.clear();
+    m_bins.clear();
+    m_triangleOffsets.clear();
+    m_width = m_height = 0;
+    UpdateMemoryUsage();
+}
+
+void ShadowRasterizer::UpdateMemoryUsage()
+{
+    uint64_t bytes = m_triangleOffsets.capacity() * sizeof(size_t) +
+        m_depthBuffer.capacity() * sizeof(float) + m_idBuffer.capacity() * sizeof(uint32_t) +
+        m_pixelCounts.capacity() * sizeof(uint32_t) + m_litFractions.capacity() * sizeof(float);
+    m_memory.Set(bytes);
+}
+
+void ShadowRasterizer::Render(const std::vector<Mesh>& meshes, const glm::dvec3& toRadar,
+    const glm::dvec3& horizontal, const glm::dvec3& vertical)
+{
+    PROFILE_SCOPE("Shadow raster");
+    auto start = std::chrono::high_resolution_clock::now();
+    Clear();
+
+    m_toRadar = toRadar;
+    m_horizontal = horizontal;
+    m_vertical = vertical;
+
+    // Chunks run on the shared pool, the calling thread takes its share
+    ThreadPool& pool = this->pool ? *this->pool : ThreadPool::Global();
+    size_t threads = threadCount > 0 ? static_cast<size_t>(threadCount) : pool.GetThreadCount() + 1;
+
+    // Global triangle numbering across meshes, hidden meshes keep their range but draw nothing
+    m_triangleOffsets.assign(meshes.size() + 1, 0);
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        m_triangleOffsets[i + 1] = m_triangleOffsets[i] + (meshes[i].isVisible ? meshes[i].triangles.size() : 0);
+    }
+    size_t triangleCount = m_triangleOffsets.back();
+    m_litFractions.assign(triangleCount, 1.0f);
+    if (triangleCount == 0) return;
+    Profiler::Count("Triangles rasterized", triangleCount);
+
+    // Footprint of the scene on the image plane from the corners of the world bounds
+    glm::dvec2 footprintMin(DBL_MAX), footprintMax(-DBL_MAX);
+    m_minDepth = DBL_MAX;
+    for (const auto& mesh : meshes) {
+        if (!mesh.isVisible || !mesh.worldBounds.IsValid()) continue;
+        for (int corner = 0; corner < 8; ++corner) {
+            glm::dvec3 point((corner & 1) ? mesh.worldBounds.max.x : mesh.worldBounds.min.x,
+                             (corner & 2) ? mesh.worldBounds.max.y : mesh.worldBounds.min.y,
+                             (corner & 4) ? mesh.worldBounds.max.z : mesh.worldBounds.min.z);
+            glm::dvec2 planar(glm::dot(point, horizontal), glm::dot(point, vertical));
+            footprintMin = glm::min(footprintMin, planar);
+            footprintMax = glm::max(footprintMax, planar);
+            m_minDepth = std::min(m_minDepth, glm::dot(point, toRadar));
+        }
+    }
+    if (m_minDepth == DBL_MAX) return;
+
+    // Square pixels, one pixel of margin so nothing lands on the border
+    glm::dvec2 extent = footprintMax - footprintMin;
+    m_pixelSize = std::max(std::max(extent.x, extent.y), 1e-6) / std::max(resolution, 1);
+    m_origin = footprintMin - m_pixelSize;
+    m_width = static_cast<int>(std::ceil(extent.x / m_pixelSize)) + 2;
+    m_height = static_cast<int>(std::ceil(extent.y / m_pixelSize)) + 2;
+    m_tilesX = (m_width + kTileSize - 1) / kTileSize;
+    m_tilesY = (m_height + kTileSize - 1) / kTileSize;
+
+    // Project the vertices of every mesh
+    m_projectionArena.Reset();
+    m_projected.assign(meshes.size(), nullptr);
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        const Mesh& mesh = meshes[i];
+        if (!mesh.isVisible) continue;
+
+        glm::dmat4 model(mesh.GetModelMatrix());
+        ScreenVertex* projected = m_projectionArena.AllocateArray<ScreenVertex>(mesh.vertices.size());
+        m_projected[i] = projected;
+        pool.ParallelFor(mesh.vertices.size(), threads, [&](size_t first, size_t last, size_t) {
+            for (size_t v = first; v < last; ++v) {
+                glm::dvec3 world = glm::dvec3(model * glm::dvec4(glm::dvec3(mesh.vertices[v].position), 1.0));
+                projected[v].x = static_cast<float>((glm::dot(world, horizontal) - m_origin.x) / m_pixelSize);
+                projected[v].y = static_cast<float>((glm::dot(world, vertical) - m_origin.y) / m_pixelSize);
+                projected[v].depth = static_cast<float>(glm::dot(world, toRadar) - m_minDepth);
+            }
+        });
+    }
+
+    // Bin triangles into the tiles their bounds touch. Each chunk owns a contiguous range of
+    // triangles and its own bins, so every bin list stays in triangle order. Bins are counted
+    // first and filled second, which sizes them exactly inside the chunk's arena.
+    size_t tileCount = static_cast<size_t>(m_tilesX) * m_tilesY;
+    while (m_binArenas.size() < threads) m_binArenas.emplace_back(MemoryCategory::Solver);
+    m_bins.assign(threads, ChunkBins());
+    pool.ParallelFor(triangleCount, threads, [&](size_t first, size_t last, size_t chunk) {
+        PROFILE_SCOPE("Raster binning");
+        ScratchArena& arena = m_binArenas[chunk];
+        arena.Reset();
+
+        // Calls function(tile) for every tile the bounds of each triangle in the chunk touch
+        auto forEachTile = [&](auto function) {
+            size_t meshIndex = first < last ? MeshOfTriangle(first) : 0;
+            for (size_t global = first; global < last; ++global) {
+                while (global >= m_triangleOffsets[meshIndex + 1]) ++meshIndex;
+                const Mesh& mesh = meshes[meshIndex];
+                size_t t = global - m_triangleOffsets[meshIndex];
+
+                const ScreenVertex& a = m_projected[meshIndex][mesh.indices[t * 3]];
+                const ScreenVertex& b = m_projected[meshIndex][mesh.indices[t * 3 + 1]];
+                const ScreenVertex& c = m_projected[meshIndex][mesh.indices[t * 3 + 2]];
+
+                int x0 = std::max(0, static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))) / kTileSize);
+                int y0 = std::max(0, static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))) / kTileSize);
+                int x1 = std::min(m_tilesX - 1, static_cast<int>(std::max({ a.x, b.x, c.x })) / kTileSize);
+                int y1 = std::min(m_tilesY - 1, static_cast<int>(std::max({ a.y, b.y, c.y })) / kTileSize);
+                for (int ty = y0; ty <= y1; ++ty) {
+                    for (int tx = x0; tx <= x1; ++tx) {
+                        function(ty * m_tilesX + tx, static_cast<uint32_t>(global));
+                    }
+                }
+            }
+        };
+
+        uint32_t* offsets = arena.AllocateArray<uint32_t>(tileCount + 1);
+        forEachTile([&](size_t tile, uint32_t) { offsets[tile + 1]++; });
+        for (size_t tile = 0; tile < tileCount; ++tile) offsets[tile + 1] += offsets[tile];
+
+        uint32_t* triangles = arena.AllocateArray<uint32_t>(offsets[tileCount]);
+        uint32_t* cursor = arena.AllocateArray<uint32_t>(tileCount);
+        std::copy(offsets, offsets + tileCount, cursor);
+        forEachTile([&](size_t tile, uint32_t global) { triangles[cursor[tile]++] = global; });
+
+        m_bins[chunk].offsets = offsets;
+        m_bins[chunk].triangles = triangles;
+    });
+
+    // Tiles never overlap, so threads write the shared buffers without locking
+    m_depthBuffer.assign(static_cast<size_t>(m_width) * m_height, -FLT_MAX);
+    m_idBuffer.assign(static_cast<size_t>(m_width) * m_height, kEmptyPixel);
+    pool.ParallelFor(tileCount, tileCount, [&](size_t tile, size_t, size_t) {
+        PROFILE_SCOPE("Raster tile");
+        RasterizeTile(static_cast<int>(tile), meshes);
+    });
+
+    m_pixelCounts.assign(triangleCount, 0);
+    for (uint32_t id : m_idBuffer) {
+        if (id != kEmptyPixel) m_pixelCounts[id - 1]++;
+    }
+
+    pool.ParallelFor(triangleCount, threads, [&](size_t first, size_t last, size_t) {
+        PROFILE_SCOPE("Lit fractions");
+        ComputeLitFractions(meshes, first, last);
+    });
+
+    // The bins and projections are only needed while rendering, their arenas keep the memory for the next aspect
+    m_bins.clear();
+    m_projected.clear();
+    UpdateMemoryUsage();
+
+    lastRenderTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+size_t ShadowRasterizer::MeshOfTriangle(size_t globalTriangle) const
+{
+    auto it = std::upper_bound(m_triangleOffsets.begin(), m_triangleOffsets.end(), globalTriangle);
+    return static_cast<size_t>(it - m_triangleOffsets.begin()) - 1;
+}
+
+void ShadowRasterizer::RasterizeTile(int tile, const std::vector<Mesh>& meshes)
+{
+    int tileX0 = (tile % m_tilesX) * kTileSize;
+    int tileY0 = (tile / m_tilesX) * kTileSize;
+    int tileX1 = std::min(tileX0 + kTileSize, m_width) - 1;
+    int tileY1 = std::min(tileY0 + kTileSize, m_height) - 1;
+
+    for (const ChunkBins& bins : m_bins) {
+        const uint32_t* bin = bins.triangles + bins.offsets[tile];
+        const uint32_t* binEnd = bins.triangles + bins.offsets[tile + 1];
+        size_t meshIndex = bin == binEnd ? 0 : MeshOfTriangle(*bin);
+
+        for (; bin != binEnd; ++bin) {
+            uint32_t global = *bin;
+            while (global >= m_triangleOffsets[meshIndex + 1]) ++meshIndex;
+            const Mesh& mesh = meshes[meshIndex];
+            size_t t = global - m_triangleOffsets[meshIndex];
+
+            ScreenVertex a = m_projected[meshIndex][mesh.indices[t * 3]];
+            ScreenVertex b = m_projected[meshIndex][mesh.indices[t * 3 + 1]];
+            ScreenVertex c = m_projected[meshIndex][mesh.indices[t * 3 + 2]];
+
+            // Closest to the radar wins, equal depths go to the lower ID so the image
+            // does not depend on the order threads finish in
+            uint32_t id = global + 1;
+            ForEachCoveredPixel(a, b, c, tileX0, tileY0, tileX1, tileY1, [&](int x, int y, float depth) {
+                size_t pixel = static_cast<size_t>(y) * m_width + x;
+                if (depth > m_depthBuffer[pixel] || (depth == m_depthBuffer[pixel] && id < m_idBuffer[pixel])) {
+                    m_depthBuffer[pixel] = depth;
+                    m_idBuffer[pixel] = id;
+                }
+            });
+        }
+    }
+}
+
+void ShadowRasterizer::ComputeLitFractions(const std::vector<Mesh>& meshes, size_t firstTriangle, size_t lastTriangle)
+{
+    // Below this many pixels the pixel count is too noisy, the centroid is depth tested instead
+    const float minimumPixels = 4.0f;
+
+    size_t meshIndex = firstTriangle < lastTriangle ? MeshOfTriangle(firstTriangle) : 0;
+    for (size_t global = firstTriangle; global < lastTriangle; ++global) {
+        while (global >= m_triangleOffsets[meshIndex + 1]) ++meshIndex;
+        const Mesh& mesh = meshes[meshIndex];
+        size_t t = global - m_triangleOffsets[meshIndex];
+
+        const ScreenVertex& a = m_projected[meshIndex][mesh.indices[t * 3]];
+        const ScreenVertex& b = m_projected[meshIndex][mesh.indices[t * 3 + 1]];
+        const ScreenVertex& c = m_projected[meshIndex][mesh.indices[t * 3 + 2]];
+
+        float projectedPixels = 0.5f * std::abs(EdgeFunction(a.x, a.y, b.x, b.y, c.x, c.y));
+        if (projectedPixels >= minimumPixels) {
+            // A small triangle covers a few pixel centres more or less than its area. Dividing by
+            // the area and clamping would keep the shortfalls and drop the excess, darkening finely
+            // tessellated surfaces, so the pixels won are compared with the centres covered.
+            uint32_t covered = 0;
+            ForEachCoveredPixel(a, b, c, 0, 0, m_width - 1, m_height - 1, [&](int, int, float) { ++covered; });
+            if (covered > 0) m_litFractions[global] = static_cast<float>(m_pixelCounts[global]) / covered;
+            continue;
+        }
+
+        int x = static_cast<int>((a.x + b.x + c.x) / 3.0f);
+        int y = static_cast<int>((a.y + b.y + c.y) / 3.0f);
+        if (x < 0 || y < 0 || x >= m_width || y >= m_height) continue;
+
+        size_t pixel = static_cast<size_t>(y) * m_width + x;
+        if (m_idBuffer[pixel] == global + 1) continue;
+
+        // Tilted triangles change depth quickly across a pixel, widen the bias with their slope
+        glm::vec3 edge1((b.x - a.x) * m_pixelSize, (b.y - a.y) * m_pixelSize, b.depth - a.depth);
+        glm::vec3 edge2((c.x - a.x) * m_pixelSize, (c.y - a.y) * m_pixelSize, c.depth - a.depth);
+        glm::vec3 normal = glm::cross(edge1, edge2);
+        float normalLength = glm::length(normal);
+        float cosine = normalLength > 0.0f ? std::abs(normal.z) / normalLength : 1.0f;
+        float slope = std::sqrt(std::max(0.0f, 1.0f - cosine * cosine)) / std::max(cosine, 1e-3f);
+        float bias = static_cast<float>(m_pixelSize) * (1.0f + slope);
+
+        float centroidDepth = (a.depth + b.depth + c.depth) / 3.0f;
+        m_litFractions[global] = (centroidDepth + bias >= m_depthBuffer[pixel]) ? 1.0f : 0.0f;
+    }
+}
+
+float ShadowRasterizer::LitFraction(size_t meshIndex, size_t triangleIndex) const
+{
+    if (meshIndex + 1 >= m_triangleOffsets.size()) return 1.0f;
+    size_t global = m_triangleOffsets[meshIndex] + triangleIndex;
+    if (global >= m_triangleOffsets[meshIndex + 1]) return 1.0f;
+    return m_litFractions[global];
+}
+
+bool ShadowRasterizer::IsPointVisible(const glm::dvec3& point, double depthBias) const
+{
+    if (m_idBuffer.empty()) return true;
+
+    int x = static_cast<int>((glm::dot(point, m_horizontal) - m_origin.x) / m_pixelSize);
+    int y = static_cast<int>((glm::dot(point, m_vertical) - m_origin.y) / m_pixelSize);
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) return true;
+
+    double depth = glm::dot(point, m_toRadar) - m_minDepth;
+    return depth + depthBias >= m_depthBuffer[static_cast<size_t>(y) * m_width + x];
+}
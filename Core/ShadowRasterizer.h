@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "ScratchArena.h"
+
+class Mesh;
+class ThreadPool;
+
+// Renders triangle IDs from the radar's point of view on the CPU, the way PickingTexture
+// stores gl_PrimitiveID on the GPU. The incident wave is planar, so the view is orthographic
+// along the radar direction. Tiles are rasterized in parallel into a shared depth buffer.
+//
+// The result is the fraction of every triangle the radar actually sees, used to shadow
+// the physical optics integration.
+class ShadowRasterizer {
+public:
+    // Renders every visible mesh. horizontal and vertical span the image plane.
+    void Render(const std::vector<Mesh>& meshes, const glm::dvec3& toRadar,
+        const glm::dvec3& horizontal, const glm::dvec3& vertical);
+    bool IsRendered() const { return !m_idBuffer.empty(); }
+    void Clear();
+
+    // Fraction of the triangle's projected area that is not hidden, 1 before anything was rendered
+    float LitFraction(size_t meshIndex, size_t triangleIndex) const;
+
+    // Whether a world space point is in front of everything rendered at its pixel,
+    // depthBias is in world units along the radar direction
+    bool IsPointVisible(const glm::dvec3& point, double depthBias) const;
+
+    double GetPixelSize() const { return m_pixelSize; }  // World units
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+
+    int resolution = 1024;       // Pixels across the longer side of the scene's footprint
+    int threadCount = 0;         // Chunks per parallel pass, 0 uses every pool thread plus the caller
+    ThreadPool* pool = nullptr;  // nullptr renders on ThreadPool::Global()
+    float lastRenderTimeMs = 0.0f;
+
+    static constexpr int kTileSize = 64;
+    static constexpr uint32_t kEmptyPixel = 0;  // IDs are global triangle index + 1
+
+private:
+    // Projected vertex: pixel coordinates and depth towards the radar (larger is closer)
+    struct ScreenVertex {
+        float x, y, depth;
+    };
+
+    void RasterizeTile(int tile, const std::vector<Mesh>& meshes);
+    void ComputeLitFractions(const std::vector<Mesh>& meshes, size_t firstTriangle, size_t lastTriangle);
+    size_t MeshOfTriangle(size_t globalTriangle) const;
+    // Reports the capacity of the buffers below to the Solver category, the arenas account themselves
+    void UpdateMemoryUsage();
+
+    glm::dvec3 m_toRadar, m_horizontal, m_vertical;
+    glm::dvec2 m_origin = glm::dvec2(0.0);   // Image plane coordinates of pixel (0, 0)
+    double m_minDepth = 0.0;                 // Depths are stored relative to this for float precision
+    double m_pixelSize = 1.0;
+    int m_width = 0, m_height = 0;
+    int m_tilesX = 0, m_tilesY = 0;
+
+    std::vector<size_t> m_triangleOffsets;                 // First global triangle of each mesh, plus the total
+    // Triangles of one binning chunk sorted by tile: tile i owns triangles[offsets[i] .. offsets[i + 1])
+    struct ChunkBins {
+        const uint32_t* offsets = nullptr;
+        const uint32_t* triangles = nullptr;
+    };
+
+    // Projections and bins only live for one Render and come from arenas that are reset at its start.
+    // Every binning chunk has its own arena, so the worker threads never share the heap.
+    ScratchArena m_projectionArena{ MemoryCategory::Solver };
+    std::vector<ScratchArena> m_binArenas;
+    std::vector<ScreenVertex*> m_projected;     // Per mesh vertices
+    std::vector<ChunkBins> m_bins;              // Per chunk, global triangles in index order
+
+    std::vector<float> m_depthBuffer;
+    std::vector<uint32_t> m_idBuffer;
+    std::vector<uint32_t> m_pixelCounts;   // Pixels won by each triangle
+    std::vector<float> m_litFractions;
+
+    MemoryAccount m_memory{ MemoryCategory::Solver };
+};
@@ -0,0 +1,457 @@
+#include "SystemMetrics.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <unordered_map>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+#elif defined(__linux__)
+#include <dirent.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#endif
+
+// CPU time of one thread, in the platform's CPU time unit
+struct ThreadTimes {
+    uint64_t id = 0;
+    std::string name;
+    uint64_t time = 0;
+};
+
+//----------------------------------------
+// Platform readers. CPU times are in platform units, see CpuTimeUnitSeconds.
+//----------------------------------------
+
+#ifdef _WIN32
+
+static uint64_t FileTimeToUint64(const FILETIME& time)
+{
+    return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+}
+
+static double CpuTimeUnitSeconds()
+{
+    return 1.0e-7;  // FILETIME counts 100 ns
+}
+
+static bool ReadSystemCpu(uint64_t& busy, uint64_t& total)
+{
+    FILETIME idleTime, kernelTime, userTime;
+    if (!GetSystemTimes(&idleTime, &kernelTime, &userTime)) return false;
+
+    // Kernel time includes the idle time
+    total = FileTimeToUint64(kernelTime) + FileTimeToUint64(userTime);
+    busy = total - FileTimeToUint64(idleTime);
+    return true;
+}
+
+static bool ReadProcessCpu(uint64_t& time)
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return false;
+    time = FileTimeToUint64(kernel) + FileTimeToUint64(user);
+    return true;
+}
+
+static void ReadMemory(SystemMetricsSnapshot& snapshot)
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        snapshot.processRssBytes = counters.WorkingSetSize;
+        snapshot.processPeakRssBytes = counters.PeakWorkingSetSize;
+    }
+
+    MEMORYSTATUSEX memoryStatus;
+    memoryStatus.dwLength = sizeof(MEMORYSTATUSEX);
+    if (GlobalMemoryStatusEx(&memoryStatus)) {
+        snapshot.systemMemoryTotalBytes = memoryStatus.ullTotalPhys;
+        snapshot.systemMemoryUsedBytes = memoryStatus.ullTotalPhys - memoryStatus.ullAvailPhys;
+    }
+}
+
+// Thread descriptions need Windows 10 1607, looked up at run time so older systems just show ids
+typedef HRESULT(WINAPI* GetThreadDescriptionFn)(HANDLE, PWSTR*);
+typedef HRESULT(WINAPI* SetThreadDescriptionFn)(HANDLE, PCWSTR);
+
+static std::string ThreadDescription(HANDLE thread)
+{
+    static GetThreadDescriptionFn getDescription = reinterpret_cast<GetThreadDescriptionFn>(
+        GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "GetThreadDescription"));
+    if (!getDescription) return "";
+
+    PWSTR description = nullptr;
+    if (FAILED(getDescription(thread, &description)) || !description) return "";
+    std::string name;
+    int length = WideCharToMultiByte(CP_UTF8, 0, description, -1, nullptr, 0, nullptr, nullptr);
+    if (length > 1) {
+        name.resize(length - 1);
+        WideCharToMultiByte(CP_UTF8, 0, description, -1, name.data(), length, nullptr, nullptr);
+    }
+    LocalFree(description);
+    return name;
+}
+
+static void ReadThreads(std::vector<ThreadTimes>& threads)
+{
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) return;
+
+    DWORD processId = GetCurrentProcessId();
+    THREADENTRY32 entry;
+    entry.dwSize = sizeof(entry);
+    for (BOOL found = Thread32First(snapshot, &entry); found; found = Thread32Next(snapshot, &entry)) {
+        if (entry.th32OwnerProcessID != processId) continue;
+        HANDLE thread = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, entry.th32ThreadID);
+        if (!thread) continue;
+
+        FILETIME creation, exit, kernel, user;
+        if (GetThreadTimes(thread, &creation, &exit, &kernel, &user)) {
+            ThreadTimes times;
+            times.id = entry.th32ThreadID;
+            times.name = ThreadDescription(thread);
+            times.time = FileTimeToUint64(kernel) + FileTimeToUint64(user);
+            threads.push_back(std::move(times));
+        }
+        CloseHandle(thread);
+    }
+    CloseHandle(snapshot);
+}
+
+void SetNativeThreadName(const std::string& name)
+{
+    static SetThreadDescriptionFn setDescription = reinterpret_cast<SetThreadDescriptionFn>(
+        GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "SetThreadDescription"));
+    if (!setDescription) return;
+
+    int length = MultiByteToWideChar(CP_UTF8, 0, name.c_str(), -1, nullptr, 0);
+    std::wstring wide(length > 0 ? length : 1, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, name.c_str(), -1, wide.data(), length);
+    setDescription(GetCurrentThread(), wide.c_str());
+}
+
+static void* LoadNvml()
+{
+    // Installed into System32 by current drivers, older ones keep it next to nvidia-smi
+    HMODULE module = LoadLibraryA("nvml.dll");
+    if (!module) module = LoadLibraryA("C:\\Program Files\\NVIDIA Corporation\\NVSMI\\nvml.dll");
+    return module;
+}
+
+static void* NvmlSymbol(void* module, const char* name)
+{
+    return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(module), name));
+}
+
+static void UnloadNvml(void* module)
+{
+    FreeLibrary(static_cast<HMODULE>(module));
+}
+
+#elif defined(__linux__)
+
+static double CpuTimeUnitSeconds()
+{
+    static double unit = 1.0 / static_cast<double>(sysconf(_SC_CLK_TCK));
+    return unit;
+}
+
+static bool ReadSystemCpu(uint64_t& busy, uint64_t& total)
+{
+    // cpu user nice system idle iowait irq softirq steal
+    std::ifstream file("/proc/stat");
+    std::string label;
+    uint64_t values[8] = {};
+    if (!(file >> label) || label != "cpu") return false;
+    for (uint64_t& value : values) file >> value;
+    if (!file) return false;
+
+    total = 0;
+    for (uint64_t value : values) total += value;
+    busy = total - values[3] - values[4];
+    return true;
+}
+
+// utime + stime of a /proc/<pid>/stat or /proc/<pid>/task/<tid>/stat file
+static bool ReadStatTimes(const std::string& path, uint64_t& time)
+{
+    std::ifstream file(path);
+    std::string line;
+    if (!std::getline(file, line)) return false;
+
+    // The command name may contain spaces and parentheses, the fields start after the last ')'
+    size_t nameEnd = line.rfind(')');
+    if (nameEnd == std::string::npos) return false;
+    std::istringstream fields(line.substr(nameEnd + 1));
+
+    // Fields 3 (state) to 13 come before utime and stime
+    std::string skipped;
+    for (int field = 3; field <= 13; ++field) fields >> skipped;
+    uint64_t user = 0, system = 0;
+    if (!(fields >> user >> system)) return false;
+    time = user + system;
+    return true;
+}
+
+static bool ReadProcessCpu(uint64_t& time)
+{
+    return ReadStatTimes("/proc/self/stat", time);
+}
+
+// "Key:   1234 kB" lines of /proc/self/status and /proc/meminfo, in bytes
+static uint64_t ReadKilobyteField(const std::string& text, const char* key)
+{
+    size_t position = text.find(key);
+    if (position == std::string::npos) return 0;
+    return std::strtoull(text.c_str() + position + std::char_traits<char>::length(key), nullptr, 10) * 1024;
+}
+
+static std::string ReadWholeFile(const char* path)
+{
+    std::ifstream file(path);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+static void ReadMemory(SystemMetricsSnapshot& snapshot)
+{
+    std::string status = ReadWholeFile("/proc/self/status");
+    snapshot.processRssBytes = ReadKilobyteField(status, "VmRSS:");
+    snapshot.processPeakRssBytes = ReadKilobyteField(status, "VmHWM:");
+
+    std::string memoryInfo = ReadWholeFile("/proc/meminfo");
+    uint64_t total = ReadKilobyteField(memoryInfo, "MemTotal:");
+    uint64_t available = ReadKilobyteField(memoryInfo, "MemAvailable:");
+    snapshot.systemMemoryTotalBytes = total;
+    snapshot.systemMemoryUsedBytes = total > available ? total - available : 0;
+}
+
+static void ReadThreads(std::vector<ThreadTimes>& threads)
+{
+    DIR* directory = opendir("/proc/self/task");
+    if (!directory) return;
+
+    while (dirent* entry = readdir(directory)) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        std::string taskPath = std::string("/proc/self/task/") + entry->d_name;
+
+        ThreadTimes times;
+        if (!ReadStatTimes(taskPath + "/stat", times.time)) continue;  // Exited meanwhile
+        times.id = std::strtoull(entry->d_name, nullptr, 10);
+        std::ifstream comm(taskPath + "/comm");
+        std::getline(comm, times.name);
+        threads.push_back(std::move(times));
+    }
+    closedir(directory);
+}
+
+void SetNativeThreadName(const std::string& name)
+{
+    // The main thread's name is the process name in ps and top, leave it alone
+    if (static_cast<pid_t>(syscall(SYS_gettid)) == getpid()) return;
+
+    // Linux keeps at most 15 characters
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+}
+
+static void* LoadNvml()
+{
+    return dlopen("libnvidia-ml.so.1", RTLD_NOW | RTLD_LOCAL);
+}
+
+static void* NvmlSymbol(void* module, const char* name)
+{
+    return dlsym(module, name);
+}
+
+static void UnloadNvml(void* module)
+{
+    dlclose(module);
+}
+
+#else
+
+static double CpuTimeUnitSeconds() { return 1.0; }
+static bool ReadSystemCpu(uint64_t&, uint64_t&) { return false; }
+static bool ReadProcessCpu(uint64_t&) { return false; }
+static void ReadMemory(SystemMetricsSnapshot&) {}
+static void ReadThreads(std::vector<ThreadTimes>&) {}
+void SetNativeThreadName(const std::string&) {}
+static void* LoadNvml() { return nullptr; }
+static void* NvmlSymbol(void*, const char*) { return nullptr; }
+static void UnloadNvml(void*) {}
+
+#endif
+
+//----------------------------------------
+// NVML, declared here so the build needs neither its header nor its import library
+//----------------------------------------
+
+struct NvmlMemoryInfo {
+    unsigned long long total;
+    unsigned long long free;
+    unsigned long long used;
+};
+
+class Nvml {
+public:
+    ~Nvml()
+    {
+        if (m_shutdown) m_shutdown();
+        if (m_module) UnloadNvml(m_module);
+    }
+
+    // Loads the library and picks the first device, false without an NVIDIA driver
+    bool Load()
+    {
+        m_module = LoadNvml();
+        if (!m_module) return false;
+
+        auto init = reinterpret_cast<int (*)()>(NvmlSymbol(m_module, "nvmlInit_v2"));
+        auto getHandle = reinterpret_cast<int (*)(unsigned int, void**)>(NvmlSymbol(m_module, "nvmlDeviceGetHandleByIndex_v2"));
+        m_getMemory = reinterpret_cast<int (*)(void*, NvmlMemoryInfo*)>(NvmlSymbol(m_module, "nvmlDeviceGetMemoryInfo"));
+        if (!init || !getHandle || !m_getMemory || init() != 0) return false;
+        m_shutdown = reinterpret_cast<int (*)()>(NvmlSymbol(m_module, "nvmlShutdown"));
+        return getHandle(0, &m_device) == 0;
+    }
+
+    bool ReadMemory(uint64_t& used, uint64_t& total)
+    {
+        NvmlMemoryInfo memory;
+        if (!m_device || !m_getMemory || m_getMemory(m_device, &memory) != 0) return false;
+        used = memory.used;
+        total = memory.total;
+        return true;
+    }
+
+private:
+    void* m_module = nullptr;
+    void* m_device = nullptr;
+    int (*m_getMemory)(void*, NvmlMemoryInfo*) = nullptr;
+    int (*m_shutdown)() = nullptr;
+};
+
+//----------------------------------------
+// Sampler
+//----------------------------------------
+
+SystemMetricsSampler::~SystemMetricsSampler()
+{
+    Stop();
+}
+
+void SystemMetricsSampler::Start(int intervalMs)
+{
+    Stop();
+    m_stopRequested = false;
+    m_sampler = std::thread(&SystemMetricsSampler::SampleLoop, this, std::max(intervalMs, 10));
+}
+
+void SystemMetricsSampler::Stop()
+{
+    if (!m_sampler.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_stopMutex);
+        m_stopRequested = true;
+    }
+    m_stopCondition.notify_one();
+    m_sampler.join();
+}
+
+const SystemMetricsSnapshot& SystemMetricsSampler::Latest()
+{
+    if (m_middle.load(std::memory_order_relaxed) & kFresh) {
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & ~kFresh;
+    }
+    return m_slots[m_front];
+}
+
+void SystemMetricsSampler::Publish(SystemMetricsSnapshot& snapshot)
+{
+    m_slots[m_back] = snapshot;
+    m_back = m_middle.exchange(m_back | kFresh, std::memory_order_acq_rel) & ~kFresh;
+}
+
+void SystemMetricsSampler::SampleLoop(int intervalMs)
+{
+    Profiler::SetThreadName("Metrics sampler");
+
+    // NVML lives on this thread for the whole run, a slow driver call never reaches the UI
+    Nvml nvml;
+    bool hasNvml = nvml.Load();
+
+    // Previous readings, every rate is the difference between two samples
+    uint64_t lastSystemBusy = 0, lastSystemTotal = 0, lastProcessTime = 0;
+    std::unordered_map<uint64_t, uint64_t> lastThreadTimes;
+    auto lastWall = std::chrono::steady_clock::now();
+    bool hasPrevious = false;
+
+    SystemMetricsSnapshot snapshot;
+    std::vector<ThreadTimes> threads;
+    std::unique_lock<std::mutex> lock(m_stopMutex);
+    do {
+        lock.unlock();
+        {
+            PROFILE_SCOPE("Sample metrics");
+            auto wall = std::chrono::steady_clock::now();
+            double elapsedSeconds = std::chrono::duration<double>(wall - lastWall).count();
+            double unitsToCorePercent = elapsedSeconds > 0.0 ? CpuTimeUnitSeconds() / elapsedSeconds * 100.0 : 0.0;
+
+            snapshot.sequence++;
+            snapshot.systemCpuPercent = -1.0f;
+            uint64_t systemBusy, systemTotal;
+            if (ReadSystemCpu(systemBusy, systemTotal)) {
+                if (hasPrevious && systemTotal > lastSystemTotal) {
+                    snapshot.systemCpuPercent = static_cast<float>(systemBusy - lastSystemBusy) / (systemTotal - lastSystemTotal) * 100.0f;
+                }
+                lastSystemBusy = systemBusy;
+                lastSystemTotal = systemTotal;
+            }
+
+            snapshot.processCpuPercent = -1.0f;
+            uint64_t processTime;
+            if (ReadProcessCpu(processTime)) {
+                if (hasPrevious) snapshot.processCpuPercent = static_cast<float>((processTime - lastProcessTime) * unitsToCorePercent);
+                lastProcessTime = processTime;
+            }
+
+            // Threads seen for the first time get a rate on the next sample
+            threads.clear();
+            ReadThreads(threads);
+            snapshot.threads.clear();
+            std::unordered_map<uint64_t, uint64_t> threadTimes;
+            for (ThreadTimes& thread : threads) {
+                ThreadCpuSample sample;
+                sample.id = thread.id;
+                sample.name = std::move(thread.name);
+                auto last = lastThreadTimes.find(thread.id);
+                if (last != lastThreadTimes.end() && thread.time >= last->second) {
+                    sample.cpuPercent = static_cast<float>((thread.time - last->second) * unitsToCorePercent);
+                }
+                threadTimes[thread.id] = thread.time;
+                snapshot.threads.push_back(std::move(sample));
+            }
+            lastThreadTimes = std::move(threadTimes);
+
+            ReadMemory(snapshot);
+            snapshot.hasVram = hasNvml && nvml.ReadMemory(snapshot.vramUsedBytes, snapshot.vramTotalBytes);
+
+            lastWall = wall;
+            hasPrevious = true;
+            Publish(snapshot);
+        }
+        lock.lock();
+    } while (!m_stopCondition.wait_for(lock, std::chrono::milliseconds(intervalMs), [this] { return m_stopRequested; }));
+}
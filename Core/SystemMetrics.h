@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// CPU time of one thread of this process over the last sampling interval
+struct ThreadCpuSample {
+    uint64_t id = 0;            // OS thread id
+    std::string name;           // OS thread name, Profiler::SetThreadName sets it for ours
+    float cpuPercent = -1.0f;   // 100 = one core busy the whole interval
+};
+
+// One reading of the machine and the process. Rates need two samples, they are negative in the
+// first snapshot and whenever the platform cannot provide them.
+struct SystemMetricsSnapshot {
+    uint64_t sequence = 0;              // 0 until the first sample is published
+    float systemCpuPercent = -1.0f;     // All cores, 100 = machine fully busy
+    float processCpuPercent = -1.0f;    // 100 = one core
+    uint64_t processRssBytes = 0;       // Resident set / working set, threads share it
+    uint64_t processPeakRssBytes = 0;
+    uint64_t systemMemoryUsedBytes = 0;
+    uint64_t systemMemoryTotalBytes = 0;
+    bool hasVram = false;               // False without an NVIDIA driver
+    uint64_t vramUsedBytes = 0;
+    uint64_t vramTotalBytes = 0;
+    std::vector<ThreadCpuSample> threads;
+};
+
+// Samples CPU, memory and VRAM on its own thread: /proc on Linux, the Win32 process and thread
+// APIs on Windows. NVML is loaded at run time on the sampling thread and only for VRAM, machines
+// without it report hasVram = false.
+//
+// Snapshots go through a triple buffer: the sampler fills a spare slot and swaps it in with one
+// atomic exchange, the reader swaps it out the same way. Neither side ever waits for the other.
+class SystemMetricsSampler {
+public:
+    ~SystemMetricsSampler();
+
+    void Start(int intervalMs = 1000);
+    void Stop();
+
+    // Newest published snapshot. Single reader: the reference stays valid until the next call
+    // from the same thread.
+    const SystemMetricsSnapshot& Latest();
+
+private:
+    void SampleLoop(int intervalMs);
+    void Publish(SystemMetricsSnapshot& snapshot);
+
+    // Slot indices, kFresh marks a middle slot the reader has not picked up yet
+    static constexpr int kFresh = 4;
+    SystemMetricsSnapshot m_slots[3];
+    std::atomic<int> m_middle{ 1 };
+    int m_back = 0;     // Sampler thread only
+    int m_front = 2;    // Reader only
+
+    std::thread m_sampler;
+    std::mutex m_stopMutex;
+    std::condition_variable m_stopCondition;
+    bool m_stopRequested = false;
+};
+
+// Names the calling thread for debuggers and the sampler's thread list
+void SetNativeThreadName(const std::string& name);
@@ -0,0 +1,44 @@
+#include "Tessellation.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr double kSpeedOfLight = 299792458.0;
+
+float Wavelength(float frequency)
+{
+    return static_cast<float>(kSpeedOfLight / std::max(frequency, 1.0f));
+}
+
+static int ClampSegments(double segments, int minimum, const TessellationSettings& settings)
+{
+    if (!std::isfinite(segments)) return settings.maxSegments;
+    // The epsilon keeps exact multiples of the facet size from gaining a sliver row
+    return std::clamp(static_cast<int>(std::ceil(segments - 1e-6)), minimum, std::max(minimum, settings.maxSegments));
+}
+
+int StraightSegments(float length, float frequency, const TessellationSettings& settings)
+{
+    double facetSize = Wavelength(frequency) / std::max(settings.facetsPerWavelength, 1.0f);
+    return ClampSegments(std::abs(length) / facetSize, 1, settings);
+}
+
+int ArcSegments(float radius, float angle, float frequency, const TessellationSettings& settings, int minimum)
+{
+    double wavelength = Wavelength(frequency);
+    radius = std::abs(radius);
+    if (radius <= 0.0f) return minimum;
+
+    // Arc length at the target facet size
+    double byLength = radius * std::abs(angle) / (wavelength / std::max(settings.facetsPerWavelength, 1.0f));
+
+    // A chord spanning step radians sits radius * (1 - cos(step / 2)) inside the arc
+    double deviation = std::max(static_cast<double>(settings.maxDeviation), 1e-6) * wavelength;
+    double byCurvature = 0.0;
+    if (deviation < radius) {
+        double step = 2.0 * std::acos(1.0 - deviation / radius);
+        byCurvature = std::abs(angle) / step;
+    }
+
+    return ClampSegments(std::max(byLength, byCurvature), minimum, settings);
+}
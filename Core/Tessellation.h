@@ -0,0 +1,22 @@
+#pragma once
+
+// How finely the procedural primitives are subdivided. With a fixed level of detail every
+// primitive gets the same segment count whatever its size. Wavelength driven tessellation
+// instead sizes the facets for the analysis frequency: no edge longer than
+// wavelength / facetsPerWavelength, and curved edges subdivided until their chords stay
+// within maxDeviation wavelengths of the true surface.
+struct TessellationSettings {
+    bool wavelengthDriven = false;
+    float facetsPerWavelength = 10.0f;   // Target facet size is wavelength / 10
+    float maxDeviation = 1.0f / 64.0f;   // Chord to surface distance in wavelengths, keeps the
+                                         // round trip phase error of a facet under about 11 degrees
+    int maxSegments = 2048;              // Per direction, guards against millions of triangles
+};
+
+float Wavelength(float frequency);
+
+// Segments along a straight edge, at least 1
+int StraightSegments(float length, float frequency, const TessellationSettings& settings);
+
+// Segments along a circular arc of the given radius and angle (radians), at least minimum
+int ArcSegments(float radius, float angle, float frequency, const TessellationSettings& settings, int minimum = 3);
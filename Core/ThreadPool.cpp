@@ -0,0 +1,157 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+// Index of the worker running on this thread, -1 on threads the pool did not start
+static thread_local int t_workerIndex = -1;
+static thread_local const ThreadPool* t_workerPool = nullptr;
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if (threadCount == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    for (unsigned i = 0; i < threadCount; ++i) {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&ThreadPool::WorkerLoop, this, static_cast<int>(i));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    // Workers keep popping until every queue is empty, the jobs of dropped tasks only mark them
+    // finished. ParallelFor helpers still run, their caller is waiting on the chunks.
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+static unsigned s_globalThreadCount = 0;
+
+std::unique_ptr<ThreadPool> ThreadPool::CreateInline()
+{
+    return std::unique_ptr<ThreadPool>(new ThreadPool(InlineTag()));
+}
+
+ThreadPool& ThreadPool::Global()
+{
+    static ThreadPool pool(s_globalThreadCount);
+    return pool;
+}
+
+void ThreadPool::ConfigureGlobal(unsigned threadCount)
+{
+    s_globalThreadCount = threadCount;
+}
+
+bool ThreadPool::IsWorkerThread() const
+{
+    return t_workerPool == this;
+}
+
+void ThreadPool::Enqueue(Job job, TaskPriority priority)
+{
+    // Pool threads push onto their own queue, everyone else onto the shared one
+    WorkQueue& queue = IsWorkerThread() ? *m_queues[t_workerIndex] : m_injection;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs[static_cast<int>(priority)].push_back(std::move(job));
+    }
+
+    // Counted after the push, so a worker that sees a nonzero count always finds the job.
+    // Taking the sleep mutex orders this against a worker about to wait.
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_queuedJobs++;
+    }
+    m_wake.notify_one();
+}
+
+bool ThreadPool::TryPop(int index, Job& job)
+{
+    auto take = [&](WorkQueue& queue, int priority, bool newest) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        std::deque<Job>& jobs = queue.jobs[priority];
+        if (jobs.empty()) return false;
+        if (newest) {
+            job = std::move(jobs.back());
+            jobs.pop_back();
+        }
+        else {
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        m_queuedJobs--;
+        return true;
+    };
+
+    // All interactive work anywhere goes before any background work
+    for (int priority = 0; priority < 2; ++priority) {
+        if (index >= 0 && take(*m_queues[index], priority, true)) return true;
+        if (take(m_injection, priority, false)) return true;
+        size_t start = index >= 0 ? static_cast<size_t>(index) + 1 : 0;
+        for (size_t i = 0; i < m_queues.size(); ++i) {
+            size_t victim = (start + i) % m_queues.size();
+            if (static_cast<int>(victim) != index && take(*m_queues[victim], priority, false)) return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::RunPendingJob()
+{
+    Job job;
+    if (!TryPop(IsWorkerThread() ? t_workerIndex : -1, job)) return false;
+    job();
+    return true;
+}
+
+void ThreadPool::WorkerLoop(int index)
+{
+    t_workerIndex = index;
+    t_workerPool = this;
+    Profiler::SetThreadName("Worker " + std::to_string(index));
+
+    while (true) {
+        Job job;
+        if (TryPop(index, job)) {
+            PROFILE_SCOPE("Pool job");
+            job();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() { return m_stopping || m_queuedJobs > 0; });
+        if (m_stopping) return;
+    }
+}
+
+void ThreadPool::PostToMain(Job function)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mainMutex);
+        m_mainCallbacks.push_back(std::move(function));
+    }
+    if (m_mainThreadWakeup) m_mainThreadWakeup();
+}
+
+void ThreadPool::RunMainThreadCallbacks()
+{
+    std::vector<Job> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(m_mainMutex);
+        callbacks.swap(m_mainCallbacks);
+    }
+    // Callbacks may post again, those run next frame
+    for (auto& callback : callbacks) {
+        callback();
+    }
+}
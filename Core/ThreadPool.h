@@ -0,0 +1,362 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool;
+
+// Interactive work is something the user is waiting on right now (a solve, a rasterizer pass),
+// background work may take seconds (loading a model, polling metrics). Workers always drain
+// the interactive queues first.
+enum class TaskPriority {
+    Interactive,
+    Background
+};
+
+// Shared flag checked by long running tasks. Copies refer to the same flag, so the handle that
+// submitted a task can cancel it while a worker runs it.
+class CancellationToken {
+public:
+    CancellationToken() : m_flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void Cancel() const { m_flag->store(true, std::memory_order_relaxed); }
+    bool IsCancelled() const { return m_flag->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_flag;
+};
+
+// Type erased move only callable. std::function needs copyable targets, tasks often own
+// their result data (a freshly loaded Mesh) and cannot be copied.
+class Job {
+public:
+    Job() = default;
+    template<typename Function, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Function>, Job>>>
+    Job(Function function) : m_callable(std::make_unique<Callable<std::decay_t<Function>>>(std::move(function))) {}
+
+    void operator()() { m_callable->Invoke(); }
+    explicit operator bool() const { return m_callable != nullptr; }
+
+private:
+    struct Base {
+        virtual ~Base() = default;
+        virtual void Invoke() = 0;
+    };
+    template<typename Function>
+    struct Callable : Base {
+        explicit Callable(Function f) : function(std::move(f)) {}
+        void Invoke() override { function(); }
+        Function function;
+    };
+    std::unique_ptr<Base> m_callable;
+};
+
+// State shared between a Task handle, the job computing it and its continuations
+template<typename T>
+struct TaskState {
+    using Value = std::conditional_t<std::is_void_v<T>, bool, T>;
+
+    std::mutex mutex;
+    std::condition_variable done;
+    bool finished = false;          // Ran, or was dropped because it was cancelled before starting
+    std::optional<Value> value;     // Empty when the task never ran
+    CancellationToken token;
+    std::vector<Job> continuations; // Run by whichever thread finishes the task
+
+    void Finish()
+    {
+        std::vector<Job> pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished = true;
+            pending.swap(continuations);
+        }
+        done.notify_all();
+        for (auto& continuation : pending) {
+            continuation();
+        }
+    }
+
+    void AddContinuation(Job continuation)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!finished) {
+                continuations.push_back(std::move(continuation));
+                return;
+            }
+        }
+        continuation();
+    }
+};
+
+// What function(result) returns for a Task<T>, function() for Task<void>
+template<typename T, typename Function>
+struct ContinuationResult { using type = std::invoke_result_t<Function&, T&>; };
+template<typename Function>
+struct ContinuationResult<void, Function> { using type = std::invoke_result_t<Function&>; };
+
+// Handle to work submitted to a ThreadPool. Dropping the handle does not cancel the task.
+template<typename T>
+class Task {
+public:
+    Task() = default;
+
+    bool IsValid() const { return m_state != nullptr; }
+    bool IsReady() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->finished;
+    }
+
+    // Tasks that have not started yet are dropped, running ones see the token and may stop early.
+    // Continuations of a cancelled task do not run.
+    void Cancel() const { m_state->token.Cancel(); }
+    bool IsCancelled() const { return m_state->token.IsCancelled(); }
+    const CancellationToken& GetToken() const { return m_state->token; }
+
+    // Blocks until the task finished. Pool threads run other queued tasks while they wait,
+    // so tasks waiting on tasks cannot starve the pool.
+    void Wait() const;
+
+    // Waits and returns the result, which only exists if the task was not dropped by Cancel
+    bool HasValue() const { Wait(); return m_state->value.has_value(); }
+    template<typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
+    U& Get() const
+    {
+        Wait();
+        return *m_state->value;
+    }
+
+    // Runs function(result) on a pool thread once this task finished. The new task shares
+    // this one's cancellation token.
+    template<typename Function>
+    auto Then(Function function, TaskPriority priority = TaskPriority::Background) const;
+
+    // Runs function(result) on the main thread from ThreadPool::RunMainThreadCallbacks.
+    // Skipped if the task is cancelled before the callback gets to run.
+    template<typename Function>
+    void ThenOnMain(Function function) const;
+
+private:
+    friend class ThreadPool;
+    template<typename U> friend class Task;
+    Task(std::shared_ptr<TaskState<T>> state, ThreadPool* pool) : m_state(std::move(state)), m_pool(pool) {}
+
+    std::shared_ptr<TaskState<T>> m_state;
+    ThreadPool* m_pool = nullptr;
+};
+
+// Persistent work stealing pool. Every worker owns a queue per priority, pops its newest job and
+// steals the oldest from others when it runs dry. Jobs submitted from outside the pool go to a
+// shared injection queue. The threads live as long as the pool, so short tasks cost a queue push
+// instead of a thread start.
+class ThreadPool {
+public:
+    // 0 uses every hardware thread but one, which is left to the render loop
+    explicit ThreadPool(unsigned threadCount = 0);
+    // Running tasks finish. Queued tasks are dropped without a value like cancelled ones, so whoever
+    // waits on them still returns, and their continuations do not run.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Pool without worker threads: ParallelFor runs every chunk on the caller and tasks run on the
+    // thread that waits for them. Single threaded reference runs go through the same code this way.
+    static std::unique_ptr<ThreadPool> CreateInline();
+
+    // Pool shared by the application and the solvers
+    static ThreadPool& Global();
+    // Thread count Global() starts with, only effective before its first call
+    static void ConfigureGlobal(unsigned threadCount);
+
+    unsigned GetThreadCount() const { return static_cast<unsigned>(m_threads.size()); }
+    bool IsWorkerThread() const;
+    // Set once the destructor started, tasks that have not begun are dropped from then on
+    bool IsStopping() const { return m_stopping; }
+
+    // Queues function() or function(const CancellationToken&) and returns a handle to its result
+    template<typename Function>
+    auto Submit(Function function, TaskPriority priority = TaskPriority::Background, CancellationToken token = CancellationToken());
+
+    // Fork join over [0, count) split into chunkCount contiguous chunks, body(first, last, chunk).
+    // Chunk i always covers the same range whichever thread runs it. The caller takes chunks
+    // too and returns once every chunk is done, so this is safe to call from a pool thread.
+    template<typename Function>
+    void ParallelFor(size_t count, size_t chunkCount, Function body);
+
+    // Queues function to run on the main thread during the next RunMainThreadCallbacks
+    void PostToMain(Job function);
+    // Runs the callbacks posted so far, called by the main loop once per frame
+    void RunMainThreadCallbacks();
+    // Called after every PostToMain, lets a render on demand loop wake up. Set before submitting work.
+    void SetMainThreadWakeup(std::function<void()> wakeup) { m_mainThreadWakeup = std::move(wakeup); }
+
+    // Runs one queued job on the calling thread, false if there was none
+    bool RunPendingJob();
+
+    // Queues a bare job without a Task handle
+    void Enqueue(Job job, TaskPriority priority);
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs[2]; // Indexed by TaskPriority
+    };
+
+    struct InlineTag {};
+    explicit ThreadPool(InlineTag) {}
+
+    void WorkerLoop(int index);
+    bool TryPop(int index, Job& job);
+
+    template<typename Function>
+    static decltype(auto) InvokeTask(Function& function, const CancellationToken& token)
+    {
+        if constexpr (std::is_invocable_v<Function&, const CancellationToken&>) return function(token);
+        else return function();
+    }
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues; // One per worker
+    WorkQueue m_injection;                            // Jobs submitted from outside the pool
+    std::vector<std::thread> m_threads;
+
+    std::atomic<size_t> m_queuedJobs{ 0 };
+    std::atomic<bool> m_stopping{ false };
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+
+    std::mutex m_mainMutex;
+    std::vector<Job> m_mainCallbacks;
+    std::function<void()> m_mainThreadWakeup;
+};
+
+template<typename Function>
+auto ThreadPool::Submit(Function function, TaskPriority priority, CancellationToken token)
+{
+    using Result = decltype(InvokeTask(function, token));
+    auto state = std::make_shared<TaskState<Result>>();
+    state->token = std::move(token);
+
+    Enqueue([this, state, function = std::move(function)]() mutable {
+        if (!state->token.IsCancelled() && !m_stopping) {
+            if constexpr (std::is_void_v<Result>) {
+                InvokeTask(function, state->token);
+                state->value.emplace(true);
+            }
+            else {
+                state->value.emplace(InvokeTask(function, state->token));
+            }
+        }
+        state->Finish();
+    }, priority);
+
+    return Task<Result>(state, this);
+}
+
+template<typename Function>
+void ThreadPool::ParallelFor(size_t count, size_t chunkCount, Function body)
+{
+    if (chunkCount <= 1 || m_threads.empty()) {
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            body(count * chunk / chunkCount, count * (chunk + 1) / chunkCount, chunk);
+        }
+        return;
+    }
+
+    // Helpers that start after the loop is over only touch this shared block, never body
+    struct Shared {
+        std::atomic<size_t> nextChunk{ 0 };
+        std::atomic<size_t> doneChunks{ 0 };
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto shared = std::make_shared<Shared>();
+    auto runChunks = [shared, count, chunkCount, &body]() {
+        for (size_t chunk = shared->nextChunk++; chunk < chunkCount; chunk = shared->nextChunk++) {
+            body(count * chunk / chunkCount, count * (chunk + 1) / chunkCount, chunk);
+            if (++shared->doneChunks == chunkCount) {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->done.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(chunkCount - 1, m_threads.size());
+    for (size_t i = 0; i < helpers; ++i) {
+        Enqueue(runChunks, TaskPriority::Interactive);
+    }
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->done.wait(lock, [&]() { return shared->doneChunks == chunkCount; });
+}
+
+template<typename T>
+void Task<T>::Wait() const
+{
+    // Inline pools have nobody else to run the task
+    if (m_pool && (m_pool->IsWorkerThread() || m_pool->GetThreadCount() == 0)) {
+        while (!IsReady()) {
+            if (!m_pool->RunPendingJob()) std::this_thread::yield();
+        }
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_state->mutex);
+    m_state->done.wait(lock, [this]() { return m_state->finished; });
+}
+
+template<typename T>
+template<typename Function>
+auto Task<T>::Then(Function function, TaskPriority priority) const
+{
+    using Result = typename ContinuationResult<T, Function>::type;
+    auto next = std::make_shared<TaskState<Result>>();
+    next->token = m_state->token;
+
+    ThreadPool* pool = m_pool;
+    m_state->AddContinuation([state = m_state, next, pool, priority, function = std::move(function)]() mutable {
+        pool->Enqueue([state, next, pool, function = std::move(function)]() mutable {
+            if (state->value && !next->token.IsCancelled() && !pool->IsStopping()) {
+                if constexpr (std::is_void_v<Result>) {
+                    if constexpr (std::is_void_v<T>) function();
+                    else function(*state->value);
+                    next->value.emplace(true);
+                }
+                else {
+                    if constexpr (std::is_void_v<T>) next->value.emplace(function());
+                    else next->value.emplace(function(*state->value));
+                }
+            }
+            next->Finish();
+        }, priority);
+    });
+
+    return Task<Result>(next, pool);
+}
+
+template<typename T>
+template<typename Function>
+void Task<T>::ThenOnMain(Function function) const
+{
+    ThreadPool* pool = m_pool;
+    m_state->AddContinuation([state = m_state, pool, function = std::move(function)]() mutable {
+        if (!state->value || state->token.IsCancelled()) return;
+        pool->PostToMain([state, function = std::move(function)]() mutable {
+            if (state->token.IsCancelled()) return;
+            if constexpr (std::is_void_v<T>) function();
+            else function(*state->value);
+        });
+    });
+}
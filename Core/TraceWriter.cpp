@@ -0,0 +1,143 @@
+#include "TraceWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+static std::string EscapeJson(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+TraceWriter::~TraceWriter()
+{
+    Stop();
+}
+
+bool TraceWriter::Open(const std::string& path)
+{
+    m_file.open(path, std::ios::out | std::ios::trunc);
+    if (!m_file) {
+        std::cerr << "Cannot write trace " << path << std::endl;
+        return false;
+    }
+    m_path = path;
+    m_cursors.clear();
+    m_threadNames.clear();
+    m_counterTotals.clear();
+    m_writtenEvents = 0;
+    m_droppedEvents = 0;
+
+    // Timestamps are microseconds of the Profiler::Now() clock
+    m_file << std::fixed << std::setprecision(3) << "[\n"
+           << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ScatterX\"}}";
+    return true;
+}
+
+void TraceWriter::Close()
+{
+    m_file << "\n]\n";
+    m_file.close();
+}
+
+bool TraceWriter::Start(const std::string& path, int flushIntervalMs)
+{
+    Stop();
+    if (!Open(path)) return false;
+
+    m_stopRequested = false;
+    m_flusher = std::thread(&TraceWriter::FlushLoop, this, std::max(flushIntervalMs, 1));
+    return true;
+}
+
+void TraceWriter::Stop()
+{
+    if (m_flusher.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_stopMutex);
+            m_stopRequested = true;
+        }
+        m_stopCondition.notify_one();
+        m_flusher.join();
+    }
+    if (!m_file.is_open()) return;
+
+    Flush();
+    Close();
+    if (m_droppedEvents > 0) {
+        std::cerr << "Trace " << m_path << ": " << m_droppedEvents << " events were overwritten before they were written" << std::endl;
+    }
+}
+
+void TraceWriter::FlushLoop(int flushIntervalMs)
+{
+    std::unique_lock<std::mutex> lock(m_stopMutex);
+    while (!m_stopCondition.wait_for(lock, std::chrono::milliseconds(flushIntervalMs), [this] { return m_stopRequested; })) {
+        lock.unlock();
+        Flush();
+        lock.lock();
+    }
+}
+
+void TraceWriter::Flush()
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    std::vector<ProfileThreadSnapshot> threads;
+    m_droppedEvents += Profiler::Drain(m_cursors, threads);
+    WriteEvents(threads);
+    m_file.flush();
+}
+
+void TraceWriter::WriteEvents(const std::vector<ProfileThreadSnapshot>& threads)
+{
+    // The process_name record opens the array, every event after it follows a comma
+    auto separator = [this]() -> std::ostream& { return m_file << ",\n"; };
+
+    std::vector<const ProfileEvent*> counters;
+    for (const ProfileThreadSnapshot& thread : threads) {
+        if (m_threadNames.size() <= thread.threadIndex) m_threadNames.resize(thread.threadIndex + 1);
+        if (m_threadNames[thread.threadIndex] != thread.name) {
+            m_threadNames[thread.threadIndex] = thread.name;
+            separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.threadIndex
+                        << ",\"args\":{\"name\":\"" << EscapeJson(thread.name) << "\"}}";
+        }
+
+        for (const ProfileEvent& event : thread.events) {
+            if (event.kind == ProfileEventKind::Counter) {
+                counters.push_back(&event);
+                continue;
+            }
+            separator() << "{\"name\":\"" << EscapeJson(event.name) << "\",\"cat\":\"" << (thread.name == "GPU" ? "gpu" : "cpu")
+                        << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.threadIndex
+                        << ",\"ts\":" << event.startNs * 1.0e-3 << ",\"dur\":" << (event.endNs - event.startNs) * 1.0e-3 << "}";
+        }
+        m_writtenEvents += thread.events.size();
+    }
+
+    // Counters are process wide running totals, summed in time order across the threads
+    std::sort(counters.begin(), counters.end(), [](const ProfileEvent* a, const ProfileEvent* b) { return a->endNs < b->endNs; });
+    for (const ProfileEvent* event : counters) {
+        uint64_t& total = m_counterTotals[event->name];
+        total += event->count;
+        separator() << "{\"name\":\"" << EscapeJson(event->name) << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << event->endNs * 1.0e-3
+                    << ",\"args\":{\"total\":" << total << "}}";
+    }
+}
+
+bool TraceWriter::WriteSnapshot(const std::string& path)
+{
+    TraceWriter writer;
+    if (!writer.Open(path)) return false;
+
+    std::vector<ProfileThreadSnapshot> threads;
+    Profiler::Collect(0, threads);
+    writer.WriteEvents(threads);
+    writer.Close();
+    return true;
+}
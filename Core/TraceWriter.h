@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Profiler.h"
+
+// Writes profiler events as Chrome trace JSON, which chrome://tracing and ui.perfetto.dev open.
+// Scopes become complete ("X") events on one track per thread, GPU pass times get a "GPU" track
+// and Profiler::Count increments become counter ("C") tracks with running totals.
+//
+// A capture streams: a background thread drains the profiler every interval and appends to the
+// file, so a sweep running for hours is kept whole as long as no thread records more than
+// Profiler::kEventsPerThread events within one interval. Events lost that way are counted.
+// The file uses the JSON array form, which the viewers still read if the closing bracket never
+// got written because the process died.
+class TraceWriter {
+public:
+    ~TraceWriter();
+
+    // Starts writing into path, beginning with what the ring buffers still hold
+    bool Start(const std::string& path, int flushIntervalMs = 100);
+    // Drains what is left and closes the file
+    void Stop();
+    bool IsRunning() const { return m_file.is_open(); }
+
+    const std::string& GetPath() const { return m_path; }
+    uint64_t GetWrittenEvents() const { return m_writtenEvents.load(std::memory_order_relaxed); }
+    uint64_t GetDroppedEvents() const { return m_droppedEvents.load(std::memory_order_relaxed); }
+
+    // One shot export of whatever the ring buffers still hold, e.g. the last few seconds in the GUI
+    static bool WriteSnapshot(const std::string& path);
+
+private:
+    bool Open(const std::string& path);
+    void Close();
+    void Flush();
+    void WriteEvents(const std::vector<ProfileThreadSnapshot>& threads);
+    void FlushLoop(int flushIntervalMs);
+
+    std::ofstream m_file;
+    std::string m_path;
+    std::mutex m_fileMutex;                 // Flush runs on the flusher thread and in Stop
+    std::vector<uint64_t> m_cursors;        // Profiler::Drain position per thread
+    std::vector<std::string> m_threadNames; // Last name written per thread, renamed threads get a new "M" event
+    std::map<std::string, uint64_t> m_counterTotals;
+
+    std::thread m_flusher;
+    std::mutex m_stopMutex;
+    std::condition_variable m_stopCondition;
+    bool m_stopRequested = false;
+
+    std::atomic<uint64_t> m_writtenEvents{ 0 };
+    std::atomic<uint64_t> m_droppedEvents{ 0 };
+};
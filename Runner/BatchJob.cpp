@@ -0,0 +1,483 @@
+#include "BatchJob.h"
+#include "MeshGenerators.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+static bool ParseFloat(const std::string& word, float& value)
+{
+    char* end = nullptr;
+    value = std::strtof(word.c_str(), &end);
+    return end != word.c_str() && *end == '\0';
+}
+
+static bool ParseInt(const std::string& word, int& value)
+{
+    char* end = nullptr;
+    long parsed = std::strtol(word.c_str(), &end, 10);
+    value = static_cast<int>(parsed);
+    return end != word.c_str() && *end == '\0';
+}
+
+static bool ParseSwitch(const std::string& word, bool& value)
+{
+    if (word == "on" || word == "true" || word == "1") value = true;
+    else if (word == "off" || word == "false" || word == "0") value = false;
+    else return false;
+    return true;
+}
+
+// Reads the arguments after the directive name as floats, there must be exactly count of them
+static bool ParseFloats(const std::vector<std::string>& words, size_t count, float* values, std::string& error)
+{
+    if (words.size() != count + 1) {
+        error = words[0] + " expects " + std::to_string(count) + " values";
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!ParseFloat(words[i + 1], values[i])) {
+            error = words[0] + ": '" + words[i + 1] + "' is not a number";
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ParseRange(const std::vector<std::string>& words, SweepRange& range, std::string& error)
+{
+    if (words.size() != 2 && words.size() != 4) {
+        error = words[0] + " expects <start> or <start> <stop> <count>";
+        return false;
+    }
+    range = SweepRange();
+    if (!ParseFloat(words[1], range.start)) {
+        error = words[0] + ": '" + words[1] + "' is not a number";
+        return false;
+    }
+    range.stop = range.start;
+    if (words.size() == 4 && (!ParseFloat(words[2], range.stop) || !ParseInt(words[3], range.count) || range.count < 1)) {
+        error = words[0] + ": stop must be a number and count at least 1";
+        return false;
+    }
+    return true;
+}
+
+// Optional trailing axis of plates and disks
+static bool ParseAxis(const std::vector<std::string>& words, size_t index, int& axis, std::string& error)
+{
+    if (words.size() <= index) return true;
+    if (words[index] == "x" || words[index] == "X") axis = 0;
+    else if (words[index] == "y" || words[index] == "Y") axis = 1;
+    else if (words[index] == "z" || words[index] == "Z") axis = 2;
+    else {
+        error = words[0] + ": axis must be x, y or z";
+        return false;
+    }
+    return true;
+}
+
+bool ParseJobDirective(const std::vector<std::string>& words, BatchJob& job, std::string& error)
+{
+    if (words.empty()) return true;
+    const std::string& name = words[0];
+
+    // Objects
+    auto addObject = [&](JobObject::Kind kind) -> JobObject& {
+        JobObject object;
+        object.kind = kind;
+        object.LOD = job.LOD;
+        job.objects.push_back(object);
+        return job.objects.back();
+    };
+    auto lastObject = [&]() -> JobObject* {
+        if (job.objects.empty()) error = name + " needs an object before it";
+        return job.objects.empty() ? nullptr : &job.objects.back();
+    };
+
+    if (name == "obj") {
+        if (words.size() != 2) {
+            error = "obj expects a path";
+            return false;
+        }
+        addObject(JobObject::Kind::Model).path = words[1];
+        return true;
+    }
+    if (name == "plate") {
+        if (words.size() < 3 || words.size() > 4) {
+            error = "plate expects <width> <height> [axis]";
+            return false;
+        }
+        std::vector<std::string> sizes(words.begin(), words.begin() + 3);
+        float values[2];
+        if (!ParseFloats(sizes, 2, values, error)) return false;
+        JobObject& object = addObject(JobObject::Kind::Plate);
+        object.size = glm::vec3(values[0], values[1], 0.0f);
+        return ParseAxis(words, 3, object.axis, error);
+    }
+    if (name == "disk") {
+        if (words.size() < 2 || words.size() > 3) {
+            error = "disk expects <radius> [axis]";
+            return false;
+        }
+        float radius;
+        if (!ParseFloat(words[1], radius)) {
+            error = "disk: '" + words[1] + "' is not a number";
+            return false;
+        }
+        JobObject& object = addObject(JobObject::Kind::Disk);
+        object.size = glm::vec3(radius, 0.0f, 0.0f);
+        return ParseAxis(words, 2, object.axis, error);
+    }
+
+    struct Shape {
+        const char* name;
+        JobObject::Kind kind;
+        size_t values;
+    };
+    static const Shape shapes[] = {
+        { "box", JobObject::Kind::Box, 3 },
+        { "sphere", JobObject::Kind::Sphere, 1 },
+        { "cylinder", JobObject::Kind::Cylinder, 2 },
+        { "trihedral", JobObject::Kind::Trihedral, 1 },
+        { "dihedral", JobObject::Kind::Dihedral, 1 },
+    };
+    for (const Shape& shape : shapes) {
+        if (name != shape.name) continue;
+        float values[3] = { 0.0f, 0.0f, 0.0f };
+        if (!ParseFloats(words, shape.values, values, error)) return false;
+        addObject(shape.kind).size = glm::vec3(values[0], values[1], values[2]);
+        return true;
+    }
+
+    // Transform and material of the last object
+    if (name == "position" || name == "rotation" || name == "scale") {
+        JobObject* object = lastObject();
+        float values[3];
+        if (!object || !ParseFloats(words, 3, values, error)) return false;
+        glm::vec3 vector(values[0], values[1], values[2]);
+        if (name == "position") object->position = vector;
+        else if (name == "rotation") object->rotation = vector;
+        else object->scale = vector;
+        return true;
+    }
+    if (name == "material") {
+        JobObject* object = lastObject();
+        if (!object) return false;
+        if (words.size() != 2 || !ParseInt(words[1], object->material) || object->material < 0) {
+            error = "material expects a material ID";
+            return false;
+        }
+        return true;
+    }
+
+    // Tessellation
+    if (name == "lod") {
+        if (words.size() != 2 || !ParseInt(words[1], job.LOD) || job.LOD < 1) {
+            error = "lod expects a segment count of at least 1";
+            return false;
+        }
+        return true;
+    }
+    if (name == "tessellation") {
+        if (words.size() != 2 || !ParseFloat(words[1], job.tessellation.facetsPerWavelength) || job.tessellation.facetsPerWavelength <= 0.0f) {
+            error = "tessellation expects facets per wavelength";
+            return false;
+        }
+        job.tessellation.wavelengthDriven = true;
+        return true;
+    }
+
+    // Sweeps
+    if (name == "frequency") return ParseRange(words, job.frequency, error);
+    if (name == "azimuth") return ParseRange(words, job.azimuth, error);
+    if (name == "elevation") return ParseRange(words, job.elevation, error);
+    if (name == "polarization") {
+        if (words.size() == 2 && words[1] == "HH") job.polarizations = { Polarization::HH };
+        else if (words.size() == 2 && words[1] == "VV") job.polarizations = { Polarization::VV };
+        else if (words.size() == 2 && words[1] == "both") job.polarizations = { Polarization::HH, Polarization::VV };
+        else {
+            error = "polarization expects HH, VV or both";
+            return false;
+        }
+        return true;
+    }
+
+    // Solver and output
+    bool* switches[] = { &job.shadowing, &job.edgeDiffraction, &job.analyticPrimitives, &job.checkDeterminism };
+    const char* switchNames[] = { "shadowing", "edges", "analytic", "check-determinism" };
+    for (int i = 0; i < 4; ++i) {
+        if (name != switchNames[i]) continue;
+        if (words.size() != 2 || !ParseSwitch(words[1], *switches[i])) {
+            error = name + " expects on or off";
+            return false;
+        }
+        return true;
+    }
+    if (name == "shadow-resolution") {
+        if (words.size() != 2 || !ParseInt(words[1], job.shadowResolution) || job.shadowResolution < 16) {
+            error = "shadow-resolution expects at least 16 pixels";
+            return false;
+        }
+        return true;
+    }
+    if (name == "threads") {
+        int threads;
+        if (words.size() != 2 || !ParseInt(words[1], threads) || threads < 0) {
+            error = "threads expects a count, 0 for automatic";
+            return false;
+        }
+        job.threads = static_cast<unsigned>(threads);
+        return true;
+    }
+    if (name == "output") {
+        if (words.size() != 2) {
+            error = "output expects a path";
+            return false;
+        }
+        job.output = words[1];
+        return true;
+    }
+    if (name == "trace") {
+        if (words.size() != 2) {
+            error = "trace expects a path";
+            return false;
+        }
+        job.trace = words[1];
+        return true;
+    }
+
+    error = "unknown directive '" + name + "'";
+    return false;
+}
+
+bool LoadJobFile(const std::string& path, BatchJob& job, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream stream(line);
+        std::vector<std::string> words;
+        for (std::string word; stream >> word;) {
+            words.push_back(word);
+        }
+
+        std::string directiveError;
+        if (!ParseJobDirective(words, job, directiveError)) {
+            error = path + ":" + std::to_string(lineNumber) + ": " + directiveError;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BuildJobScene(const BatchJob& job, std::vector<Mesh>& meshes, std::string& error)
+{
+    // Wavelength driven primitives resolve the shortest wavelength of the sweep
+    MeshDetail detail;
+    detail.tessellation = job.tessellation;
+    detail.frequency = std::max(job.frequency.start, job.frequency.stop);
+
+    meshes.clear();
+    meshes.reserve(job.objects.size());
+    for (const JobObject& object : job.objects) {
+        Mesh mesh;
+        detail.LOD = object.LOD;
+        const glm::vec3& size = object.size;
+        const glm::vec3 origin(0.0f);
+
+        switch (object.kind) {
+        case JobObject::Kind::Model:
+            mesh.LoadObjectModelFromDisk(object.path);
+            if (mesh.triangles.empty()) {
+                error = "no triangles loaded from " + object.path;
+                return false;
+            }
+            break;
+        case JobObject::Kind::Plate:
+            GeneratePlaneMesh(mesh, object.axis, -0.5f * size.x, 0.5f * size.x, -0.5f * size.y, 0.5f * size.y, detail);
+            break;
+        case JobObject::Kind::Box:
+            GenerateCubeMesh(mesh, origin, size, detail);
+            break;
+        case JobObject::Kind::Sphere:
+            GenerateSphereMesh(mesh, origin, size.x, detail);
+            break;
+        case JobObject::Kind::Cylinder:
+            GenerateCylinderMesh(mesh, origin, size.x, size.y, detail);
+            break;
+        case JobObject::Kind::Disk:
+            GenerateDiskMesh(mesh, origin, size.x, object.axis, detail);
+            break;
+        case JobObject::Kind::Trihedral:
+            GenerateTrihedralMesh(mesh, origin, size.x);
+            break;
+        case JobObject::Kind::Dihedral:
+            GenerateDihedralMesh(mesh, origin, size.x);
+            break;
+        }
+
+        if (object.material >= 0) {
+            for (size_t t = 0; t < mesh.triangles.size(); ++t) {
+                mesh.SetTriangleMaterial(t, static_cast<MaterialID>(object.material));
+            }
+        }
+
+        mesh.position = object.position;
+        mesh.rotation = object.rotation;
+        mesh.scale = object.scale;
+        mesh.UpdateModelMatrix();
+        meshes.push_back(std::move(mesh));
+    }
+
+    if (meshes.empty()) {
+        error = "the job has no objects";
+        return false;
+    }
+    return true;
+}
+
+// Solver on a pool of its own, for check-determinism
+struct DeterminismRun {
+    const char* label;
+    std::unique_ptr<ThreadPool> pool;
+    PhysicalOpticsSolver solver;
+};
+
+// Bitwise, so that -0.0 differs from 0.0 and a NaN matches itself
+static bool SameBits(double a, double b)
+{
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static bool SameResult(const ScatteringResult& a, const ScatteringResult& b)
+{
+    return SameBits(a.field.real(), b.field.real()) && SameBits(a.field.imag(), b.field.imag())
+        && SameBits(a.edgeField.real(), b.edgeField.real()) && SameBits(a.edgeField.imag(), b.edgeField.imag())
+        && SameBits(a.rcs, b.rcs) && a.litTriangles == b.litTriangles;
+}
+
+bool RunBatchJob(const BatchJob& job, std::vector<Mesh>& meshes, MaterialLibrary& materials, std::ostream& standardOutput, std::string& error)
+{
+    std::ofstream file;
+    if (job.output != "-") {
+        file.open(job.output);
+        if (!file) {
+            error = "cannot write " + job.output;
+            return false;
+        }
+    }
+    std::ostream& out = job.output != "-" ? static_cast<std::ostream&>(file) : standardOutput;
+
+    // Reflection tables have to cover the whole sweep, lookups outside are clamped
+    float lowest = std::min(job.frequency.start, job.frequency.stop);
+    float highest = std::max(job.frequency.start, job.frequency.stop);
+    if (lowest < materials.GetMinFrequency() || highest > materials.GetMaxFrequency()) {
+        materials.SetFrequencyRange(std::min(lowest, materials.GetMinFrequency()), std::max(highest, materials.GetMaxFrequency()));
+    }
+
+    PhysicalOpticsSolver solver;
+    solver.writeContributions = false;  // Nothing displays the heat map
+    solver.shadowing = job.shadowing;
+    solver.shadowRasterizer.resolution = job.shadowResolution;
+    solver.edgeDiffraction = job.edgeDiffraction;
+    solver.analyticPrimitives = job.analyticPrimitives;
+
+    // The same solve on 1, 4 and all hardware threads has to give the same bits as the main one
+    DeterminismRun runs[3] = {
+        { "1 thread", nullptr, {} },
+        { "4 threads", nullptr, {} },
+        { "all hardware threads", nullptr, {} },
+    };
+    size_t mismatches = 0;
+    if (job.checkDeterminism) {
+        runs[0].pool = ThreadPool::CreateInline();
+        runs[1].pool = std::make_unique<ThreadPool>(3);
+        runs[2].pool = std::make_unique<ThreadPool>(0);
+        for (DeterminismRun& run : runs) {
+            run.solver.writeContributions = false;
+            run.solver.shadowing = job.shadowing;
+            run.solver.shadowRasterizer.resolution = job.shadowResolution;
+            run.solver.edgeDiffraction = job.edgeDiffraction;
+            run.solver.analyticPrimitives = job.analyticPrimitives;
+            run.solver.pool = run.pool.get();
+            run.solver.shadowRasterizer.pool = run.pool.get();
+        }
+    }
+
+    out << "frequency_hz,azimuth_deg,elevation_deg,polarization,rcs_m2,rcs_dbsm,field_re,field_im,lit_triangles,time_ms\n";
+    out.precision(9);
+
+    size_t total = static_cast<size_t>(job.frequency.count) * job.polarizations.size() * job.elevation.count * job.azimuth.count;
+    size_t done = 0;
+    int lastPercent = -1;
+    auto start = std::chrono::steady_clock::now();
+
+    ScatteringSettings settings;
+    for (int f = 0; f < job.frequency.count; ++f) {
+        settings.frequency = job.frequency.Value(f);
+        for (Polarization polarization : job.polarizations) {
+            settings.polarization = polarization;
+            for (int e = 0; e < job.elevation.count; ++e) {
+                settings.elevation = job.elevation.Value(e);
+                for (int a = 0; a < job.azimuth.count; ++a) {
+                    settings.azimuth = job.azimuth.Value(a);
+
+                    ScatteringResult result = solver.Solve(meshes, materials, settings);
+                    out << settings.frequency << ',' << settings.azimuth << ',' << settings.elevation << ','
+                        << (polarization == Polarization::HH ? "HH" : "VV") << ','
+                        << result.rcs << ',' << result.rcsDBsm << ','
+                        << result.field.real() << ',' << result.field.imag() << ','
+                        << result.litTriangles << ',' << result.timeMs << '\n';
+
+                    if (job.checkDeterminism) {
+                        for (DeterminismRun& run : runs) {
+                            ScatteringResult other = run.solver.Solve(meshes, materials, settings);
+                            if (SameResult(result, other)) continue;
+                            ++mismatches;
+                            std::cerr << "  Result on " << run.label << " differs at " << settings.frequency << " Hz, azimuth "
+                                << settings.azimuth << ", elevation " << settings.elevation << ": field "
+                                << other.field << " instead of " << result.field << std::endl;
+                        }
+                    }
+
+                    int percent = static_cast<int>(100 * ++done / total);
+                    if (percent / 10 != lastPercent / 10) {
+                        std::cerr << "  " << percent << "% (" << done << "/" << total << " solves)" << std::endl;
+                        lastPercent = percent;
+                    }
+                }
+            }
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Solved " << total << " aspects in " << seconds << " s on "
+        << ThreadPool::Global().GetThreadCount() + 1 << " threads" << std::endl;
+
+    if (job.checkDeterminism) {
+        if (mismatches > 0) {
+            error = std::to_string(mismatches) + " results differ between 1, 4 and " + std::to_string(runs[2].pool->GetThreadCount() + 1)
+                + " threads";
+            return false;
+        }
+        std::cerr << "Results are bit identical on 1, 4 and " << runs[2].pool->GetThreadCount() + 1 << " threads" << std::endl;
+    }
+
+    if (!out) {
+        error = "writing " + job.output + " failed";
+        return false;
+    }
+    return true;
+}
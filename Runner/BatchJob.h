@@ -0,0 +1,98 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "Scattering.h"
+#include "Tessellation.h"
+
+// Evenly spaced sweep from start to stop inclusive, a single value when count is 1
+struct SweepRange {
+    float start = 0.0f;
+    float stop = 0.0f;
+    int count = 1;
+
+    float Value(int index) const { return count > 1 ? start + (stop - start) * index / (count - 1) : start; }
+};
+
+// One object of the scene, built once the whole job has been read
+struct JobObject {
+    enum class Kind { Model, Plate, Box, Sphere, Cylinder, Disk, Trihedral, Dihedral };
+
+    Kind kind = Kind::Model;
+    std::string path;                    // Model only
+    glm::vec3 size = glm::vec3(0.0f);    // Primitive dimensions, see ParseJobDirective
+    int axis = 1;                        // Plate and disk normal, 0 = X, 1 = Y, 2 = Z
+    int LOD = 10;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 rotation = glm::vec3(0.0f); // Degrees
+    glm::vec3 scale = glm::vec3(1.0f);
+    int material = -1;                   // Whole object, -1 keeps what the model or generator set
+};
+
+// Scene, sweeps and solver options of a headless run. Written as one directive per line:
+//
+//   # comment
+//   obj <path>                        Wavefront OBJ model
+//   plate <width> <height> [axis]     Primitives centred at the origin, axis is the plate or disk normal
+//   box <x> <y> <z>
+//   sphere <radius>
+//   cylinder <radius> <height>
+//   disk <radius> [axis]
+//   trihedral <edge>
+//   dihedral <edge>
+//   position <x> <y> <z>              Transform and material of the last object
+//   rotation <x> <y> <z>              Degrees
+//   scale <x> <y> <z>
+//   material <id>
+//   lod <segments>                    Fixed tessellation of the primitives that follow
+//   tessellation <facets/wavelength>  Primitives sized for the highest swept frequency instead
+//   frequency <start> [<stop> <count>]    Hz
+//   azimuth <start> [<stop> <count>]      Degrees, 0 looks from +Z
+//   elevation <start> [<stop> <count>]    Degrees
+//   polarization HH | VV | both
+//   shadowing on | off
+//   shadow-resolution <pixels>
+//   edges on | off
+//   analytic on | off
+//   threads <count>                   Pool threads, 0 for all but one hardware thread
+//   check-determinism on | off        Also solves on 1, 4 and all hardware threads, fails unless bit identical
+//   output <path>                     CSV file, - for standard output
+//   trace <path>                      Chrome trace JSON of the whole run, see TraceWriter
+struct BatchJob {
+    std::vector<JobObject> objects;
+
+    SweepRange frequency = { 10.0e9f, 10.0e9f, 1 };
+    SweepRange azimuth;
+    SweepRange elevation;
+    std::vector<Polarization> polarizations = { Polarization::VV };
+
+    TessellationSettings tessellation;
+    int LOD = 10;
+
+    bool shadowing = true;
+    int shadowResolution = 1024;
+    bool edgeDiffraction = true;
+    bool analyticPrimitives = true;
+    unsigned threads = 0;
+    bool checkDeterminism = false;
+    std::string output = "-";
+    std::string trace;                 // Empty for no trace
+};
+
+// Applies one directive split into words. Returns false and fills error for unknown
+// directives and malformed arguments.
+bool ParseJobDirective(const std::vector<std::string>& words, BatchJob& job, std::string& error);
+
+// Reads a job file, errors are reported as path:line: message
+bool LoadJobFile(const std::string& path, BatchJob& job, std::string& error);
+
+// Loads and generates the objects, meshes come back transformed and ready for the solver
+bool BuildJobScene(const BatchJob& job, std::vector<Mesh>& meshes, std::string& error);
+
+// Solves every frequency, polarization, elevation and azimuth of the job in that nesting order
+// and writes one CSV row per solve. Output "-" goes to standardOutput.
+bool RunBatchJob(const BatchJob& job, std::vector<Mesh>& meshes, MaterialLibrary& materials, std::ostream& standardOutput, std::string& error);
@@ -0,0 +1,101 @@
+// Headless batch runner: no window, no GL context and no GPU libraries. Reads a job file and/or
+// directives given as --name arguments, sweeps the scene and writes the RCS of every aspect as CSV.
+//
+//   ScatterXRunner job.txt
+//   ScatterXRunner --obj Database/F16.obj --rotation 0 90 0 --azimuth 0 360 361 --output f16.csv
+//   ScatterXRunner job.txt --trace sweep.json      Profile the run, open the file in ui.perfetto.dev
+//
+// Command line directives are applied after the job file, see BatchJob.h for the list.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BatchJob.h"
+#include "MemoryTracker.h"
+#include "ThreadPool.h"
+#include "TraceWriter.h"
+
+static void PrintUsage()
+{
+    std::cerr << "Usage: ScatterXRunner [job file] [--directive values...]...\n"
+                 "  e.g. ScatterXRunner --sphere 1 --frequency 1e9 10e9 10 --polarization both --output sphere.csv\n";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    BatchJob job;
+    std::string error;
+
+    // A leading argument without dashes is the job file, every --name starts a directive
+    int argument = 1;
+    if (std::string(argv[1]).rfind("--", 0) != 0) {
+        if (!LoadJobFile(argv[1], job, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        argument = 2;
+    }
+    while (argument < argc) {
+        std::string name = argv[argument++];
+        if (name == "--help") {
+            PrintUsage();
+            return 0;
+        }
+        if (name.rfind("--", 0) != 0) {
+            std::cerr << "expected a --directive, got '" << name << "'" << std::endl;
+            return 1;
+        }
+
+        std::vector<std::string> words = { name.substr(2) };
+        while (argument < argc && std::string(argv[argument]).rfind("--", 0) != 0) {
+            words.push_back(argv[argument++]);
+        }
+        if (!ParseJobDirective(words, job, error)) {
+            std::cerr << name << ": " << error << std::endl;
+            return 1;
+        }
+    }
+
+    // Sized before anything touches the pool
+    ThreadPool::ConfigureGlobal(job.threads);
+
+    // Core code logs to std::cout, standard output is kept for the CSV
+    std::ostream csv(std::cout.rdbuf());
+    std::streambuf* consoleBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+    // Started before the scene is built so model loading shows up too
+    Profiler::SetThreadName("Main");
+    TraceWriter trace;
+    if (!job.trace.empty() && !trace.Start(job.trace)) return 1;
+
+    int status = 0;
+    {
+        std::vector<Mesh> meshes;
+        MaterialLibrary materials;
+        bool built = BuildJobScene(job, meshes, error);
+        if (built) {
+            std::cerr << "Memory after building the scene:\n";
+            MemoryTracker::Print(std::cerr);
+        }
+        if (!built || !RunBatchJob(job, meshes, materials, csv, error)) {
+            std::cerr << error << std::endl;
+            status = 1;
+        }
+        else {
+            // Peaks include the solver's buffers at their largest aspect
+            std::cerr << "Memory after the sweep:\n";
+            MemoryTracker::Print(std::cerr);
+        }
+    }
+
+    trace.Stop();
+    csv.flush();
+    std::cout.rdbuf(consoleBuffer);
+    return status;
+}
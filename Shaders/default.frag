@@ -7,16 +7,56 @@ out vec4 FragColor;
 in vec3 fragColor;
 
 // Highlight parameters
-uniform bool isHighlighted = false;
+uniform bool useSelectionMask = false;
+uniform usamplerBuffer selectionMask; // One bit per triangle, 32 triangles per texel
 uniform vec3 highlightColor = vec3(0.0, 1.0, 0.0); // Default to green
 
+// Heat map parameters
+uniform bool useHeatMap = false;
+uniform samplerBuffer heatMapValues;  // One value per triangle
+uniform vec2 heatMapRange = vec2(0.0, 1.0);
+uniform bool heatMapLogScale = false;
+
+// Polynomial fit of the Turbo colormap, t in [0, 1]
+vec3 turbo(float t)
+{
+    const vec4 kRed4 = vec4(0.13572138, 4.61539260, -42.66032258, 132.13108234);
+    const vec4 kGreen4 = vec4(0.09140261, 2.19418839, 4.84296658, -14.18503333);
+    const vec4 kBlue4 = vec4(0.10667330, 12.64194608, -60.58204836, 110.36276771);
+    const vec2 kRed2 = vec2(-152.94239396, 59.28637943);
+    const vec2 kGreen2 = vec2(4.27729857, 2.82956604);
+    const vec2 kBlue2 = vec2(-89.90310912, 27.34824973);
+
+    t = clamp(t, 0.0, 1.0);
+    vec4 v4 = vec4(1.0, t, t * t, t * t * t);
+    vec2 v2 = v4.zw * v4.z;
+    return vec3(
+        dot(v4, kRed4) + dot(v2, kRed2),
+        dot(v4, kGreen4) + dot(v2, kGreen2),
+        dot(v4, kBlue4) + dot(v2, kBlue2)
+    );
+}
+
 void main()
 {
+    bool isHighlighted = false;
+    if (useSelectionMask) {
+        // gl_PrimitiveID matches the triangle index of the single draw call
+        uint word = texelFetch(selectionMask, gl_PrimitiveID >> 5).r;
+        isHighlighted = ((word >> (uint(gl_PrimitiveID) & 31u)) & 1u) != 0u;
+    }
+
     if (isHighlighted) {
-        // Use highlight color when the triangle is picked
+        // Use highlight color when the triangle is selected
         FragColor = vec4(highlightColor, 1.0);
+    } else if (useHeatMap) {
+        // Map the triangle value into the colormap range
+        float value = texelFetch(heatMapValues, gl_PrimitiveID).r;
+        if (heatMapLogScale) value = 10.0 * log(max(value, 1e-30)) / log(10.0);
+        float span = max(heatMapRange.y - heatMapRange.x, 1e-6);
+        FragColor = vec4(turbo((value - heatMapRange.x) / span), 1.0);
     } else {
         // Directly use the color passed from the vertex shader
         FragColor = vec4(fragColor, 1.0);  // Add 1.0 for alpha (opaque)
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,51 @@
+#version 330 core
+
+// Outputs colors in RGBA
+out vec4 FragColor;
+
+// Interpolated view ray from the vertex shader
+in vec3 nearPoint;
+in vec3 farPoint;
+
+// Grid parameters
+uniform vec3 cameraPos;
+uniform vec3 gridColor = vec3(0.4);
+uniform float baseStep = 1.0;      // Line spacing when the camera is close to the ground
+uniform float halfSize = 75.0;     // Grid extends from -halfSize to halfSize on X and Z
+uniform float fadeDistance = 100.0;
+
+// Antialiased line intensity (0 - 1) for lines every cellSize units
+float gridLines(vec2 coord, float cellSize)
+{
+    vec2 cell = coord / cellSize;
+    vec2 width = fwidth(cell);
+    vec2 distanceToLine = abs(fract(cell - 0.5) - 0.5) / width;
+    return 1.0 - min(min(distanceToLine.x, distanceToLine.y), 1.0);
+}
+
+void main()
+{
+    // Intersect the view ray with the y = 0 plane
+    float denominator = farPoint.y - nearPoint.y;
+    if (abs(denominator) < 1e-8) discard;
+    float t = -nearPoint.y / denominator;
+    if (t <= 0.0) discard;
+
+    vec3 point = nearPoint + t * (farPoint - nearPoint);
+    if (abs(point.x) > halfSize || abs(point.z) > halfSize) discard;
+
+    // Adaptive subdivision, each decade of camera height multiplies the spacing by 10
+    // and the finer level fades out before it disappears
+    float lod = max(0.0, log(max(abs(cameraPos.y), 1e-4) / baseStep) / log(10.0) - 1.0);
+    float fineStep = baseStep * pow(10.0, floor(lod));
+    float fine = gridLines(point.xz, fineStep) * (1.0 - fract(lod));
+    float coarse = gridLines(point.xz, fineStep * 10.0);
+
+    // Fade with distance to hide aliasing near the horizon
+    float distanceFade = 1.0 - smoothstep(fadeDistance * 0.5, fadeDistance, length(point - cameraPos));
+
+    float alpha = max(fine, coarse) * distanceFade;
+    if (alpha <= 0.0) discard;
+
+    FragColor = vec4(gridColor, alpha);
+}
@@ -0,0 +1,24 @@
+#version 330 core
+
+// Inverse of the camera matrix (view * projection), used to unproject the screen
+uniform mat4 invCamMatrix;
+
+// World space points on the near and far plane for this pixel
+out vec3 nearPoint;
+out vec3 farPoint;
+
+vec3 unproject(vec2 ndc, float depth)
+{
+    vec4 point = invCamMatrix * vec4(ndc, depth, 1.0);
+    return point.xyz / point.w;
+}
+
+void main()
+{
+    // Full screen triangle generated from the vertex index, no vertex buffer needed
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+
+    nearPoint = unproject(position, -1.0);
+    farPoint = unproject(position, 1.0);
+    gl_Position = vec4(position, 0.0, 1.0);
+}